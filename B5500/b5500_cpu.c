@@ -2010,18 +2010,18 @@ sim_instr(void)
         }
 
         if (sim_brk_summ) {
-            if(sim_brk_test((C << 3) | L, SWMASK('E'))) {
+            if(SIM_BRK_TEST((C << 3) | L, SWMASK('E'))) {
                 reason = SCPE_STOP;
                 break;
             }
 
-            if (sim_brk_test((c_reg[0] << 3) | l_reg[0],
+            if (SIM_BRK_TEST((c_reg[0] << 3) | l_reg[0],
                          SWMASK('A'))) {
                 reason = SCPE_STOP;
                 break;
             }
 
-            if (sim_brk_test((c_reg[1] << 3) | l_reg[1],
+            if (SIM_BRK_TEST((c_reg[1] << 3) | l_reg[1],
                          SWMASK('B'))) {
                 reason = SCPE_STOP;
                 break;
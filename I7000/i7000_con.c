@@ -110,6 +110,7 @@ con_cmd(UNIT * uptr, uint16 cmd, uint16 dev)
         chan_set_sel(chan, 1);
         uptr->u5 |= URCSTA_WRITE;
         uptr->u3 = 0;
+        sim_activate_abs(uptr, 50);     /* Don't wait for keyboard poll */
         return SCPE_OK;
 
     /* Send record to CPU */
@@ -126,6 +127,7 @@ con_cmd(UNIT * uptr, uint16 cmd, uint16 dev)
         chan_set_sel(chan, 0);
         uptr->u5 |= URCSTA_READ;
         uptr->u3 = 0;
+        sim_activate_abs(uptr, 50);     /* Don't wait for keyboard poll */
         return SCPE_OK;
     }
     chan_set_attn(chan);
@@ -251,7 +253,8 @@ con_srv(UNIT *uptr) {
             }
         }
     }
-    sim_activate(uptr, 500);
+    /* Poll the keyboard with the clock so the CPU can idle */
+    sim_clock_coschedule(uptr, 500);
     return SCPE_OK;
 }
 
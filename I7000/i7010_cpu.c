@@ -180,7 +180,7 @@ DEBTAB              cpu_debug[] = {
 */
 
 UNIT                cpu_unit =
-    { UDATA(rtc_srv, MODEL(2)|MEMAMOUNT(9)|OPTION_PRIO|OPTION_FLOAT,
+    { UDATA(rtc_srv, UNIT_IDLE|MODEL(2)|MEMAMOUNT(9)|OPTION_PRIO|OPTION_FLOAT,
                  MAXMEMSIZE), 10000 };
 
 REG                 cpu_reg[] = {
@@ -230,6 +230,8 @@ MTAB                cpu_mod[] = {
           "No memory protection"},
     {OPTION_PROT, OPTION_PROT, "PROT", "PROT", NULL, NULL, NULL,
           "Memory Protection"},
+    {MTAB_XTD | MTAB_VDV, 0, "IDLE", "IDLE", &sim_set_idle, &sim_show_idle},
+    {MTAB_XTD | MTAB_VDV, 0, NULL, "NOIDLE", &sim_clr_idle, NULL},
     {MTAB_XTD | MTAB_VDV | MTAB_NMO | MTAB_SHP, 0, "HISTORY", "HISTORY",
      &cpu_set_hist, &cpu_show_hist},
     {0}
@@ -573,6 +575,7 @@ sim_instr(void)
     int                 cy;
     int                 i;
     int                 jump;           /* Do transfer to AAR after op */
+    int                 opaddr;         /* Address of current op */
     int                 instr_count = 0;/* Number of instructions to execute */
 
     if (sim_step != 0) {
@@ -609,7 +612,7 @@ sim_instr(void)
             }
         }
 
-        if (chwait == 0 && sim_brk_summ && sim_brk_test(IAR, SWMASK('E'))) {
+        if (chwait == 0 && SIM_BRK_TEST(IAR, SWMASK('E'))) {
             reason = STOP_IBKPT;
             break;
         }
@@ -624,6 +627,7 @@ sim_instr(void)
                 if (CPU_MODEL == 1)
                     hst[hst_p].ic |= HIST_1401;
             }
+            opaddr = IAR;
             op = FetchP(IAR++);
             /* Check if over the top */
             if (fault)
@@ -3331,6 +3335,9 @@ sim_instr(void)
 
             /* Do a jump to new location. */
             if (jump) {
+                /* B to itself waits on an indicator or interrupt */
+                if (op == OP_B && (AAR & AMASK) == opaddr && sim_interval > 0)
+                    sim_idle(TMR_RTC, 0);
                 BAR = IAR;      /* Save current for posterity */
                 IAR = AAR & AMASK;
             }
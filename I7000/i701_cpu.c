@@ -225,7 +225,7 @@ sim_instr(void)
             }
         }
 
-        if (iowait == 0 && sim_brk_summ && sim_brk_test(IC, SWMASK('E'))) {
+        if (iowait == 0 && SIM_BRK_TEST(IC, SWMASK('E'))) {
             reason = STOP_IBKPT;
             break;
         }
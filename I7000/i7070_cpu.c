@@ -143,7 +143,7 @@ struct InstHistory *hst = NULL;                 /* History stack */
 */
 
 UNIT                cpu_unit =
-    { UDATA(&rtc_srv, OPTION_FLOAT|MEMAMOUNT(1)|MODEL(0x0), 10000), 10  };
+    { UDATA(&rtc_srv, UNIT_IDLE|OPTION_FLOAT|MEMAMOUNT(1)|MODEL(0x0), 10000), 10  };
 
 REG                 cpu_reg[] = {
     {DRDATA(IC, IC, 20), REG_FIT},
@@ -174,6 +174,8 @@ MTAB                cpu_mod[] = {
     {OPTION_EXTEND, OPTION_EXTEND, "EXTEND", "EXTEND", NULL, NULL, NULL},
     {OPTION_TIMER, 0, NULL, "NOCLOCK", NULL, NULL, NULL},
     {OPTION_TIMER, OPTION_TIMER, "CLOCK", "CLOCK", NULL, NULL, NULL},
+    {MTAB_XTD | MTAB_VDV, 0, "IDLE", "IDLE", &sim_set_idle, &sim_show_idle},
+    {MTAB_XTD | MTAB_VDV, 0, NULL, "NOIDLE", &sim_clr_idle, NULL},
     {MTAB_XTD | MTAB_VDV | MTAB_NMO | MTAB_SHP, 0, "HISTORY", "HISTORY",
      &cpu_set_hist, &cpu_show_hist},
     {0}
@@ -328,7 +330,7 @@ sim_instr(void)
 
         /* Only check for break points during actual fetch */
         if (iowait == 0 && chwait == 0
-                        && sim_brk_summ && sim_brk_test(IC, SWMASK('E'))) {
+                        && SIM_BRK_TEST(IC, SWMASK('E'))) {
             reason = STOP_IBKPT;
             break;
         }
@@ -961,6 +963,9 @@ sim_instr(void)
                      upd_idx(&M[IX], IC);
                 /* Branch */
                 case OP_B:
+                     /* B * only ends on a priority interrupt */
+                     if (MA == IC - 1 && sim_interval > 0)
+                         sim_idle(TMR_RTC, 0);
                      IC = MA;
                      if (hst_lnt) {  /* history enabled? */
                          hst[hst_p].ic |= HIST_NOBEF|HIST_NOAFT;
@@ -80,6 +80,8 @@
 #define CPU_7053        0x2
 #define CPU_7080        0x3
 
+#define TMR_RTC         0       /* Idle against internal timer */
+
 #define HIST_XCT        1       /* instruction */
 #define HIST_INT        2       /* interrupt cycle */
 #define HIST_TRP        3       /* trap cycle */
@@ -242,7 +244,7 @@ extern UNIT         chan_unit[];
 */
 
 UNIT                cpu_unit =
-    { UDATA(NULL, MODEL(CPU_7053) | MEMAMOUNT(3) | NONSTOP, MAXMEMSIZE) };
+    { UDATA(NULL, UNIT_IDLE | MODEL(CPU_7053) | MEMAMOUNT(3) | NONSTOP, MAXMEMSIZE) };
 
 REG                 cpu_reg[] = {
     {DRDATAD(IC, IC, 32, "Instruction register")},
@@ -298,6 +300,8 @@ MTAB                cpu_mod[] = {
     {EMULATE3, EMULATE3, "EMU7053", "EMU7053", NULL, NULL, NULL},
     {NONSTOP, 0, "PROGRAM", "PROGRAM", NULL, NULL, NULL},
     {NONSTOP, NONSTOP, "NONSTOP", "NONSTOP", NULL, NULL, NULL},
+    {MTAB_XTD | MTAB_VDV, 0, "IDLE", "IDLE", &sim_set_idle, &sim_show_idle},
+    {MTAB_XTD | MTAB_VDV, 0, NULL, "NOIDLE", &sim_clr_idle, NULL},
     {MTAB_XTD | MTAB_VDV | MTAB_NMO | MTAB_SHP, 0, "HISTORY", "HISTORY",
      &cpu_set_hist, &cpu_show_hist},
     {0}
@@ -439,7 +443,7 @@ stop_cpu:
                 break;      /* process */
         }
 
-        if (sim_brk_summ && sim_brk_test(IC, SWMASK('E'))) {
+        if (SIM_BRK_TEST(IC, SWMASK('E'))) {
             reason = STOP_IBKPT;
             break;
         }
@@ -655,6 +659,9 @@ stop_cpu:
                         MA = MAC2+4;
                         write_addr(IC, 0, 0);
                         sim_interval -= 4;   /* count down */
+                     } else if (MAC == IC - 5 && sim_interval > 0) {
+                        /* TR * only ends on a channel interrupt */
+                        sim_idle(TMR_RTC, 0);
                      }
                      IC = MAC;
                      break;
@@ -300,10 +300,10 @@ extern uint32       drum_addr;
 
 UNIT                cpu_unit =
 #ifdef I7090
-    { UDATA(rtc_srv, UNIT_BINK | MODEL(CPU_7090) | MEMAMOUNT(4),
+    { UDATA(rtc_srv, UNIT_BINK | UNIT_IDLE | MODEL(CPU_7090) | MEMAMOUNT(4),
             MAXMEMSIZE/2 ), 120 };
 #else
-    { UDATA(rtc_srv, UNIT_BINK | MODEL(CPU_704) | MEMAMOUNT(4),
+    { UDATA(rtc_srv, UNIT_BINK | UNIT_IDLE | MODEL(CPU_704) | MEMAMOUNT(4),
             MAXMEMSIZE/2 ), 120 };
 #endif
 
@@ -384,6 +384,8 @@ MTAB                cpu_mod[] = {
     {UNIT_DUALCORE, 0, NULL, "STANDARD", NULL, NULL, NULL},
     {UNIT_DUALCORE, UNIT_DUALCORE, "CTSS", "CTSS", NULL, NULL, NULL, "CTSS support"},
 #endif
+    {MTAB_XTD | MTAB_VDV, 0, "IDLE", "IDLE", &sim_set_idle, &sim_show_idle},
+    {MTAB_XTD | MTAB_VDV, 0, NULL, "NOIDLE", &sim_clr_idle, NULL},
     {MTAB_XTD | MTAB_VDV | MTAB_NMO | MTAB_SHP, 0, "HISTORY", "HISTORY",
      &cpu_set_hist, &cpu_show_hist},
     {0}
@@ -802,8 +804,8 @@ sim_instr(void)
         }
 #endif
 
-        if (iowait == 0 && sim_brk_summ &&
-                 sim_brk_test(((bcore & 2)? CORE_B:0)|IC, SWMASK('E'))) {
+        if (iowait == 0 &&
+                 SIM_BRK_TEST(((bcore & 2)? CORE_B:0)|IC, SWMASK('E'))) {
             reason = STOP_IBKPT;
             break;
         }
@@ -926,7 +928,10 @@ sim_instr(void)
         if (hltinst) {
              t_uint64            mask = 00000001000001LL;
              /* Hold out until all channels have idled out */
-             sim_interval = sim_interval - 1;        /* count down */
+             if (sim_idle_enab)
+                 sim_idle(TMR_RTC, 1);
+             else
+                 sim_interval = sim_interval - 1;    /* count down */
              chan_proc();
              f = chan_active(0);
              for (shiftcnt = 1; f == 0 && shiftcnt < NUM_CHAN; shiftcnt++)  {
@@ -952,7 +957,10 @@ sim_instr(void)
         }
 #else                     /* Handle halt on 704 */
         if (hltinst) {
-             sim_interval = sim_interval - 1;        /* count down */
+             if (sim_idle_enab)
+                 sim_idle(TMR_RTC, 1);
+             else
+                 sim_interval = sim_interval - 1;    /* count down */
              chan_proc();
              if (chan_active(0))
                 goto hltloop;
@@ -1524,6 +1532,9 @@ prottrap:
                 break;
             case OP_TRA:
                 do_trapmode;
+                /* TRA * only ends on a trap, so idle */
+                if (MA == (IC - 1) && sim_interval > 0)
+                    sim_idle(TMR_RTC, 0);
                 do_transfer(MA);
                 break;
             case OP_TSX:
@@ -3525,8 +3536,12 @@ prottrap:
             case OP_TCOH:
                 f = chan_active((opcode & 017) + 1);
                 /* Check if TCOx * */
-                if ((cpu_unit.flags & UNIT_FASTIO) && f && MA == (IC - 1))
-                    iowait = 1;
+                if (f && MA == (IC - 1)) {
+                    if (cpu_unit.flags & UNIT_FASTIO)
+                        iowait = 1;
+                    else if (sim_interval > 0)
+                        sim_idle(TMR_RTC, 0);
+                }
                 goto branch;
             case OP_TCNA:       /* Transfer on channel not in operation */
             case OP_TCNB:
@@ -4415,6 +4430,8 @@ fprintf (st, "all outstanding I/O requests when it detects an IDLE loop. This is
 fprintf (st, "by a TCOx to itself. TRUEIO waits until the given timeout. ");
 fprintf (st, "For faster\noperation FASTIO can speed up execution, by eliminating");
 fprintf (st, "waits on devices.\nThe default is TRUEIO.\n\n");
+fprintf (st, "With TRUEIO, SET CPU IDLE lets the host sleep while the CPU sits in\n");
+fprintf (st, "a TCOx or TRA to itself, or in a HTR waiting for channels to finish.\n\n");
 fprintf (st, "For the IBM 709x the following options can be enabled\n\n");
 fprintf (st, "   sim> SET CPU EFP      enables extended Floating Point\n");
 fprintf (st, "   sim> SET CPU NOEFP    disables extended Floating Point\n\n");
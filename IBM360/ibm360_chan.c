@@ -98,6 +98,37 @@ uint8       chan_pend[CHAN_SZ];             /* Pending status on this channel */
 DIB         *dev_unit[MAX_DEV];             /* Pointer to Device info block */
 uint8       dev_status[MAX_DEV];            /* last device status flags */
 
+/* Summary of where scan_chan needs to look.  A bit is set whenever a
+ * subchannel posts channel end or PCI, or a device posts attention
+ * status, and is only cleared by scan_chan once the condition is gone.
+ * The maps may over report, but never miss anything pending. */
+#define PEND_WORDS(n)   (((n) + 31) / 32)
+uint32      chan_irq_map[PEND_WORDS(CHAN_SZ)];  /* Subchannels with status */
+uint32      dev_irq_map[PEND_WORDS(MAX_DEV)];   /* Devices with dev_status */
+
+#define SET_PEND(map, n)   map[(n) >> 5] |= (1u << ((n) & 0x1f))
+#define CLR_PEND(map, n)   map[(n) >> 5] &= ~(1u << ((n) & 0x1f))
+#define TST_PEND(map, n)   ((map[(n) >> 5] & (1u << ((n) & 0x1f))) != 0)
+
+/* Return next bit set in map at or after n, or lim if none */
+static int
+next_pend(uint32 *map, int n, int lim) {
+    while (n < lim) {
+        uint32  w = map[n >> 5] >> (n & 0x1f);
+
+        if (w == 0) {
+            n = (n | 0x1f) + 1;
+            continue;
+        }
+        while ((w & 1) == 0) {
+            w >>= 1;
+            n++;
+        }
+        return (n < lim) ? n : lim;
+    }
+    return lim;
+}
+
 /* Find unit pointer for given device */
 UNIT         *
 find_chan_dev(uint16 addr) {
@@ -372,6 +403,7 @@ loop:
              return 1;
          chan_status[chan] &= 0xff;
          chan_status[chan] |= dibp->start_cmd(uptr, chan, ccw_cmd[chan]) << 8;
+         SET_PEND(chan_irq_map, chan);
          if (chan_status[chan] & (STATUS_ATTN|STATUS_CHECK|STATUS_EXPT)) {
              chan_status[chan] |= STATUS_CEND;
              ccw_flags[chan] = 0;
@@ -389,6 +421,7 @@ loop:
     if (ccw_flags[chan] & FLAG_PCI) {
         chan_status[chan] |= STATUS_PCI;
         ccw_flags[chan] &= ~FLAG_PCI;
+        SET_PEND(chan_irq_map, chan);
         irq_pend = 1;
         sim_debug(DEBUG_CMD, &cpu_dev, "Set PCI %02x\n", chan);
     }
@@ -420,6 +453,7 @@ chan_read_byte(uint16 addr, uint8 *data) {
           */
          if ((ccw_flags[chan] & FLAG_CD) == 0) {
             chan_status[chan] |= STATUS_CEND;
+            SET_PEND(chan_irq_map, chan);
             chan_byte[chan] = BUFF_CHNEND;
             sim_debug(DEBUG_DETAIL, &cpu_dev, "chan_read_end\n");
             return 1;
@@ -543,8 +577,10 @@ set_devattn(uint16 addr, uint8 flags) {
     if (chan_dev[chan] == addr && (chan_status[chan] & STATUS_CEND) != 0 &&
             (flags & SNS_DEVEND) != 0) {
         chan_status[chan] |= ((uint16)flags) << 8;
+        SET_PEND(chan_irq_map, chan);
     } else {
         dev_status[addr] = flags;
+        SET_PEND(dev_irq_map, addr);
         chan_pend[chan] = 1;
     }
     sim_debug(DEBUG_EXP, &cpu_dev, "set_devattn(%x, %x) %x\n",
@@ -567,6 +603,7 @@ chan_end(uint16 addr, uint8 flags) {
     if (ccw_flags[chan] & FLAG_PCI) {
         chan_status[chan] |= STATUS_PCI;
         ccw_flags[chan] &= ~FLAG_PCI;
+        SET_PEND(chan_irq_map, chan);
         irq_pend = 1;
     }
     /* Flush buffer if there was any change */
@@ -577,6 +614,7 @@ chan_end(uint16 addr, uint8 flags) {
     }
     chan_status[chan] |= STATUS_CEND;
     chan_status[chan] |= ((uint16)flags) << 8;
+    SET_PEND(chan_irq_map, chan);
     ccw_cmd[chan] = 0;
 
     /* If count not zero and not suppressing length, report error */
@@ -782,7 +820,8 @@ int testio(uint16 addr) {
         int pend, ch;
         chan_pend[chan] = 0;
         /* Check if might be false */
-        for (pend = 0; pend < MAX_DEV; pend++) {
+        for (pend = next_pend(dev_irq_map, 0, MAX_DEV); pend < MAX_DEV;
+             pend = next_pend(dev_irq_map, pend + 1, MAX_DEV)) {
             if (dev_status[pend] != 0) {
                 ch = find_subchan(pend);
                 if (ch == chan) {
@@ -922,6 +961,7 @@ t_stat chan_boot(uint16 addr, DEVICE *dptyr) {
     ccw_cmd[chan] = 0x2;
     chan_status[chan] &= 0xff;
     chan_status[chan] |= dibp->start_cmd(uptr, chan, ccw_cmd[chan]) << 8;
+    SET_PEND(chan_irq_map, chan);
     if (chan_status[chan] & (STATUS_ATTN|STATUS_CHECK|STATUS_EXPT)) {
         ccw_flags[chan] = 0;
         return SCPE_IOERR;
@@ -945,8 +985,13 @@ scan_chan(uint16 mask, int irq_en) {
      if (irq_pend == 0)
          return 0;
      irq_pend = 0;
-     /* Start with channel 0 and work through all channels */
-     for (i = 0; i < CHAN_SZ; i++) {
+     /* Start with channel 0 and work through all channels with status */
+     for (i = next_pend(chan_irq_map, 0, CHAN_SZ); i < CHAN_SZ;
+          i = next_pend(chan_irq_map, i + 1, CHAN_SZ)) {
+         if ((chan_status[i] & (STATUS_PCI|STATUS_CEND)) == 0) {
+             CLR_PEND(chan_irq_map, i);
+             continue;
+         }
          /* Check if PCI pending */
          if (irq_en && (chan_status[i] & STATUS_PCI) != 0) {
              imask = 0x8000 >> find_chan(i);
@@ -999,8 +1044,11 @@ scan_chan(uint16 mask, int irq_en) {
      } else {
           if (!irq_en)
              return 0;
-          for (pend = 0; pend < MAX_DEV; pend++) {
-             if (dev_status[pend] != 0) {
+          for (pend = next_pend(dev_irq_map, 0, MAX_DEV); pend < MAX_DEV;
+               pend = next_pend(dev_irq_map, pend + 1, MAX_DEV)) {
+             if (dev_status[pend] == 0) {
+                 CLR_PEND(dev_irq_map, pend);
+             } else {
                  ch = find_subchan(pend);
                  if (ch >= 0 && ccw_cmd[ch] == 0 &&
                         (mask & (0x8000 >> (pend >> 8))) != 0) {
@@ -438,7 +438,7 @@ t_stat com_scan(UNIT * uptr)
     UNIT      *line;
     int32      ln;
 
-    sim_activate(uptr, tmxr_poll);          /* continue poll */
+    sim_clock_coschedule(uptr, tmxr_poll);   /* continue poll */
     if ((uptr->flags & UNIT_ATT) == 0)              /* attached? */
         return SCPE_OK;
     ln = tmxr_poll_conn (&com_desc);                 /* look for connect */
@@ -468,7 +468,7 @@ t_stat com_scan(UNIT * uptr)
 t_stat
 com_reset(DEVICE * dptr)
 {
-    sim_activate(&com_unit[0], tmxr_poll);
+    sim_clock_coschedule(&com_unit[0], tmxr_poll);
     return SCPE_OK;
 }
 
@@ -492,7 +492,7 @@ com_attach(UNIT * uptr, CONST char *cptr)
 //        (void)tmxr_reset_ln(&com_ldsc[i]);
         coml_unit[i].u3 &= ~0xffff;
     }
-    sim_activate(uptr, tmxr_poll);
+    sim_clock_coschedule(uptr, tmxr_poll);
     return SCPE_OK;
 }
 
@@ -151,6 +151,7 @@ uint8  con_startcmd(UNIT *uptr, uint16 chan,  uint8 cmd) {
          }
          uptr->u3 |= cmd & CON_MSK;
          uptr->u5 = 0;
+         sim_activate_abs(uptr, 500);  /* Don't wait for keyboard poll */
          if (uptr->u3 & CON_CR) {
             sim_putchar('R');
             sim_putchar(' ');
@@ -171,6 +172,7 @@ uint8  con_startcmd(UNIT *uptr, uint16 chan,  uint8 cmd) {
 
     case 4:              /* Sense */
          uptr->u3 |= cmd & CON_MSK;
+         sim_activate_abs(uptr, 500);  /* Don't wait for keyboard poll */
          return 0;
 
     default:              /* invalid command */
@@ -331,7 +333,13 @@ con_srv(UNIT *uptr) {
           set_devattn(addr, SNS_ATTN);
           uptr->u3 &= ~CON_REQ;
     }
-    sim_activate(uptr, 500);
+    /* Only poll keyboard on clock ticks while waiting for the operator,
+       this lets the CPU idle */
+    cmd = uptr->u3 & CON_MSK;
+    if (cmd == 0 || (cmd == CON_RD && (uptr->u3 & CON_INPUT) == 0))
+        sim_clock_coschedule(uptr, 1000);
+    else
+        sim_activate(uptr, 500);
     return SCPE_OK;
 }
 
@@ -225,7 +225,7 @@ int32               rtc_tps = 300;
    cpu_mod      CPU modifier list
 */
 
-UNIT cpu_unit[] = { { UDATA (&rtc_srv, UNIT_BINK|UNIT_FIX, MAXMEMSIZE)} };
+UNIT cpu_unit[] = { { UDATA (&rtc_srv, UNIT_BINK|UNIT_FIX|UNIT_IDLE, MAXMEMSIZE), 10000} };
 
 REG cpu_reg[] = {
     { HRDATA (PC, PC, 24) },
@@ -746,6 +746,222 @@ int WriteHalf(uint32 addr, uint32 data) {
      return 0;
 }
 
+/*
+ * Bulk storage access for the SS instructions. Address translation
+ * and the storage key check are done once per 2K block, after which
+ * the bytes in the block are accessed directly in M[].
+ */
+#define BLK_RD      1              /* Check fetch protection */
+#define BLK_WR      2              /* Check store protection */
+#define BLK_SIZE    0x800          /* Size of storage key block */
+#define BLK_NONE    0xffffffff     /* No block cached */
+
+/* Cached block for an operand accessed one byte at a time */
+typedef struct {
+     uint32     blk;               /* Virtual address of block */
+     uint32     pa;                /* Physical address of block */
+} BLKREF;
+
+/*
+ * Translate addr and check access to its block. Return 1 if failure,
+ * 0 if success with the physical address in pa.
+ */
+int  BlockAddr(uint32 addr, int mode, uint32 *pa) {
+     uint8      k;
+
+     if (TransAddr(addr, pa))
+         return 1;
+
+     if (*pa >= MEMSIZE) {
+         storepsw(OPPSW, IRC_ADDR);
+         return 1;
+     }
+
+     /* Check storage key */
+     if (st_key != 0) {
+         if ((cpu_unit[0].flags & FEAT_PROT) == 0) {
+             storepsw(OPPSW, IRC_PROT);
+             return 1;
+         }
+         k = key[*pa >> 11];
+         if ((mode & BLK_RD) != 0 && (k & 0x8) != 0 && (k & 0xf0) != st_key) {
+             storepsw(OPPSW, IRC_PROT);
+             return 1;
+         }
+         if ((mode & BLK_WR) != 0 && (k & 0xf0) != st_key) {
+             storepsw(OPPSW, IRC_PROT);
+             return 1;
+         }
+     }
+     return 0;
+}
+
+int  BlockRead(BLKREF *ref, uint32 addr, uint32 *data) {
+     uint32     pa;
+
+     addr &= AMASK;
+     if ((addr & ~(BLK_SIZE - 1)) != ref->blk) {
+         if (BlockAddr(addr, BLK_RD, &pa))
+             return 1;
+         ref->blk = addr & ~(BLK_SIZE - 1);
+         ref->pa = pa & ~(BLK_SIZE - 1);
+     }
+     pa = ref->pa | (addr & (BLK_SIZE - 1));
+     *data = (M[pa >> 2] >> (8 * (3 - (pa & 0x3)))) & 0xff;
+     return 0;
+}
+
+int  BlockWrite(BLKREF *ref, uint32 addr, uint32 data) {
+     uint32     pa;
+     int        offset;
+
+     addr &= AMASK;
+     if ((addr & ~(BLK_SIZE - 1)) != ref->blk) {
+         if (BlockAddr(addr, BLK_WR, &pa))
+             return 1;
+         ref->blk = addr & ~(BLK_SIZE - 1);
+         ref->pa = pa & ~(BLK_SIZE - 1);
+     }
+     pa = ref->pa | (addr & (BLK_SIZE - 1));
+     offset = 8 * (3 - (pa & 0x3));
+     M[pa >> 2] &= ~(0xffu << offset);
+     M[pa >> 2] |= (data & 0xff) << offset;
+     return 0;
+}
+
+/*
+ * Do MVC, MVN, MVZ, NC, OC or XC over cnt bytes. Bytes are processed
+ * strictly left to right, a word at a time when both operands are word
+ * aligned. Since the operands then differ by a multiple of a word, a
+ * destructive overlap gives the same result as a byte at a time.
+ * Return 1 if failure.
+ */
+int  BlockMove(uint8 op, uint32 addr1, uint32 addr2, int cnt) {
+     uint32     pa1, pa2;
+     uint32     n1 = 0, n2 = 0;
+     uint32     n;
+     uint32     s, d;
+     int        offset;
+
+     while (cnt > 0) {
+         if (n2 == 0) {
+             addr2 &= AMASK;
+             if (BlockAddr(addr2, BLK_RD, &pa2))
+                 return 1;
+             n2 = BLK_SIZE - (pa2 & (BLK_SIZE - 1));
+         }
+         if (n1 == 0) {
+             addr1 &= AMASK;
+             if (BlockAddr(addr1, (op == OP_MVC) ? BLK_WR : (BLK_RD|BLK_WR), &pa1))
+                 return 1;
+             n1 = BLK_SIZE - (pa1 & (BLK_SIZE - 1));
+         }
+         n = (n1 < n2) ? n1 : n2;
+         if ((uint32)cnt < n)
+             n = cnt;
+         addr1 += n;
+         addr2 += n;
+         n1 -= n;
+         n2 -= n;
+         cnt -= n;
+
+         /* Straight copy that can not see its own stores */
+         if (op == OP_MVC && ((pa1 | pa2) & 0x3) == 0 && n >= 4 &&
+                  (pa1 <= pa2 || pa1 >= pa2 + n)) {
+             memmove(&M[pa1 >> 2], &M[pa2 >> 2], (n & ~0x3));
+             pa1 += n & ~0x3;
+             pa2 += n & ~0x3;
+             n &= 0x3;
+         }
+         while (n != 0) {
+             if (((pa1 | pa2) & 0x3) == 0 && n >= 4) {
+                 s = M[pa2 >> 2];
+                 d = M[pa1 >> 2];
+                 offset = 4;
+             } else {
+                 offset = 8 * (3 - (pa1 & 0x3));
+                 s = ((M[pa2 >> 2] >> (8 * (3 - (pa2 & 0x3)))) & 0xff) << offset;
+                 d = M[pa1 >> 2] & (0xffu << offset);
+             }
+             switch(op) {
+             case OP_MVC: d = s; break;
+             case OP_MVZ: d = (d & 0x0f0f0f0f) | (s & 0xf0f0f0f0); break;
+             case OP_MVN: d = (d & 0xf0f0f0f0) | (s & 0x0f0f0f0f); break;
+             case OP_NC:  d &= s; if (d != 0) cc = 1;  break;
+             case OP_OC:  d |= s; if (d != 0) cc = 1;  break;
+             case OP_XC:  d ^= s; if (d != 0) cc = 1;  break;
+             }
+             if (offset == 4) {
+                 M[pa1 >> 2] = d;
+             } else {
+                 d &= 0xffu << offset;
+                 M[pa1 >> 2] = (M[pa1 >> 2] & ~(0xffu << offset)) | d;
+                 offset = 1;
+             }
+             pa1 += offset;
+             pa2 += offset;
+             n -= offset;
+         }
+     }
+     return 0;
+}
+
+/*
+ * Compare cnt bytes for CLC, a word at a time when both operands are
+ * word aligned. Return 1 if failure.
+ */
+int  BlockCompare(uint32 addr1, uint32 addr2, int cnt) {
+     uint32     pa1, pa2;
+     uint32     n1 = 0, n2 = 0;
+     uint32     n;
+     uint32     s1, s2;
+
+     cc = 0;
+     while (cnt > 0) {
+         if (n1 == 0) {
+             addr1 &= AMASK;
+             if (BlockAddr(addr1, BLK_RD, &pa1))
+                 return 1;
+             n1 = BLK_SIZE - (pa1 & (BLK_SIZE - 1));
+         }
+         if (n2 == 0) {
+             addr2 &= AMASK;
+             if (BlockAddr(addr2, BLK_RD, &pa2))
+                 return 1;
+             n2 = BLK_SIZE - (pa2 & (BLK_SIZE - 1));
+         }
+         n = (n1 < n2) ? n1 : n2;
+         if ((uint32)cnt < n)
+             n = cnt;
+         addr1 += n;
+         addr2 += n;
+         n1 -= n;
+         n2 -= n;
+         cnt -= n;
+
+         while (n != 0) {
+             if (((pa1 | pa2) & 0x3) == 0 && n >= 4) {
+                 s1 = M[pa1 >> 2];
+                 s2 = M[pa2 >> 2];
+                 pa1 += 4;
+                 pa2 += 4;
+                 n -= 4;
+             } else {
+                 s1 = (M[pa1 >> 2] >> (8 * (3 - (pa1 & 0x3)))) & 0xff;
+                 s2 = (M[pa2 >> 2] >> (8 * (3 - (pa2 & 0x3)))) & 0xff;
+                 pa1++;
+                 pa2++;
+                 n--;
+             }
+             /* Words hold bytes high to low, so compare as unsigned */
+             if (s1 != s2) {
+                 cc = (s1 < s2) ? 1 : 2;
+                 return 0;
+             }
+         }
+     }
+     return 0;
+}
 
 
 t_stat
@@ -775,6 +991,7 @@ sim_instr(void)
     t_uint64        destL;
 #endif
     uint16          ops[3];
+    BLKREF          ref1, ref2, ref3;
 //double    a, b, c;
 
     reason = SCPE_OK;
@@ -832,11 +1049,15 @@ wait_loop:
             /* CPU IDLE */
             if (flags & WAIT && irq_en == 0 && ext_en == 0)
                return STOP_HALT;
-            sim_interval--;
+            /* Give host time back until next event */
+            if (sim_idle_enab && (flags & WAIT) != 0)
+               sim_idle(TMR_RTC, 1);
+            else
+               sim_interval--;
             goto wait_loop;
         }
 
-        if (sim_brk_summ && sim_brk_test(PC, SWMASK('E'))) {
+        if (SIM_BRK_TEST(PC, SWMASK('E'))) {
            return STOP_IBKPT;
         }
 
@@ -1863,55 +2084,21 @@ save_dbl:
         case OP_MVN:
         case OP_MVZ:
         case OP_MVC:
-                do {
-                   if (ReadByte(addr2, &src1))
-                       break;
-                   if (op != OP_MVC) {
-                       if (ReadByte(addr1, &dest))
-                           break;
-                       switch(op) {
-                       case OP_MVZ: dest = (dest & 0x0f) | (src1 & 0xf0); break;
-                       case OP_MVN: dest = (dest & 0xf0) | (src1 & 0x0f); break;
-                       case OP_NC:  dest &= src1; if (dest != 0) cc = 1;  break;
-                       case OP_OC:  dest |= src1; if (dest != 0) cc = 1;  break;
-                       case OP_XC:  dest ^= src1; if (dest != 0) cc = 1;  break;
-                       }
-                   } else {
-                       dest = src1;
-                   }
-                   if (WriteByte(addr1, dest))
-                       break;
-                   addr1++;
-                   addr2++;
-                   reg--;
-                } while (reg != 0xff);
+                (void)BlockMove(op, addr1, addr2, reg + 1);
                 break;
 
         case OP_CLC:
-                cc = 0;
-                do {
-                    if (ReadByte(addr1, &src1))
-                       break;
-                    if (ReadByte(addr2, &src2))
-                       break;
-                    if (src1 != src2) {
-                       dest = src1 - src2;
-                       cc = (dest & MSIGN) ? 1 : (dest == 0) ? 0 : 2;
-                       break;
-                    }
-                    addr1++;
-                    addr2++;
-                    reg--;
-                } while(reg != 0xff);
+                (void)BlockCompare(addr1, addr2, reg + 1);
                 break;
 
         case OP_TR:
+                ref1.blk = ref2.blk = ref3.blk = BLK_NONE;
                 do {
-                   if (ReadByte(addr1, &src1))
+                   if (BlockRead(&ref1, addr1, &src1))
                        break;
-                   if (ReadByte(addr2 + (src1 & 0xff), &dest))
+                   if (BlockRead(&ref2, addr2 + (src1 & 0xff), &dest))
                        break;
-                   if (WriteByte(addr1, dest))
+                   if (BlockWrite(&ref3, addr1, dest))
                        break;
                    addr1++;
                    reg--;
@@ -1920,10 +2107,11 @@ save_dbl:
 
         case OP_TRT:
                 cc = 0;
+                ref1.blk = ref2.blk = BLK_NONE;
                 do {
-                   if (ReadByte(addr1, &src1))
+                   if (BlockRead(&ref1, addr1, &src1))
                        break;
-                   if (ReadByte(addr2 + (src1 & 0xff), &dest))
+                   if (BlockRead(&ref2, addr2 + (src1 & 0xff), &dest))
                        break;
                    if (dest != 0) {
                        regs[1] &= 0xff000000;
@@ -1942,36 +2130,37 @@ save_dbl:
                 reg &= 0xf;
                 addr2 += reg;
                 addr1 += reg1;
+                ref1.blk = ref2.blk = BLK_NONE;
                 /* Flip first location */
-                if (ReadByte(addr2, &dest))
+                if (BlockRead(&ref2, addr2, &dest))
                     break;
                 dest = ((dest >> 4) & 0xf) | ((dest << 4) & 0xf0);
-                if (WriteByte(addr1, dest))
+                if (BlockWrite(&ref1, addr1, dest))
                     break;
                 addr1--;
                 addr2--;
                 dest = 0;
                 while(reg != 0 && reg1 != 0) {
-                     if (ReadByte(addr2, &dest))
+                     if (BlockRead(&ref2, addr2, &dest))
                          goto supress;
                      dest &= 0xf;
                      addr2--;
                      reg--;
                      if (reg != 0) {
-                         if (ReadByte(addr2, &src1))
+                         if (BlockRead(&ref2, addr2, &src1))
                              goto supress;
                          dest |= (src1 << 4) & 0xf0;
                          addr2--;
                          reg--;
                      }
-                     if (WriteByte(addr1, dest))
+                     if (BlockWrite(&ref1, addr1, dest))
                          goto supress;
                      addr1--;
                      reg1--;
                 };
                 dest = 0;
                 while(reg1 != 0) {
-                     if (WriteByte(addr1, dest))
+                     if (BlockWrite(&ref1, addr1, dest))
                          break;
                      addr1--;
                      reg1--;
@@ -1982,34 +2171,35 @@ save_dbl:
                 reg &= 0xf;
                 addr2 += reg;
                 addr1 += reg1;
-                if (ReadByte(addr2, &dest))
+                ref1.blk = ref2.blk = BLK_NONE;
+                if (BlockRead(&ref2, addr2, &dest))
                     break;
                 dest = ((dest >> 4) & 0xf) | ((dest << 4) & 0xf0);
-                if (WriteByte(addr1, dest))
+                if (BlockWrite(&ref1, addr1, dest))
                     break;
                 addr1--;
                 addr2--;
                 zone = (flags & ASCII)? 0x50 : 0xf0;
                 while(reg != 0 && reg1 != 0) {
-                    if (ReadByte(addr2, &dest))
+                    if (BlockRead(&ref2, addr2, &dest))
                         goto supress;
                     addr2--;
                     reg--;
                     src1 = (dest & 0xf) | zone;
-                    if (WriteByte(addr1, src1))
+                    if (BlockWrite(&ref1, addr1, src1))
                         goto supress;
                     addr1--;
                     reg1--;
                     if (reg1 != 0) {
                         src1 = ((dest >> 4) & 0xf) | zone;
-                        if (WriteByte(addr1, src1))
+                        if (BlockWrite(&ref1, addr1, src1))
                             goto supress;
                         addr1--;
                         reg1--;
                     }
                 };
                 while(reg1 != 0) {
-                    if (WriteByte(addr1, zone))
+                    if (BlockWrite(&ref1, addr1, zone))
                         break;
                     addr1--;
                     reg1--;
@@ -4474,6 +4664,7 @@ t_stat cpu_reset (DEVICE *dptr)
             return SCPE_MEM;
     }
     cregs[4] = 0xff;
+    sim_rtcn_init_unit (&cpu_unit[0], cpu_unit[0].wait, TMR_RTC);
     return SCPE_OK;
 }
 
@@ -55,9 +55,37 @@
 
    Last record has cyl and head = 0xffffffff
 
+   Compressed disks use Devid = "CKD_C360" and the same first header,
+   followed by:
+
+       uint32   numl1           number of L1 table entries
+       uint32   size            size of file in use
+       uint32   free            offset of first free block, 0 if none
+       uint32   free_total      number of bytes in free blocks
+       uint8    compress        compression used for new tracks
+       uint8    resv[495]       pad to 512 byte block
+
+       uint32   l1[numl1]       offset of L2 table for each 256 tracks
+
+   Each L2 table has 256 entries of:
+       uint32   pos             offset of track image, 0 if not written
+       uint16   len             length of track image
+       uint16   size            space allocated to track image
+
+   A track image is one byte of compression type followed by the track
+   with trailing zeros removed. Tracks without an image read as freshly
+   formatted. Free blocks start with the offset of the next free block
+   and their own length. The free chain is only written on detach; while
+   attached free is 0. The header is rewritten each time size grows, before
+   any L1 or L2 entry points past the old end, so a crash only loses the
+   free space.
+
 */
 
 #include "ibm360_defs.h"
+#if defined(HAVE_ZLIB)
+#include <zlib.h>
+#endif
 
 #ifdef NUM_DEVS_DASD
 #define UNIT_V_TYPE        (UNIT_V_UF + 0)
@@ -191,6 +219,8 @@ struct dasd_t
      uint8              filemsk; /* Current file mask */
      uint8              rec;     /* Current record number */
      uint16             count;   /* Remaining in current operation */
+     struct dasd_cache *cent;    /* Cache entry holding cylinder */
+     struct dasd_cckd  *cckd;    /* Compressed image state, or NULL */
 };
 
 struct disk_t
@@ -234,6 +264,71 @@ struct dasd_header
        uint8    resv[492];     /* pad to 512 byte block */
 };
 
+#define DASD_CCKD_ID       "CKD_C360"
+#define DASD_L2_TRKS       256        /* Tracks per L2 table */
+#define DASD_COMP_NONE     0          /* Track stored as is */
+#define DASD_COMP_ZLIB     1          /* Track compressed with zlib */
+
+/* Compressed image header, follows dasd_header */
+struct dasd_cckd_header
+{
+       uint32   numl1;         /* Number of L1 table entries */
+       uint32   size;          /* Size of file in use */
+       uint32   free;          /* First free block, 0 if none */
+       uint32   free_total;    /* Bytes in free blocks */
+       uint8    compress;      /* Compression for new tracks */
+       uint8    resv[495];     /* pad to 512 byte block */
+};
+
+/* L2 table entry */
+struct dasd_l2
+{
+       uint32   pos;           /* Offset of track image, 0 if none */
+       uint16   len;           /* Length of track image */
+       uint16   size;          /* Space allocated to track image */
+};
+
+/* Free space block */
+struct dasd_free
+{
+       uint32   pos;           /* Offset of block */
+       uint32   len;           /* Length of block */
+};
+
+/* Compressed image state, pointed to by dasd_t */
+struct dasd_cckd
+{
+     struct dasd_cckd_header hdr;
+     uint32            *l1;      /* L1 table */
+     struct dasd_l2   **l2;      /* L2 tables read so far */
+     struct dasd_free  *free;    /* Free blocks sorted by offset */
+     int                nfree;   /* Number of free blocks */
+     int                mfree;   /* Size of free array */
+     uint8             *tbuf;    /* Track image buffer */
+     uint8             *nbuf;    /* Empty track buffer */
+     int                valid;   /* Image accepted, close may update it */
+};
+
+/* Cylinders are kept in a cache shared by all drives. The cylinder each
+   drive is on stays in the cache, the rest are reused least recently
+   used first. Only modified tracks are written back, when the cylinder
+   is reused, when the simulator stops and on detach. */
+#define DASD_CACHE_CYL     (NUM_DEVS_DASD * NUM_UNITS_DASD + 32)
+#define DASD_MAX_HEADS     256
+
+struct dasd_cache
+{
+     UNIT              *uptr;    /* Drive owning cylinder, NULL if empty */
+     uint16             cyl;     /* Cylinder held */
+     uint32             lru;     /* Time of last use */
+     uint8             *cbuf;    /* Cylinder data */
+     uint32             size;    /* Size of cbuf */
+     uint32             dirty[DASD_MAX_HEADS / 32]; /* Modified tracks */
+};
+
+struct dasd_cache   dasd_cache[DASD_CACHE_CYL];
+uint32              dasd_cache_clock;
+
 uint8               dasd_startio(UNIT *uptr, uint16 chan) ;
 uint8               dasd_startcmd(UNIT *uptr, uint16 chan,  uint8 cmd) ;
 uint8               dasd_haltio(uint16 addr);
@@ -243,6 +338,9 @@ void                dasd_ini(UNIT *, t_bool);
 t_stat              dasd_reset(DEVICE *);
 t_stat              dasd_attach(UNIT *, CONST char *);
 t_stat              dasd_detach(UNIT *);
+void                dasd_flush(UNIT *);
+t_stat              dasd_load_cyl(UNIT *, int);
+void                dasd_set_dirty(UNIT *, struct dasd_t *);
 t_stat              dasd_boot(int32, DEVICE *);
 t_stat              dasd_set_type(UNIT * uptr, int32 val, CONST char *cptr,
                                  void *desc);
@@ -539,17 +637,13 @@ t_stat dasd_srv(UNIT * uptr)
 
     /* Check if read or write command, if so grab correct cylinder */
     if (rd && data->cyl != data->ccyl) {
-        uint32 tsize = data->tsize * disk_type[type].heads;
-        if (uptr->u3 & DK_CYL_DIRTY) {
-              (void)sim_fseek(uptr->fileref, data->cpos, SEEK_SET);
-              (void)sim_fwrite(data->cbuf, 1, tsize, uptr->fileref);
-              uptr->u3 &= ~DK_CYL_DIRTY;
-        }
-        data->ccyl = data->cyl;
         sim_debug(DEBUG_DETAIL, dptr, "Load unit=%d cyl=%d\n", unit, data->cyl);
-        data->cpos = sizeof(struct dasd_header) + (data->ccyl * tsize);
-        (void)sim_fseek(uptr->fileref, data->cpos, SEEK_SET);
-        (void)sim_fread(data->cbuf, 1, tsize, uptr->fileref);
+        if (dasd_load_cyl(uptr, data->cyl) != SCPE_OK) {
+            uptr->u5 = SNS_EQUCHK;
+            uptr->u3 &= ~0xff;
+            chan_end(addr, SNS_CHNEND|SNS_DEVEND|SNS_UNITCHK);
+            return SCPE_OK;
+        }
     }
     sim_debug(DEBUG_POS, dptr, "state unit=%d %02x %d\n", unit, state, data->tpos);
 
@@ -1339,7 +1433,7 @@ rd:
                  ch = 0;
              }
              *da = ch;
-             uptr->u3 |= DK_CYL_DIRTY;
+             dasd_set_dirty(uptr, data);
              if (count == 4) {
                   uptr->u6 = cmd;
                   uptr->u3 &= ~(0xff|DK_PARAM);
@@ -1507,7 +1601,7 @@ wrckd:
              sim_debug(DEBUG_DATA, dptr, "Char %02x, %02x %d %d\n", ch, state,
                    count, data->tpos);
              *da = ch;
-             uptr->u3 |= DK_CYL_DIRTY;
+             dasd_set_dirty(uptr, data);
              if (state == DK_POS_CNT && count == 7) {
                  data->klen = rec[5];
                  data->dlen = (rec[6] << 8) | rec[7];
@@ -1547,7 +1641,7 @@ wrckd:
 
                  uptr->u6 = cmd;
                  uptr->u3 &= ~(0xff|DK_PARAM|DK_INDEX|DK_INDEX2);
-                 uptr->u3 |= DK_CYL_DIRTY;
+                 dasd_set_dirty(uptr, data);
                  chan_end(addr, SNS_CHNEND|SNS_DEVEND);
              } else {
                  uptr->u5 |= SNS_CMDREJ | (SNS_INVSEQ << 8);
@@ -1600,20 +1694,487 @@ dasd_reset(DEVICE * dptr)
     return SCPE_OK;
 }
 
+/* Build an empty track: home address, R0 and an end of file R1 */
+void
+dasd_init_track(uint8 *buf, int cyl, int hd, int tsize)
+{
+    int                 pos = 0;
+
+    memset(buf, 0, tsize);
+    buf[pos++] = 0;            /* HA */
+    buf[pos++] = (cyl >> 8);
+    buf[pos++] = (cyl & 0xff);
+    buf[pos++] = (hd >> 8);
+    buf[pos++] = (hd & 0xff);
+    buf[pos++] = (cyl >> 8);   /* R0 */
+    buf[pos++] = (cyl & 0xff);
+    buf[pos++] = (hd >> 8);
+    buf[pos++] = (hd & 0xff);
+    buf[pos++] = 0;              /* Rec */
+    buf[pos++] = 0;              /* keylen */
+    buf[pos++] = 0;              /* dlen */
+    buf[pos++] = 8;              /*  */
+    pos += 8;
+    buf[pos++] = (cyl >> 8);   /* R1 */
+    buf[pos++] = (cyl & 0xff);
+    buf[pos++] = (hd >> 8);
+    buf[pos++] = (hd & 0xff);
+    buf[pos++] = 1;              /* Rec */
+    buf[pos++] = 0;              /* keylen */
+    buf[pos++] = 0;              /* dlen */
+    buf[pos++] = 0;              /*  */
+    buf[pos++] = 0xff;           /* End record */
+    buf[pos++] = 0xff;
+    buf[pos++] = 0xff;
+    buf[pos++] = 0xff;
+}
+
+/* Allocate len bytes of space in compressed image */
+uint32
+dasd_cckd_alloc(UNIT *uptr, struct dasd_cckd *cckd, uint32 *len)
+{
+    uint32              pos;
+    int                 i;
+
+    for (i = 0; i < cckd->nfree; i++) {
+        if (cckd->free[i].len < *len)
+            continue;
+        pos = cckd->free[i].pos;
+        /* Don't leave blocks too small to hold the free chain */
+        if (cckd->free[i].len - *len < sizeof(struct dasd_free)) {
+            *len = cckd->free[i].len;
+            cckd->nfree--;
+            memmove(&cckd->free[i], &cckd->free[i+1],
+                    (cckd->nfree - i) * sizeof(struct dasd_free));
+        } else {
+            cckd->free[i].pos += *len;
+            cckd->free[i].len -= *len;
+        }
+        cckd->hdr.free_total -= *len;
+        return pos;
+    }
+    pos = cckd->hdr.size;
+    cckd->hdr.size += *len;
+    /* Record new end before anything is written there */
+    (void)sim_fseek(uptr->fileref, 512, SEEK_SET);
+    (void)sim_fwrite(&cckd->hdr, 1, sizeof(struct dasd_cckd_header),
+                     uptr->fileref);
+    return pos;
+}
+
+/* Return space to free list, merging with neighbours */
+void
+dasd_cckd_release(struct dasd_cckd *cckd, uint32 pos, uint32 len)
+{
+    int                 i;
+
+    if (pos + len == cckd->hdr.size) {
+        cckd->hdr.size = pos;
+        /* Drop any free block now at end of file */
+        if (cckd->nfree > 0 &&
+            cckd->free[cckd->nfree-1].pos + cckd->free[cckd->nfree-1].len == pos) {
+            cckd->nfree--;
+            cckd->hdr.size = cckd->free[cckd->nfree].pos;
+            cckd->hdr.free_total -= cckd->free[cckd->nfree].len;
+        }
+        return;
+    }
+    for (i = 0; i < cckd->nfree && cckd->free[i].pos < pos; i++);
+    cckd->hdr.free_total += len;
+    if (i > 0 && cckd->free[i-1].pos + cckd->free[i-1].len == pos) {
+        cckd->free[i-1].len += len;
+        if (i < cckd->nfree && pos + len == cckd->free[i].pos) {
+            cckd->free[i-1].len += cckd->free[i].len;
+            cckd->nfree--;
+            memmove(&cckd->free[i], &cckd->free[i+1],
+                    (cckd->nfree - i) * sizeof(struct dasd_free));
+        }
+        return;
+    }
+    if (i < cckd->nfree && pos + len == cckd->free[i].pos) {
+        cckd->free[i].pos = pos;
+        cckd->free[i].len += len;
+        return;
+    }
+    if (cckd->nfree == cckd->mfree) {
+        struct dasd_free *f;
+        int               n = (cckd->mfree == 0) ? 64 : cckd->mfree * 2;
+
+        f = (struct dasd_free *)realloc(cckd->free, n * sizeof(struct dasd_free));
+        if (f == NULL) {
+            /* Space is lost until the image is rebuilt */
+            cckd->hdr.free_total -= len;
+            return;
+        }
+        cckd->free = f;
+        cckd->mfree = n;
+    }
+    memmove(&cckd->free[i+1], &cckd->free[i],
+            (cckd->nfree - i) * sizeof(struct dasd_free));
+    cckd->free[i].pos = pos;
+    cckd->free[i].len = len;
+    cckd->nfree++;
+}
+
+/* Find L2 table for track, creating it if asked */
+struct dasd_l2 *
+dasd_cckd_l2(UNIT *uptr, struct dasd_cckd *cckd, int trk, int create)
+{
+    int                 l1 = trk / DASD_L2_TRKS;
+    uint32              len = DASD_L2_TRKS * sizeof(struct dasd_l2);
+    struct dasd_l2     *l2 = cckd->l2[l1];
+
+    if (l2 != NULL)
+        return &l2[trk % DASD_L2_TRKS];
+    if (cckd->l1[l1] == 0 && !create)
+        return NULL;
+    if ((l2 = (struct dasd_l2 *)calloc(DASD_L2_TRKS, sizeof(struct dasd_l2))) == NULL)
+        return NULL;
+    if (cckd->l1[l1] != 0) {
+        (void)sim_fseek(uptr->fileref, cckd->l1[l1], SEEK_SET);
+        (void)sim_fread(l2, 1, len, uptr->fileref);
+    } else {
+        cckd->l1[l1] = dasd_cckd_alloc(uptr, cckd, &len);
+        (void)sim_fseek(uptr->fileref, cckd->l1[l1], SEEK_SET);
+        (void)sim_fwrite(l2, sizeof(struct dasd_l2), DASD_L2_TRKS, uptr->fileref);
+        (void)sim_fseek(uptr->fileref, 1024 + (l1 * sizeof(uint32)), SEEK_SET);
+        (void)sim_fwrite(&cckd->l1[l1], 1, sizeof(uint32), uptr->fileref);
+    }
+    cckd->l2[l1] = l2;
+    return &l2[trk % DASD_L2_TRKS];
+}
+
+/* Read one track of compressed image */
+void
+dasd_cckd_rdtrk(UNIT *uptr, struct dasd_t *data, int cyl, int hd, uint8 *buf)
+{
+    struct dasd_cckd   *cckd = data->cckd;
+    int                 type = GET_TYPE(uptr->flags);
+    struct dasd_l2     *l2;
+    uint32              len;
+
+    l2 = dasd_cckd_l2(uptr, cckd, (cyl * disk_type[type].heads) + hd, 0);
+    if (l2 == NULL || l2->pos == 0) {
+        dasd_init_track(buf, cyl, hd, data->tsize);
+        return;
+    }
+    len = (l2->len > data->tsize + 1) ? data->tsize + 1 : l2->len;
+    (void)sim_fseek(uptr->fileref, l2->pos, SEEK_SET);
+    len = sim_fread(cckd->tbuf, 1, len, uptr->fileref);
+    if (len > 0)
+        len--;
+    switch (cckd->tbuf[0]) {
+#if defined(HAVE_ZLIB)
+    case DASD_COMP_ZLIB:
+         {
+             uLongf  dlen = data->tsize;
+
+             if (uncompress(buf, &dlen, &cckd->tbuf[1], len) != Z_OK)
+                 dlen = 0;
+             len = dlen;
+         }
+         break;
+#endif
+    case DASD_COMP_NONE:
+         memcpy(buf, &cckd->tbuf[1], len);
+         break;
+    default:
+         len = 0;
+         break;
+    }
+    memset(&buf[len], 0, data->tsize - len);
+}
+
+/* Write one track of compressed image */
+void
+dasd_cckd_wrtrk(UNIT *uptr, struct dasd_t *data, int cyl, int hd, uint8 *buf)
+{
+    struct dasd_cckd   *cckd = data->cckd;
+    int                 type = GET_TYPE(uptr->flags);
+    int                 trk = (cyl * disk_type[type].heads) + hd;
+    struct dasd_l2     *l2;
+    uint32              len;
+    uint32              size;
+
+    /* Empty tracks need no space */
+    dasd_init_track(cckd->nbuf, cyl, hd, data->tsize);
+    if (memcmp(buf, cckd->nbuf, data->tsize) == 0) {
+        l2 = dasd_cckd_l2(uptr, cckd, trk, 0);
+        if (l2 == NULL || l2->pos == 0)
+            return;
+        dasd_cckd_release(cckd, l2->pos, l2->size);
+        memset(l2, 0, sizeof(struct dasd_l2));
+    } else {
+        for (len = data->tsize; len > 0 && buf[len-1] == 0; len--);
+        cckd->tbuf[0] = DASD_COMP_NONE;
+#if defined(HAVE_ZLIB)
+        if (cckd->hdr.compress == DASD_COMP_ZLIB) {
+            uLongf  clen = len - 1;
+
+            if (len > 1 && compress2(&cckd->tbuf[1], &clen, buf, len,
+                                     Z_DEFAULT_COMPRESSION) == Z_OK) {
+                cckd->tbuf[0] = DASD_COMP_ZLIB;
+                len = clen;
+            }
+        }
+#endif
+        if (cckd->tbuf[0] == DASD_COMP_NONE)
+            memcpy(&cckd->tbuf[1], buf, len);
+        len++;
+        if ((l2 = dasd_cckd_l2(uptr, cckd, trk, 1)) == NULL)
+            return;
+        if (l2->pos == 0 || len > l2->size) {
+            if (l2->pos != 0)
+                dasd_cckd_release(cckd, l2->pos, l2->size);
+            /* Leave room to grow so small updates stay in place */
+            size = len + (len / 8);
+            if (size < sizeof(struct dasd_free))
+                size = sizeof(struct dasd_free);
+            l2->pos = dasd_cckd_alloc(uptr, cckd, &size);
+            l2->size = size;
+        }
+        l2->len = len;
+        (void)sim_fseek(uptr->fileref, l2->pos, SEEK_SET);
+        (void)sim_fwrite(cckd->tbuf, 1, len, uptr->fileref);
+    }
+    (void)sim_fseek(uptr->fileref, cckd->l1[trk / DASD_L2_TRKS] +
+              ((trk % DASD_L2_TRKS) * sizeof(struct dasd_l2)), SEEK_SET);
+    (void)sim_fwrite(l2, 1, sizeof(struct dasd_l2), uptr->fileref);
+}
+
+/* Set up compressed image, either new or from the file */
+int
+dasd_cckd_open(UNIT *uptr, struct dasd_t *data, int new)
+{
+    struct dasd_cckd   *cckd;
+    int                 type = GET_TYPE(uptr->flags);
+    int                 numl1;
+    uint32              pos;
+    struct dasd_free    blk;
+
+    numl1 = ((disk_type[type].cyl + 1) * disk_type[type].heads +
+                  DASD_L2_TRKS - 1) / DASD_L2_TRKS;
+    if ((cckd = (struct dasd_cckd *)calloc(1, sizeof(struct dasd_cckd))) == NULL)
+        return 1;
+    data->cckd = cckd;
+    cckd->l1 = (uint32 *)calloc(numl1, sizeof(uint32));
+    cckd->l2 = (struct dasd_l2 **)calloc(numl1, sizeof(struct dasd_l2 *));
+    cckd->tbuf = (uint8 *)calloc(data->tsize + 1, sizeof(uint8));
+    cckd->nbuf = (uint8 *)calloc(data->tsize, sizeof(uint8));
+    if (cckd->l1 == NULL || cckd->l2 == NULL || cckd->tbuf == NULL ||
+        cckd->nbuf == NULL)
+        return 1;
+    if (new) {
+        cckd->hdr.numl1 = numl1;
+        cckd->hdr.size = 1024 + (numl1 * sizeof(uint32));
+#if defined(HAVE_ZLIB)
+        cckd->hdr.compress = DASD_COMP_ZLIB;
+#endif
+        (void)sim_fseek(uptr->fileref, 512, SEEK_SET);
+        (void)sim_fwrite(&cckd->hdr, 1, sizeof(struct dasd_cckd_header),
+                         uptr->fileref);
+        (void)sim_fwrite(cckd->l1, sizeof(uint32), numl1, uptr->fileref);
+        cckd->valid = 1;
+        return 0;
+    }
+    (void)sim_fseek(uptr->fileref, 512, SEEK_SET);
+    if (sim_fread(&cckd->hdr, 1, sizeof(struct dasd_cckd_header), uptr->fileref)
+              != sizeof(struct dasd_cckd_header) || cckd->hdr.numl1 != numl1)
+        return 1;
+#if !defined(HAVE_ZLIB)
+    if (cckd->hdr.compress != DASD_COMP_NONE) {
+        sim_messagef(SCPE_OK, "Compressed image needs zlib support\n");
+        return 1;
+    }
+#endif
+    if (sim_fread(cckd->l1, sizeof(uint32), numl1, uptr->fileref) != numl1)
+        return 1;
+    /* Read free chain, it is rewritten on detach */
+    pos = cckd->hdr.free;
+    cckd->hdr.free_total = 0;
+    while (pos != 0) {
+        (void)sim_fseek(uptr->fileref, pos, SEEK_SET);
+        if (sim_fread(&blk, 1, sizeof(struct dasd_free), uptr->fileref) !=
+                  sizeof(struct dasd_free))
+            break;
+        dasd_cckd_release(cckd, pos, blk.len);
+        pos = blk.pos;
+    }
+    cckd->hdr.free = 0;
+    if ((uptr->flags & UNIT_RO) == 0) {
+        (void)sim_fseek(uptr->fileref, 512, SEEK_SET);
+        (void)sim_fwrite(&cckd->hdr, 1, sizeof(struct dasd_cckd_header),
+                         uptr->fileref);
+    }
+    cckd->valid = 1;
+    return 0;
+}
+
+/* Write out free chain and release compressed image state. An image
+   dasd_cckd_open rejected is left exactly as it was found. */
+void
+dasd_cckd_close(UNIT *uptr, struct dasd_t *data)
+{
+    struct dasd_cckd   *cckd = data->cckd;
+    struct dasd_free    blk;
+    int                 i;
+
+    if (cckd == NULL)
+        return;
+    if ((uptr->flags & UNIT_RO) == 0 && cckd->valid) {
+        cckd->hdr.free = (cckd->nfree > 0) ? cckd->free[0].pos : 0;
+        for (i = 0; i < cckd->nfree; i++) {
+            blk.pos = (i + 1 < cckd->nfree) ? cckd->free[i+1].pos : 0;
+            blk.len = cckd->free[i].len;
+            (void)sim_fseek(uptr->fileref, cckd->free[i].pos, SEEK_SET);
+            (void)sim_fwrite(&blk, 1, sizeof(struct dasd_free), uptr->fileref);
+        }
+        (void)sim_fseek(uptr->fileref, 512, SEEK_SET);
+        (void)sim_fwrite(&cckd->hdr, 1, sizeof(struct dasd_cckd_header),
+                         uptr->fileref);
+    }
+    if (cckd->l2 != NULL && cckd->valid) {     /* hdr.numl1 matches l2 */
+        for (i = 0; i < (int)cckd->hdr.numl1; i++)
+            free(cckd->l2[i]);
+    }
+    free(cckd->l1);
+    free(cckd->l2);
+    free(cckd->free);
+    free(cckd->tbuf);
+    free(cckd->nbuf);
+    free(cckd);
+    data->cckd = NULL;
+}
+
+/* Write back modified tracks of a cached cylinder */
+void
+dasd_cache_clean(struct dasd_cache *ce)
+{
+    UNIT               *uptr = ce->uptr;
+    struct dasd_t      *data = (struct dasd_t *)(uptr->up7);
+    int                 heads = disk_type[GET_TYPE(uptr->flags)].heads;
+    int                 hd;
+
+    for (hd = 0; hd < heads; hd++) {
+        if ((ce->dirty[hd >> 5] & (1u << (hd & 0x1f))) == 0)
+            continue;
+        if (data->cckd != NULL) {
+            dasd_cckd_wrtrk(uptr, data, ce->cyl, hd, &ce->cbuf[hd * data->tsize]);
+        } else {
+            (void)sim_fseek(uptr->fileref, sizeof(struct dasd_header) +
+                   ((ce->cyl * heads) + hd) * data->tsize, SEEK_SET);
+            (void)sim_fwrite(&ce->cbuf[hd * data->tsize], 1, data->tsize,
+                   uptr->fileref);
+        }
+    }
+    memset(ce->dirty, 0, sizeof(ce->dirty));
+}
+
+/* Make cyl the current cylinder of the drive */
+t_stat
+dasd_load_cyl(UNIT *uptr, int cyl)
+{
+    struct dasd_t      *data = (struct dasd_t *)(uptr->up7);
+    int                 heads = disk_type[GET_TYPE(uptr->flags)].heads;
+    uint32              size = data->tsize * heads;
+    struct dasd_cache  *ce = NULL;
+    struct dasd_cache  *ve;
+    int                 hd;
+    int                 i;
+
+    for (i = 0; i < DASD_CACHE_CYL; i++) {
+        ve = &dasd_cache[i];
+        if (ve->uptr == uptr && ve->cyl == cyl) {
+            ce = ve;
+            break;
+        }
+        /* Pick empty or oldest entry not in use by a drive */
+        if (ve->uptr != NULL &&
+            ((struct dasd_t *)(ve->uptr->up7))->cent == ve)
+            continue;
+        if (ce == NULL || ve->uptr == NULL ||
+            (ce->uptr != NULL && ve->lru < ce->lru))
+            ce = ve;
+    }
+    if (ce == NULL)
+        return SCPE_MEM;
+    if (ce->uptr != uptr || ce->cyl != cyl) {
+        if (ce->size < size) {
+            uint8   *buf = (uint8 *)realloc(ce->cbuf, size);
+            if (buf == NULL)
+                return SCPE_MEM;
+            ce->cbuf = buf;
+            ce->size = size;
+        }
+        if (ce->uptr != NULL)
+            dasd_cache_clean(ce);
+        ce->uptr = uptr;
+        ce->cyl = cyl;
+        if (data->cckd != NULL) {
+            for (hd = 0; hd < heads; hd++)
+                dasd_cckd_rdtrk(uptr, data, cyl, hd, &ce->cbuf[hd * data->tsize]);
+        } else {
+            (void)sim_fseek(uptr->fileref, sizeof(struct dasd_header) +
+                   (cyl * size), SEEK_SET);
+            i = sim_fread(ce->cbuf, 1, size, uptr->fileref);
+            memset(&ce->cbuf[i], 0, size - i);
+        }
+    }
+    ce->lru = ++dasd_cache_clock;
+    data->cent = ce;
+    data->cbuf = ce->cbuf;
+    data->cpos = sizeof(struct dasd_header) + (cyl * size);
+    data->ccyl = cyl;
+    uptr->u3 &= ~DK_CYL_DIRTY;
+    return SCPE_OK;
+}
+
+/* Mark current track modified */
+void
+dasd_set_dirty(UNIT *uptr, struct dasd_t *data)
+{
+    int                 hd = data->tstart / data->tsize;
+
+    data->cent->dirty[hd >> 5] |= 1u << (hd & 0x1f);
+    uptr->u3 |= DK_CYL_DIRTY;
+}
+
+/* Write back all modified tracks of drive */
+void
+dasd_flush(UNIT *uptr)
+{
+    struct dasd_t      *data = (struct dasd_t *)(uptr->up7);
+    int                 i;
+
+    if (data == NULL)
+        return;
+    for (i = 0; i < DASD_CACHE_CYL; i++) {
+        if (dasd_cache[i].uptr == uptr)
+            dasd_cache_clean(&dasd_cache[i]);
+    }
+    if (data->cckd != NULL && (uptr->flags & UNIT_RO) == 0) {
+        (void)sim_fseek(uptr->fileref, 512, SEEK_SET);
+        (void)sim_fwrite(&data->cckd->hdr, 1, sizeof(struct dasd_cckd_header),
+                         uptr->fileref);
+    }
+    fflush(uptr->fileref);
+}
+
 int
 dasd_format(UNIT * uptr, int flag) {
     struct dasd_header  hdr;
     struct dasd_t       *data;
     uint16              addr = GET_UADDR(uptr->u3);
     int                 type = GET_TYPE(uptr->flags);
+    int                 cckd = (sim_switches & SWMASK ('C')) != 0;
+    uint8               *cbuf;
     int                 tsize;
     int                 cyl;
     int                 hd;
-    int                 pos;
 
     if (flag || get_yn("Initialize dasd? [Y] ", TRUE)) {
         memset(&hdr, 0, sizeof(struct dasd_header));
-        memcpy(&hdr.devid[0], "CKD_P370", 8);
+        memcpy(&hdr.devid[0], cckd ? DASD_CCKD_ID : "CKD_P370", 8);
         hdr.heads = disk_type[type].heads;
         hdr.tracksize = (disk_type[type].bpt | 0x1ff) + 1;
         hdr.devtype = disk_type[type].dev_type;
@@ -1624,49 +2185,25 @@ dasd_format(UNIT * uptr, int flag) {
         uptr->up7 = (void *)data;
         tsize = hdr.tracksize * hdr.heads;
         data->tsize = hdr.tracksize;
-        if ((data->cbuf = (uint8 *)calloc(tsize, sizeof(uint8))) == 0)
-            return 1;
-        for (cyl = 0; cyl <= disk_type[type].cyl; cyl++) {
-            pos = 0;
-            for (hd = 0; hd < disk_type[type].heads; hd++) {
-                int cpos = pos;
-                data->cbuf[pos++] = 0;            /* HA */
-                data->cbuf[pos++] = (cyl >> 8);
-                data->cbuf[pos++] = (cyl & 0xff);
-                data->cbuf[pos++] = (hd >> 8);
-                data->cbuf[pos++] = (hd & 0xff);
-                data->cbuf[pos++] = (cyl >> 8);   /* R0 */
-                data->cbuf[pos++] = (cyl & 0xff);
-                data->cbuf[pos++] = (hd >> 8);
-                data->cbuf[pos++] = (hd & 0xff);
-                data->cbuf[pos++] = 0;              /* Rec */
-                data->cbuf[pos++] = 0;              /* keylen */
-                data->cbuf[pos++] = 0;              /* dlen */
-                data->cbuf[pos++] = 8;              /*  */
-                pos += 8;
-                data->cbuf[pos++] = (cyl >> 8);   /* R1 */
-                data->cbuf[pos++] = (cyl & 0xff);
-                data->cbuf[pos++] = (hd >> 8);
-                data->cbuf[pos++] = (hd & 0xff);
-                data->cbuf[pos++] = 1;              /* Rec */
-                data->cbuf[pos++] = 0;              /* keylen */
-                data->cbuf[pos++] = 0;              /* dlen */
-                data->cbuf[pos++] = 0;              /*  */
-                data->cbuf[pos++] = 0xff;           /* End record */
-                data->cbuf[pos++] = 0xff;
-                data->cbuf[pos++] = 0xff;
-                data->cbuf[pos++] = 0xff;
-                pos = cpos + data->tsize;
+        if (cckd) {
+            /* Every track starts out empty, nothing more to write */
+            if (dasd_cckd_open(uptr, data, 1))
+                return 1;
+        } else {
+            if ((cbuf = (uint8 *)calloc(tsize, sizeof(uint8))) == 0)
+                return 1;
+            for (cyl = 0; cyl <= disk_type[type].cyl; cyl++) {
+                for (hd = 0; hd < disk_type[type].heads; hd++)
+                    dasd_init_track(&cbuf[hd * data->tsize], cyl, hd, data->tsize);
+                sim_fwrite(cbuf, 1, tsize, uptr->fileref);
+                if ((cyl % 10) == 0)
+                   fputc('.', stderr);
             }
-            sim_fwrite(data->cbuf, 1, tsize, uptr->fileref);
-            if ((cyl % 10) == 0)
-               fputc('.', stderr);
+            free(cbuf);
         }
-        (void)sim_fseek(uptr->fileref, sizeof(struct dasd_header), SEEK_SET);
-        (void)sim_fread(data->cbuf, 1, tsize, uptr->fileref);
-        data->cpos = sizeof(struct dasd_header);
-        data->ccyl = 0;
-        data->ccyl = 0;
+        if (dasd_load_cyl(uptr, 0) != SCPE_OK)
+            return 1;
+        uptr->io_flush = &dasd_flush;
         set_devattn(addr, SNS_DEVEND);
         sim_activate(uptr, 100);
         fputc('\n', stderr);
@@ -1685,19 +2222,23 @@ dasd_attach(UNIT * uptr, CONST char *file)
     int                 i;
     struct dasd_header  hdr;
     struct dasd_t       *data;
+    int                 cckd;
     int                 tsize;
 
     if ((r = attach_unit(uptr, file)) != SCPE_OK)
        return r;
 
     if (sim_fread(&hdr, 1, sizeof(struct dasd_header), uptr->fileref) !=
-          sizeof(struct dasd_header) || strncmp(&hdr.devid[0], "CKD_P370", 8) != 0 || flag) {
+          sizeof(struct dasd_header) || flag ||
+          (strncmp(&hdr.devid[0], "CKD_P370", 8) != 0 &&
+           strncmp(&hdr.devid[0], DASD_CCKD_ID, 8) != 0)) {
         if (dasd_format(uptr, flag)) {
-            detach_unit(uptr);
+            dasd_detach(uptr);
             return SCPE_FMT;
         }
         return SCPE_OK;
     }
+    cckd = strncmp(&hdr.devid[0], DASD_CCKD_ID, 8) == 0;
 
     sim_messagef(SCPE_OK, "Drive %03x=%d %d %02x %d\n\r",  addr,
              hdr.heads, hdr.tracksize, hdr.devtype, hdr.highcyl);
@@ -1726,16 +2267,13 @@ dasd_attach(UNIT * uptr, CONST char *file)
     if ((data = (struct dasd_t *)calloc(1, sizeof(struct dasd_t))) == 0)
         return 0;
     uptr->up7 = (void *)data;
-    tsize = hdr.tracksize * hdr.heads;
     data->tsize = hdr.tracksize;
-    if ((data->cbuf = (uint8 *)calloc(tsize, sizeof(uint8))) == 0) {
-        detach_unit(uptr);
-        return SCPE_ARG;
+    if ((cckd && dasd_cckd_open(uptr, data, 0)) ||
+        dasd_load_cyl(uptr, 0) != SCPE_OK) {
+        dasd_detach(uptr);
+        return SCPE_FMT;
     }
-    (void)sim_fseek(uptr->fileref, sizeof(struct dasd_header), SEEK_SET);
-    (void)sim_fread(data->cbuf, 1, tsize, uptr->fileref);
-    data->cpos = sizeof(struct dasd_header);
-    data->ccyl = 0;
+    uptr->io_flush = &dasd_flush;
     set_devattn(addr, SNS_DEVEND);
     sim_activate(uptr, 100);
     return SCPE_OK;
@@ -1745,22 +2283,26 @@ t_stat
 dasd_detach(UNIT * uptr)
 {
     struct dasd_t       *data = (struct dasd_t *)uptr->up7;
-    int                 type = GET_TYPE(uptr->flags);
     uint16              addr = GET_UADDR(uptr->u3);
     int                 cmd = uptr->u3 & 0x7f;
+    int                 i;
 
-    if (uptr->u3 & DK_CYL_DIRTY) {
-        (void)sim_fseek(uptr->fileref, data->cpos, SEEK_SET);
-        (void)sim_fwrite(data->cbuf, 1,
-               data->tsize * disk_type[type].heads, uptr->fileref);
-        uptr->u3 &= ~DK_CYL_DIRTY;
+    if (data != NULL) {
+        dasd_flush(uptr);
+        for (i = 0; i < DASD_CACHE_CYL; i++) {
+            if (dasd_cache[i].uptr == uptr) {
+                free(dasd_cache[i].cbuf);
+                memset(&dasd_cache[i], 0, sizeof(struct dasd_cache));
+            }
+        }
+        dasd_cckd_close(uptr, data);
     }
     if (cmd != 0)
          chan_end(addr, SNS_CHNEND|SNS_DEVEND);
     sim_cancel(uptr);
-    free(data->cbuf);
     free(data);
     uptr->up7 = 0;
+    uptr->io_flush = NULL;
     uptr->u3 &= ~0xffff;
     return detach_unit(uptr);
 }
@@ -1860,6 +2402,7 @@ t_stat dasd_help (FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag,
     }
     fprintf (st, "Attach command switches\n");
     fprintf (st, "    -I          Initialize the drive. No prompting.\n");
+    fprintf (st, "    -C          Create a compressed image when initializing.\n");
     fprint_set_help (st, dptr);
     fprint_show_help (st, dptr);
     return SCPE_OK;
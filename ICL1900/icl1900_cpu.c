@@ -425,7 +425,7 @@ sim_instr(void)
        }
 
        if (sim_brk_summ) {
-           if(sim_brk_test(RC, SWMASK('E'))) {
+           if(SIM_BRK_TEST(RC, SWMASK('E'))) {
                reason = SCPE_STOP;
                break;
            }
@@ -1197,6 +1197,12 @@ branch:
                          RB &= M15;
                      else
                          RB &= M22;
+                     /* Unconditional branch to itself outside executive
+                        mode is the idle loop, only an interrupt ends it */
+                     if (!exe_mode && RX == 0 &&
+                         (RF == OP_BRN || RF == OP_BRN1) &&
+                         RB == ((RC - 1) & ((Mode & (EJM|AM22)) ? M22: M15)))
+                         sim_idle(TMR_RTC, 0);
                      RC = RB;
                      break;
 
@@ -2440,6 +2446,7 @@ rtc_srv(UNIT * uptr)
 
     t = sim_rtcn_calb(rtc_tps, TMR_RTC);
     sim_activate_after(uptr, 1000000/rtc_tps);
+    tmxr_poll = t;                              /* Track calibrated tick */
     SR64 |= B3;
     return SCPE_OK;
 }
@@ -2480,8 +2487,7 @@ cpu_reset(DEVICE * dptr)
     sim_brk_types = sim_brk_dflt = SWMASK('E') | SWMASK('A') | SWMASK('B');
     hst_p = 0;
 
-    sim_register_clock_unit (&cpu_unit[0]);
-    sim_rtcn_init (cpu_unit[0].wait, TMR_RTC);
+    sim_rtcn_init_unit (&cpu_unit[0], cpu_unit[0].wait, TMR_RTC);
     sim_activate(&cpu_unit[0], cpu_unit[0].wait) ;
     SR64 = SR65 = 0;
 
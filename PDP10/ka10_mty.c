@@ -162,8 +162,10 @@ static t_stat mty_devio(uint32 dev, uint64 *data)
 static t_stat mty_input_svc (UNIT *uptr)
 {
     static int scan = 0;
+    const int32 *ready;
+    uint32 mask;
     int32 ch;
-    int i;
+    int i, n;
 
     sim_clock_coschedule (uptr, 1000);
 
@@ -176,10 +178,20 @@ static t_stat mty_input_svc (UNIT *uptr)
 
     tmxr_poll_rx (&mty_desc);
 
-    for (i = 0; i < MTY_LINES; i++) {
+    /* Only look at lines holding input, unless the mux can't tell. */
+    n = tmxr_rx_ready_lines (&mty_desc, &ready);
+    if (n >= 0) {
+        for (mask = 0; n > 0; n--)
+            mask |= 1u << ready[n - 1];
+    } else
+        mask = 0xffffffff;
+
+    for (i = 0; i < MTY_LINES && mask != 0; i++) {
         /* Round robin scan 32 lines. */
         scan = (scan + 1) & 037;
 
+        if ((mask & (1u << scan)) == 0)
+            continue;
         ch = tmxr_getc_ln (&mty_ldsc[scan]);
         if (ch & TMXR_VALID) {
             mty_input_character = ch & 0177;
@@ -321,7 +321,11 @@ struct nia_device {
     ETH_MAC           mac;                     /* Hardware MAC addresses */
     ETH_DEV           etherface;
     ETH_QUE           ReadQ;
-    ETH_PACK          rec_buff;                /* Buffer for recieved packet */
+    ETH_PACK          *rec_buff;               /* Recieved packet being processed */
+#define NIA_RBATCH    16
+    ETH_PACK          *rec_batch[NIA_RBATCH];  /* Recieved packets from eth_read_batch */
+    int               rec_next;                /* Next packet in rec_batch */
+    int               rec_count;               /* Number of packets in rec_batch */
     ETH_PACK          snd_buff;                /* Buffer for sending packet */
     t_addr            cmd_entry;               /* Pointer to current command entry */
     t_addr            cmd_rply;                /* Pointer to reply entry */
@@ -1395,7 +1399,7 @@ nia_rec_pkt()
        return 1;
 
     /* Determine which queue to get free packet from */
-    hdr = (struct nia_eth_hdr *)(&nia_data.rec_buff.msg[0]);
+    hdr = (struct nia_eth_hdr *)(&nia_data.rec_buff->msg[0]);
     type = ntohs(hdr->type);
 
     queue = nia_data.unk_hdr;
@@ -1418,15 +1422,16 @@ nia_rec_pkt()
            nia_data.pcnt[NIA_CNT_DUN]++;
        else
            nia_data.pcnt[NIA_CNT_D01 + i]++;
-       nia_data.pcnt[NIA_CNT_UBU] += nia_data.rec_buff.len;
+       nia_data.pcnt[NIA_CNT_UBU] += nia_data.rec_buff->len;
+       eth_read_release(&nia_data.etherface, nia_data.rec_buff);
        nia_data.status |= NIA_FQE;
        set_interrupt(NIA_DEVNUM, nia_data.status & NIA_PIA);
        return 1;  /* We did what we could with it. */
     }
 
     /* Get some information about packet */
-    len = nia_data.rec_buff.len - sizeof(struct nia_eth_hdr);
-    data = &nia_data.rec_buff.msg[sizeof(struct nia_eth_hdr)];
+    len = nia_data.rec_buff->len - sizeof(struct nia_eth_hdr);
+    data = &nia_data.rec_buff->msg[sizeof(struct nia_eth_hdr)];
 
     /* Got one, now fill in data */
     word = (uint64)(NIA_CMD_RCV << 12);
@@ -1484,6 +1489,7 @@ nia_rec_pkt()
                  i, M[nia_data.rec_entry + i], M[nia_data.rec_entry + i]);
     /* All done with packet */
     nia_data.r_pkt = 0;
+    eth_read_release(&nia_data.etherface, nia_data.rec_buff);
     /* Put on response queue */
     return nia_putq(nia_data.resp_hdr, &nia_data.rec_entry);
 }
@@ -1498,27 +1504,37 @@ t_stat nia_eth_srv(UNIT * uptr)
 
     /* Check if we need to get a packet */
     while (nia_data.r_pkt == 0) {
-        if (eth_read(&nia_data.etherface, &nia_data.rec_buff, NULL) <= 0)
-            return SCPE_OK;
+        /* Take packets from the receive ring a batch at a time */
+        if (nia_data.rec_next == nia_data.rec_count) {
+            nia_data.rec_next = 0;
+            nia_data.rec_count = eth_read_batch(&nia_data.etherface,
+                                           nia_data.rec_batch, NIA_RBATCH);
+            if (nia_data.rec_count <= 0) {
+                nia_data.rec_count = 0;
+                return SCPE_OK;
+            }
+        }
+        nia_data.rec_buff = nia_data.rec_batch[nia_data.rec_next++];
 
-        nia_packet_debug(&nia_data, "recv", &nia_data.rec_buff);
-        hdr = (struct nia_eth_hdr *)(&nia_data.rec_buff.msg[0]);
+        nia_packet_debug(&nia_data, "recv", nia_data.rec_buff);
+        hdr = (struct nia_eth_hdr *)(&nia_data.rec_buff->msg[0]);
         type = ntohs(hdr->type);
         /* Check if we are running */
         if ((nia_data.status & NIA_MRN) == 0) {
             sim_debug(DEBUG_DETAIL, &nia_dev,
                 "NIA read packet - not running: %d %04x\n",
-                 nia_data.rec_buff.len, type);
+                 nia_data.rec_buff->len, type);
+            eth_read_release(&nia_data.etherface, nia_data.rec_buff);
             return SCPE_OK;
         }
 
         sim_debug(DEBUG_DETAIL, &nia_dev, "NIA read packet: %d %04x\n",
-                nia_data.rec_buff.len, type);
+                nia_data.rec_buff->len, type);
         nia_data.r_pkt = 1;   /* Mark packet buffer full */
-        nia_data.pcnt[NIA_CNT_BR] += nia_data.rec_buff.len;
+        nia_data.pcnt[NIA_CNT_BR] += nia_data.rec_buff->len;
         nia_data.pcnt[NIA_CNT_FR] ++;
         if (hdr->dest[0] & 1) {
-            nia_data.pcnt[NIA_CNT_MCB] += nia_data.rec_buff.len;
+            nia_data.pcnt[NIA_CNT_MCB] += nia_data.rec_buff->len;
             nia_data.pcnt[NIA_CNT_MCF] ++;
         }
 
@@ -1648,6 +1664,9 @@ t_stat nia_detach(UNIT* uptr)
     if (uptr->flags & UNIT_ATT) {
         sim_cancel(&nia_unit[1]);
         sim_cancel(&nia_unit[2]);
+        /* Drop any packets still held, their buffers go with the ring */
+        nia_data.r_pkt = 0;
+        nia_data.rec_next = nia_data.rec_count = 0;
         eth_close (&nia_data.etherface);
         free(uptr->filename);
         uptr->filename = NULL;
@@ -209,6 +209,14 @@ uint64  fault_data;                           /* Fault data from last fault */
 int     trap_flag;                            /* In trap cycle */
 int     last_page;                            /* Last page mapped */
 #endif
+#if KI | KL
+struct _fast_tlb {
+    uint64  *ptr;                             /* Page in M, NULL if not valid */
+    int      pub;                             /* Public page */
+    int      sect;                            /* Section of TLB entry */
+    int      last;                            /* Value for last_page, or -1 */
+} fast_tlb[2][2][546];                        /* Fast map, [wr][uf][tlb slot] */
+#endif
 #if BBN
 int     exec_map;                             /* Enable executive mapping */
 int     next_write;                           /* Clear next write mapping */
@@ -1274,6 +1282,42 @@ t_stat null_dev(uint32 dev, uint64 *data) {
     return SCPE_OK;
 }
 
+#if KI | KL
+/*
+ * The fast map keeps a pointer into M for each TLB slot that has passed
+ * a full page_lookup, one entry for reads and one for writes. Entries
+ * must be cleared whenever the matching e_tlb or u_tlb slot changes.
+ */
+void
+fast_flush()
+{
+    memset(fast_tlb, 0, sizeof(fast_tlb));
+}
+
+void
+fast_clear(int uf, int page)
+{
+    fast_tlb[0][uf][page].ptr = NULL;
+    fast_tlb[1][uf][page].ptr = NULL;
+}
+
+void
+fast_fill(int uf, int page, int pg, int wr, int pub, int sect, int last)
+{
+    struct _fast_tlb *ft = &fast_tlb[0][uf][page];
+
+    /* Leave pages past end of memory to page_lookup */
+    if ((((t_addr)pg + 1) << 9) > MEMSIZE)
+        return;
+    ft->ptr = &M[pg << 9];
+    ft->pub = pub;
+    ft->sect = sect;
+    ft->last = last;
+    if (wr)
+        fast_tlb[1][uf][page] = *ft;
+}
+#endif
+
 #if KL
 static int      timer_irq, timer_flg;
 
@@ -1320,6 +1364,7 @@ t_stat dev_pag(uint32 dev, uint64 *data) {
         }
         for (;i < 546; i++)
             u_tlb[i] = 0;
+        fast_flush();
         page_enable = (*data & 020000) != 0;
         t20_page = (*data & 040000) != 0;
         sim_debug(DEBUG_CONO, &cpu_dev, "CONO PAG %012llo\n", *data);
@@ -1335,13 +1380,17 @@ t_stat dev_pag(uint32 dev, uint64 *data) {
            for(i = 0; i < 8; i++) {
               u_tlb[page+i] = 0;
               e_tlb[page+i] = 0;
+              fast_clear(0, page+i);
+              fast_clear(1, page+i);
            }
            /* If not user do exec mappping */
            if (!t20_page && (page & 0740) == 0340) {
               /* Pages 340-377 via UBT */
               page += 01000 - 0340;
-              for(i = 0; i < 8; i++)
+              for(i = 0; i < 8; i++) {
                  u_tlb[page+i] = 0;
+                 fast_clear(1, page+i);
+              }
            }
         } else {
             res = *data;
@@ -1368,6 +1417,7 @@ t_stat dev_pag(uint32 dev, uint64 *data) {
                 }
                 for (;i < 546; i++)
                    u_tlb[i] = 0;
+                fast_flush();
            }
            sim_debug(DEBUG_DATAIO, &cpu_dev,
                     "DATAO PAG %012llo ebr=%06o ubr=%06o\n",
@@ -1727,6 +1777,7 @@ t_stat dev_pag(uint32 dev, uint64 *data) {
                e_tlb[i] = u_tlb[i] = 0;
             for (;i < 546; i++)
                u_tlb[i] = 0;
+            fast_flush();
             page_enable = (res & 020000) != 0;
         }
         if (res & SMASK) {
@@ -1735,6 +1786,7 @@ t_stat dev_pag(uint32 dev, uint64 *data) {
                e_tlb[i] = u_tlb[i] = 0;
             for (;i < 546; i++)
                u_tlb[i] = 0;
+            fast_flush();
             user_addr_cmp = (res & BIT4) != 0;
             small_user =    (res & BIT3) != 0;
             fm_sel = (uint8)(res >> 29) & 060;
@@ -2083,6 +2135,8 @@ load_tlb(int uf, int page, int wr)
             e_tlb[(page & 0776)|1] = pg|1;
             data = e_tlb[page];
         }
+        fast_clear(uf, page & 0776);
+        fast_clear(uf, (page & 0776)|1);
     } else
 #endif
 #define PG_PUB   0040000
@@ -2269,6 +2323,7 @@ pg_loop:
            u_tlb[page] = data & (SECTM|RMASK);
         else
            e_tlb[page] = data & (SECTM|RMASK);
+        fast_clear(uf, page);
     } else {
 
        /* Map the page */
@@ -2287,6 +2342,8 @@ pg_loop:
            e_tlb[page | 1] = (uint32)(RMASK & data);
            data = e_tlb[page];
        }
+       fast_clear(uf, page & 01776);
+       fast_clear(uf, page | 1);
     }
     return (int)(data);
 }
@@ -2418,6 +2475,7 @@ int page_lookup(t_addr addr, int flag, t_addr *loc, int wr, int cur_context, int
            u_tlb[page] = data;
         else
            e_tlb[page] = data;
+        fast_clear(uf || upmp, page);
     }
 
     /* create location. */
@@ -2445,6 +2503,7 @@ int page_lookup(t_addr addr, int flag, t_addr *loc, int wr, int cur_context, int
             } else {
                e_tlb[page] = 0;
             }
+            fast_clear(uf, page);
             if ((data & KL_PAG_A) == 0) {
                 fault_data = ((uint64)addr) | 033LL << 30 |((uf)?SMASK:0);
             } else {
@@ -2464,6 +2523,7 @@ int page_lookup(t_addr addr, int flag, t_addr *loc, int wr, int cur_context, int
         } else {
            e_tlb[page] = 0;
         }
+        fast_clear(uf, page);
         if (data & KL_PAG_C)         /* C */
            fault_data |= BIT7;       /* BIT7 */
         if (data & KL_PAG_P)         /* P */
@@ -2484,9 +2544,43 @@ int page_lookup(t_addr addr, int flag, t_addr *loc, int wr, int cur_context, int
     /* If fetching from public page, set public flag */
     if (fetch && ((data & KL_PAG_P) != 0))
         FLAGS |= PUBLIC;
+    fast_fill(uf || upmp, page, data & 017777, (data & KL_PAG_W) != 0,
+              (data & KL_PAG_P) != 0, (data >> 18) & 037, -1);
     return 1;
 }
 
+/*
+ * Fast path for page_lookup. Returns pointer to the word in M if the
+ * fast map has a valid entry, otherwise page_lookup must be used.
+ */
+uint64 *
+fast_lookup(t_addr addr, int wr, int fetch) {
+    int      page = (RMASK & addr) >> 9;
+    int      uf = (FLAGS & USER) != 0;
+    struct _fast_tlb *ft;
+
+    if (!page_enable || (xct_flag != 0 && !fetch) || addr == brk_addr)
+        return NULL;
+
+    /* Handle KI paging odditiy */
+    if (!uf && !t20_page && (page & 0740) == 0340) {
+        page += 01000 - 0340;
+        uf = 1;
+    }
+
+    ft = &fast_tlb[(wr | modify) != 0][uf][page];
+    if (ft->ptr == NULL || (QKLB && t20_page && ft->sect != sect))
+        return NULL;
+
+    /* Let page_lookup check private pages when PUBLIC */
+    if (!ft->pub && (FLAGS & PUBLIC) != 0)
+        return NULL;
+
+    if (fetch && ft->pub)
+        FLAGS |= PUBLIC;
+    return &ft->ptr[addr & 0777];
+}
+
 /*
  * Register access on KL 10
  */
@@ -2500,6 +2594,7 @@ void   set_reg(int reg, uint64 value) {
 
 int Mem_read(int flag, int cur_context, int fetch) {
     t_addr addr;
+    uint64 *ptr;
 
     if (AB < 020 && ((QKLB && (glb_sect == 0 || sect == 0 ||
               (glb_sect && sect == 1))) || !QKLB)) {
@@ -2522,22 +2617,26 @@ int Mem_read(int flag, int cur_context, int fetch) {
         }
         MB = get_reg(AB);
     } else {
-        if (!page_lookup(AB, flag, &addr, 0, cur_context, fetch))
-            return 1;
-        if (addr >= (int)MEMSIZE) {
-            irq_flags |= 02000;
-            return 1;
+        if (flag || (ptr = fast_lookup(AB, 0, fetch)) == NULL) {
+            if (!page_lookup(AB, flag, &addr, 0, cur_context, fetch))
+                return 1;
+            if (addr >= (int)MEMSIZE) {
+                irq_flags |= 02000;
+                return 1;
+            }
+            ptr = &M[addr];
         }
-        if (sim_brk_summ && sim_brk_test(AB, SWMASK('R')))
+        if (SIM_BRK_TEST(AB, SWMASK('R')))
             watch_stop = 1;
         sim_interval--;
-        MB = M[addr];
+        MB = *ptr;
     }
     return 0;
 }
 
 int Mem_write(int flag, int cur_context) {
     t_addr addr;
+    uint64 *ptr;
 
     if (AB < 020 && ((QKLB && (glb_sect == 0 || sect == 0 ||
                         (glb_sect && sect == 1))) || !QKLB)) {
@@ -2560,16 +2659,19 @@ int Mem_write(int flag, int cur_context) {
         }
         set_reg(AB, MB);
     } else {
-        if (!page_lookup(AB, flag, &addr, 1, cur_context, 0))
-            return 1;
-        if (addr >= (int)MEMSIZE) {
-            irq_flags |= 02000;
-            return 1;
+        if (flag || (ptr = fast_lookup(AB, 1, 0)) == NULL) {
+            if (!page_lookup(AB, flag, &addr, 1, cur_context, 0))
+                return 1;
+            if (addr >= (int)MEMSIZE) {
+                irq_flags |= 02000;
+                return 1;
+            }
+            ptr = &M[addr];
         }
-        if (sim_brk_summ && sim_brk_test(AB, SWMASK('W')))
+        if (SIM_BRK_TEST(AB, SWMASK('W')))
             watch_stop = 1;
         sim_interval--;
-        M[addr] = MB;
+        *ptr = MB;
     }
     return 0;
 }
@@ -2770,6 +2872,8 @@ load_tlb(int uf, int page)
            e_tlb[page & 0776] = RMASK & (data >> 18);
            e_tlb[page | 1] = RMASK & data;
            data = e_tlb[page];
+           fast_clear(0, page & 0776);
+           fast_clear(0, page | 1);
            pag_reload = ((pag_reload + 1) & 037) | 040;
         }
         last_page = ((page ^ 0777) << 1)|1;
@@ -2780,6 +2884,8 @@ load_tlb(int uf, int page)
            u_tlb[page & 01776] = RMASK & (data >> 18);
            u_tlb[page | 1] = RMASK & data;
            data = u_tlb[page];
+           fast_clear(1, page & 01776);
+           fast_clear(1, page | 1);
            pag_reload = ((pag_reload + 1) & 037) | 040;
         }
         if (upmp)
@@ -2856,6 +2962,7 @@ int page_lookup(t_addr addr, int flag, t_addr *loc, int wr, int cur_context, int
             page_fault = 1;
             return !wr;
         }
+        fast_fill(0, page, page, 1, 0, 0, -1);
         return 1;
     }
     data = load_tlb(uf, page);
@@ -2884,9 +2991,60 @@ int page_lookup(t_addr addr, int flag, t_addr *loc, int wr, int cur_context, int
     /* If fetching from public page, set public flag */
     if (fetch && ((data & KI_PAG_P) != 0))
         FLAGS |= PUBLIC;
+    if (!uf && (page & 0740) == 0340)
+        fast_fill(1, page + 01000 - 0340, data & 017777,
+                  (data & KI_PAG_W) != 0, (data & KI_PAG_P) != 0, 0, last_page);
+    else
+        fast_fill(uf, page, data & 017777, (data & KI_PAG_W) != 0,
+                  (data & KI_PAG_P) != 0, 0, last_page);
     return 1;
 }
 
+/*
+ * Fast path for page_lookup. Returns pointer to the word in M if the
+ * fast map has a valid entry, otherwise page_lookup must be used.
+ */
+uint64 *
+fast_lookup(t_addr addr, int wr, int fetch) {
+    int      page = (RMASK & addr) >> 9;
+    int      uf = (FLAGS & USER) != 0;
+    struct _fast_tlb *ft;
+
+    if (page_fault || !page_enable || xct_flag != 0)
+        return NULL;
+
+    /* If fetching byte data, use write access */
+    if (BYF5 && (IR & 06) == 6)
+        wr = 1;
+
+    if (uf && small_user && (page & 0340) != 0)
+        return NULL;
+
+    /* Pages 340-377 via UBR */
+    if (!uf && (page & 0740) == 0340) {
+        page += 01000 - 0340;
+        uf = 1;
+    }
+
+    ft = &fast_tlb[(wr | modify) != 0][uf][page];
+    if (ft->ptr == NULL)
+        return NULL;
+
+    /* Let page_lookup check private pages when PUBLIC */
+    if (!ft->pub && (FLAGS & PUBLIC) != 0)
+        return NULL;
+
+    if (fetch && ft->pub)
+        FLAGS |= PUBLIC;
+
+    /* Same timing as load_tlb */
+    if (ft->last >= 0) {
+        sim_interval--;
+        last_page = ft->last;
+    }
+    return &ft->ptr[addr & 0777];
+}
+
 /*
  * Register access on KI 10
  */
@@ -2906,6 +3064,7 @@ void   set_reg(int reg, uint64 value) {
 
 int Mem_read(int flag, int cur_context, int fetch) {
     t_addr addr;
+    uint64 *ptr;
 
     if (AB < 020) {
         if (FLAGS & USER) {
@@ -2926,22 +3085,26 @@ int Mem_read(int flag, int cur_context, int fetch) {
         MB = get_reg(AB);
     } else {
 read:
-        if (!page_lookup(AB, flag, &addr, 0, cur_context, fetch))
-            return 1;
-        if (addr >= (int)MEMSIZE) {
-            nxm_flag = 1;
-            return 1;
+        if (flag || (ptr = fast_lookup(AB, 0, fetch)) == NULL) {
+            if (!page_lookup(AB, flag, &addr, 0, cur_context, fetch))
+                return 1;
+            if (addr >= (int)MEMSIZE) {
+                nxm_flag = 1;
+                return 1;
+            }
+            ptr = &M[addr];
         }
-        if (sim_brk_summ && sim_brk_test(AB, SWMASK('R')))
+        if (SIM_BRK_TEST(AB, SWMASK('R')))
             watch_stop = 1;
         sim_interval--;
-        MB = M[addr];
+        MB = *ptr;
     }
     return 0;
 }
 
 int Mem_write(int flag, int cur_context) {
     t_addr addr;
+    uint64 *ptr;
 
     if (AB < 020) {
         if (FLAGS & USER) {
@@ -2965,16 +3128,19 @@ int Mem_write(int flag, int cur_context) {
         set_reg(AB, MB);
     } else {
 write:
-        if (!page_lookup(AB, flag, &addr, 1, cur_context, 0))
-            return 1;
-        if (addr >= (int)MEMSIZE) {
-            nxm_flag = 1;
-            return 1;
+        if (flag || (ptr = fast_lookup(AB, 1, 0)) == NULL) {
+            if (!page_lookup(AB, flag, &addr, 1, cur_context, 0))
+                return 1;
+            if (addr >= (int)MEMSIZE) {
+                nxm_flag = 1;
+                return 1;
+            }
+            ptr = &M[addr];
         }
-        if (sim_brk_summ && sim_brk_test(AB, SWMASK('W')))
+        if (SIM_BRK_TEST(AB, SWMASK('W')))
             watch_stop = 1;
          sim_interval--;
-        M[addr] = MB;
+        *ptr = MB;
     }
     return 0;
 }
@@ -3189,7 +3355,7 @@ int Mem_read_its(int flag, int cur_context, int fetch) {
             nxm_flag = 1;
             return 1;
         }
-        if (sim_brk_summ && sim_brk_test(AB, SWMASK('R')))
+        if (SIM_BRK_TEST(AB, SWMASK('R')))
             watch_stop = 1;
         sim_interval--;
         MB = M[addr];
@@ -3235,7 +3401,7 @@ int Mem_write_its(int flag, int cur_context) {
             nxm_flag = 1;
             return 1;
         }
-        if (sim_brk_summ && sim_brk_test(AB, SWMASK('W')))
+        if (SIM_BRK_TEST(AB, SWMASK('W')))
             watch_stop = 1;
         sim_interval--;
         M[addr] = MB;
@@ -3524,7 +3690,7 @@ int Mem_read_bbn(int flag, int cur_context, int fetch) {
         nxm_flag = 1;
         return 1;
     }
-    if (sim_brk_summ && sim_brk_test(AB, SWMASK('R')))
+    if (SIM_BRK_TEST(AB, SWMASK('R')))
         watch_stop = 1;
     sim_interval--;
     MB = M[addr];
@@ -3554,7 +3720,7 @@ int Mem_write_bbn(int flag, int cur_context) {
         nxm_flag = 1;
         return 1;
     }
-    if (sim_brk_summ && sim_brk_test(AB, SWMASK('W')))
+    if (SIM_BRK_TEST(AB, SWMASK('W')))
         watch_stop = 1;
     sim_interval--;
     M[addr] = MB;
@@ -3613,7 +3779,7 @@ int Mem_read_waits(int flag, int cur_context, int fetch) {
         nxm_flag = 1;
         return 1;
     }
-    if (sim_brk_summ && sim_brk_test(AB, SWMASK('R')))
+    if (SIM_BRK_TEST(AB, SWMASK('R')))
         watch_stop = 1;
     sim_interval--;
     MB = M[addr];
@@ -3640,7 +3806,7 @@ int Mem_write_waits(int flag, int cur_context) {
         nxm_flag = 1;
         return 1;
     }
-    if (sim_brk_summ && sim_brk_test(AB, SWMASK('W')))
+    if (SIM_BRK_TEST(AB, SWMASK('W')))
         watch_stop = 1;
     sim_interval--;
     M[addr] = MB;
@@ -3681,7 +3847,7 @@ int Mem_read_ka(int flag, int cur_context, int fetch) {
             nxm_flag = 1;
             return 1;
         }
-        if (sim_brk_summ && sim_brk_test(AB, SWMASK('R')))
+        if (SIM_BRK_TEST(AB, SWMASK('R')))
             watch_stop = 1;
         sim_interval--;
         MB = M[addr];
@@ -3707,7 +3873,7 @@ int Mem_write_ka(int flag, int cur_context) {
             nxm_flag = 1;
             return 1;
         }
-        if (sim_brk_summ && sim_brk_test(AB, SWMASK('W')))
+        if (SIM_BRK_TEST(AB, SWMASK('W')))
             watch_stop = 1;
         sim_interval--;
         M[addr] = MB;
@@ -3846,7 +4012,7 @@ int Mem_read(int flag, int cur_context, int fetch) {
             nxm_flag = 1;
             return 1;
         }
-        if (sim_brk_summ && sim_brk_test(AB, SWMASK('R')))
+        if (SIM_BRK_TEST(AB, SWMASK('R')))
             watch_stop = 1;
         MB = M[addr];
     }
@@ -3872,7 +4038,7 @@ int Mem_write(int flag, int cur_context) {
             nxm_flag = 1;
             return 1;
         }
-        if (sim_brk_summ && sim_brk_test(AB, SWMASK('W')))
+        if (SIM_BRK_TEST(AB, SWMASK('W')))
             watch_stop = 1;
         M[addr] = MB;
     }
@@ -4002,6 +4168,10 @@ if (sim_step != 0) {
 if ((reason = build_dev_tab ()) != SCPE_OK)            /* build, chk dib_tab */
     return reason;
 
+#if KI | KL
+/* Memory or TLB may have been changed from the console */
+fast_flush();
+#endif
 
 /* Main instruction fetch/decode loop: check clock queue, intr, trap, bkpt */
    f_load_pc = 1;
@@ -4042,7 +4212,7 @@ if ((reason = build_dev_tab ()) != SCPE_OK)            /* build, chk dib_tab */
          }
     }
 
-    if (sim_brk_summ && f_load_pc && sim_brk_test(PC, SWMASK('E'))) {
+    if (f_load_pc && SIM_BRK_TEST(PC, SWMASK('E'))) {
          reason = STOP_IBKPT;
          break;
     }
@@ -4685,6 +4855,7 @@ unasign:
                   dbr2 = MB;
                   for (f = 0; f < 512; f++)
                       u_tlb[f] = 0;
+                  fast_flush();
                   break;
               }
               goto unasign;
@@ -10094,6 +10265,7 @@ for(i=0; i < 128; dev_irq[i++] = 0);
 sim_brk_types = SWMASK('E') | SWMASK('W') | SWMASK('R');
 sim_brk_dflt = SWMASK ('E');
 sim_clock_precalibrate_commands = pdp10_clock_precalibrate_commands;
+sim_register_memory (&cpu_unit[0], M, sizeof (M[0]));
 sim_rtcn_init_unit (&cpu_unit[0], cpu_unit[0].wait, TMR_RTC);
 sim_activate(&cpu_unit[0], 10000);
 #if MPX_DEV
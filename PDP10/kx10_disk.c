@@ -66,132 +66,246 @@ static struct disk_formats fmts[] = {
     {0, 0},
 };
 
+/*
+ * Block cache.
+ *
+ * Each attached unit keeps the most recently used DISK_CACHE_BLKS blocks
+ * of DISK_BLK_WDS words in memory. Sector transfers are copied to and from
+ * the cache, and the container is read a whole block at a time, so a
+ * sequential scan costs one host read per block instead of a seek and a
+ * read per sector. Modified words are written back when their block is
+ * replaced, when the simulator stops (through the unit io_flush routine)
+ * and when the unit is detached.
+ */
+
+#define DISK_BLK_WDS    4096             /* Words per cache block */
+#define DISK_CACHE_BLKS 64               /* Cache blocks per unit */
+
+#define CACHE           up8              /* Unit cache */
+
+struct disk_blk {
+    int32       blk;                     /* Block number, -1 if empty */
+    uint32      lru;                     /* Time of last use */
+    int         lo;                      /* First modified word */
+    int         hi;                      /* Last modified word + 1, 0 if clean */
+    uint64      data[DISK_BLK_WDS];
+};
+
+struct disk_cache {
+    uint32           clock;              /* Use counter */
+    struct disk_blk  *last;              /* Most recently used block */
+    struct disk_blk  blks[DISK_CACHE_BLKS];
+};
+
+/*
+ * Convert between 9 byte KLH10 pairs and words. Each pair is handled as
+ * one 64 bit and one 8 bit quantity rather than byte by byte.
+ */
+static void
+disk_unpack(int fmt, uint64 *buffer, const uint8 *conv_buff, int wps)
+{
+    const uint8 *cp = conv_buff;
+    uint64       temp;
+    int          wp;
+
+    for (wp = 0; wp < wps; wp += 2, cp += 9) {
+        if (fmt == DBD9) {
+            temp = ((uint64)cp[0] << 56) | ((uint64)cp[1] << 48) |
+                   ((uint64)cp[2] << 40) | ((uint64)cp[3] << 32) |
+                   ((uint64)cp[4] << 24) | ((uint64)cp[5] << 16) |
+                   ((uint64)cp[6] << 8)  | ((uint64)cp[7]);
+            buffer[wp] = temp >> 28;
+            buffer[wp+1] = ((temp & 01777777777) << 8) | cp[8];
+        } else {
+            temp = ((uint64)cp[0])       | ((uint64)cp[1] << 8) |
+                   ((uint64)cp[2] << 16) | ((uint64)cp[3] << 24) |
+                   ((uint64)cp[4] << 32) | ((uint64)cp[5] << 40) |
+                   ((uint64)cp[6] << 48) | ((uint64)cp[7] << 56);
+            buffer[wp] = temp & FMASK;
+            buffer[wp+1] = (temp >> 36) | ((uint64)cp[8] << 28);
+        }
+    }
+}
+
+static void
+disk_pack(int fmt, uint8 *conv_buff, const uint64 *buffer, int wps)
+{
+    uint8       *cp = conv_buff;
+    uint64       temp;
+    int          wp;
+    int          i;
+
+    for (wp = 0; wp < wps; wp += 2, cp += 9) {
+        if (fmt == DBD9) {
+            temp = (buffer[wp] << 28) | ((buffer[wp+1] & FMASK) >> 8);
+            for (i = 0; i < 8; i++)
+                cp[i] = (uint8)(temp >> (56 - (i * 8)));
+            cp[8] = (uint8)(buffer[wp+1] & 0xff);
+        } else {
+            temp = (buffer[wp] & FMASK) | (buffer[wp+1] << 36);
+            for (i = 0; i < 8; i++)
+                cp[i] = (uint8)(temp >> (i * 8));
+            cp[8] = (uint8)((buffer[wp+1] >> 28) & 0xff);
+        }
+    }
+}
+
+/* Read wc words starting at word wa from the container */
+static void
+disk_rdwds(UNIT *uptr, uint64 *buffer, t_addr wa, int wc)
+{
+    int      fmt = GET_FMT(uptr->flags);
+    size_t   n;
+    uint8    conv_buff[(DISK_BLK_WDS / 2) * 9];
+
+    if (fmt == SIMH) {
+        (void)sim_fseeko(uptr->fileref, (t_offset)wa * sizeof(uint64), SEEK_SET);
+        n = sim_fread (buffer, sizeof(uint64), wc, uptr->fileref);
+        while (n < (size_t)wc)
+            buffer[n++] = 0;
+        return;
+    }
+    (void)sim_fseeko(uptr->fileref, (t_offset)(wa / 2) * 9, SEEK_SET);
+    n = sim_fread (conv_buff, 1, (wc / 2) * 9, uptr->fileref);
+    memset(&conv_buff[n], 0, ((wc / 2) * 9) - n);
+    disk_unpack(fmt, buffer, conv_buff, wc);
+}
+
+/* Write wc words starting at word wa to the container */
+static t_stat
+disk_wrwds(UNIT *uptr, uint64 *buffer, t_addr wa, int wc)
+{
+    int      fmt = GET_FMT(uptr->flags);
+    size_t   n;
+    uint8    conv_buff[(DISK_BLK_WDS / 2) * 9];
+
+    if (fmt == SIMH) {
+        (void)sim_fseeko(uptr->fileref, (t_offset)wa * sizeof(uint64), SEEK_SET);
+        n = sim_fwrite (buffer, sizeof(uint64), wc, uptr->fileref);
+        return (n == (size_t)wc) ? SCPE_OK : SCPE_IOERR;
+    }
+    disk_pack(fmt, conv_buff, buffer, wc);
+    (void)sim_fseeko(uptr->fileref, (t_offset)(wa / 2) * 9, SEEK_SET);
+    n = sim_fwrite (conv_buff, 1, (wc / 2) * 9, uptr->fileref);
+    return (n == (size_t)((wc / 2) * 9)) ? SCPE_OK : SCPE_IOERR;
+}
+
+/* Write back the modified part of a block. Pairs are kept whole */
+static t_stat
+disk_blk_clean(UNIT *uptr, struct disk_blk *bp)
+{
+    int      lo = bp->lo & ~1;
+    int      hi = (bp->hi + 1) & ~1;
+    t_stat   r;
+
+    if (bp->hi == 0)
+        return SCPE_OK;
+    r = disk_wrwds(uptr, &bp->data[lo], ((t_addr)bp->blk * DISK_BLK_WDS) + lo,
+                   hi - lo);
+    bp->lo = bp->hi = 0;
+    return r;
+}
+
+/* Find block in cache, loading it if needed */
+static struct disk_blk *
+disk_blk_get(UNIT *uptr, struct disk_cache *dc, int32 blk)
+{
+    struct disk_blk *bp = dc->last;
+    struct disk_blk *victim;
+    int              i;
+
+    if (bp == NULL || bp->blk != blk) {
+        victim = bp = &dc->blks[0];
+        for (i = 0; i < DISK_CACHE_BLKS; i++) {
+            if (dc->blks[i].blk == blk) {
+                bp = &dc->blks[i];
+                break;
+            }
+            if (dc->blks[i].lru < victim->lru)
+                victim = &dc->blks[i];
+        }
+        if (i == DISK_CACHE_BLKS) {
+            bp = victim;
+            (void)disk_blk_clean(uptr, bp);
+            bp->blk = blk;
+            disk_rdwds(uptr, bp->data, (t_addr)blk * DISK_BLK_WDS, DISK_BLK_WDS);
+        }
+        dc->last = bp;
+    }
+    bp->lru = ++dc->clock;
+    return bp;
+}
+
+/* Write back all modified blocks */
+static void
+disk_flush(UNIT *uptr)
+{
+    struct disk_cache *dc = (struct disk_cache *)uptr->CACHE;
+    int                i;
+
+    if (dc == NULL)
+        return;
+    for (i = 0; i < DISK_CACHE_BLKS; i++)
+        (void)disk_blk_clean(uptr, &dc->blks[i]);
+    fflush(uptr->fileref);
+}
+
 t_stat 
 disk_read(UNIT *uptr, uint64 *buffer, int sector, int wps)
 {
-    int      da;
-    int      wc;
-    int      bc;
-    int      wp;
-    uint64   temp;
-    uint8    conv_buff[2048];
-    switch(GET_FMT(uptr->flags)) {
-    case SIMH:
-            da = sector * wps;
-            (void)sim_fseek(uptr->fileref, da * sizeof(uint64), SEEK_SET);
-            wc = sim_fread (buffer, sizeof(uint64), wps, uptr->fileref);
-            while (wc < wps)
-                buffer[wc++] = 0;
-            break;
-    case DBD9:
-            bc = (wps / 2) * 9;
-            da = sector * bc;
-            (void)sim_fseek(uptr->fileref, da, SEEK_SET);
-            wc = sim_fread (&conv_buff, 1, bc, uptr->fileref);
-            while (wc < bc)
-                 conv_buff[wc++] = 0;
-            for (wp = wc = 0; wp < wps;) {
-                temp = ((uint64)conv_buff[wc++]) << 28;
-                temp |= ((uint64)conv_buff[wc++]) << 20;
-                temp |= ((uint64)conv_buff[wc++]) << 12;
-                temp |= ((uint64)conv_buff[wc++]) << 4;
-                temp |= ((uint64)conv_buff[wc]) >> 4;
-                buffer[wp++] = temp;
-                temp = ((uint64)conv_buff[wc++] & 0xf) << 32;
-                temp |= ((uint64)conv_buff[wc++]) << 24;
-                temp |= ((uint64)conv_buff[wc++]) << 16;
-                temp |= ((uint64)conv_buff[wc++]) << 8;
-                temp |= ((uint64)conv_buff[wc++]);
-                buffer[wp++] = temp;
-            }
-            break;
-
-    case DLD9:
-            bc = (wps / 2) * 9;
-            da = sector * bc;
-            (void)sim_fseek(uptr->fileref, da, SEEK_SET);
-            wc = sim_fread (&conv_buff, 1, bc, uptr->fileref);
-            while (wc < bc)
-                 conv_buff[wc++] = 0;
-            for (wp = wc = 0; wp < wps;) {
-                temp = ((uint64)conv_buff[wc++]);
-                temp |= ((uint64)conv_buff[wc++]) << 8;
-                temp |= ((uint64)conv_buff[wc++]) << 16;
-                temp |= ((uint64)conv_buff[wc++]) << 24;
-                temp |= ((uint64)conv_buff[wc] & 0xf) << 32;
-                buffer[wp++] = temp;
-                temp = ((uint64)conv_buff[wc++] & 0xf0) >> 4;
-                temp |= ((uint64)conv_buff[wc++]) << 4;
-                temp |= ((uint64)conv_buff[wc++]) << 12;
-                temp |= ((uint64)conv_buff[wc++]) << 20;
-                temp |= ((uint64)conv_buff[wc++]) << 28;
-                buffer[wp++] = temp;
-            }
-            break;
-     }
-     return SCPE_OK;
+    struct disk_cache *dc = (struct disk_cache *)uptr->CACHE;
+    struct disk_blk   *bp;
+    t_addr             wa = (t_addr)sector * wps;
+    int                off;
+    int                wc;
+
+    if (dc == NULL) {
+        disk_rdwds(uptr, buffer, wa, wps);
+        return SCPE_OK;
+    }
+    while (wps > 0) {
+        bp = disk_blk_get(uptr, dc, (int32)(wa / DISK_BLK_WDS));
+        off = (int)(wa % DISK_BLK_WDS);
+        wc = DISK_BLK_WDS - off;
+        if (wc > wps)
+            wc = wps;
+        memcpy(buffer, &bp->data[off], wc * sizeof(uint64));
+        buffer += wc;
+        wa += wc;
+        wps -= wc;
+    }
+    return SCPE_OK;
 }
 
 t_stat
 disk_write(UNIT *uptr, uint64 *buffer, int sector, int wps)
 {
-    int      da;
-    int      wc;
-    int      bc;
-    int      wp;
-    uint64   temp;
-    uint8    conv_buff[2048];
-    switch(GET_FMT(uptr->flags)) {
-    case SIMH:
-            da = sector * wps;
-            (void)sim_fseek(uptr->fileref, da * sizeof(uint64), SEEK_SET);
-            wc = sim_fwrite (buffer, sizeof(uint64), wps, uptr->fileref);
-            break;
-    case DBD9:
-            bc = (wps / 2) * 9;
-            for (wp = wc = 0; wp < wps;) {
-                temp = buffer[wp++];
-                conv_buff[wc++] = (uint8)((temp >> 28) & 0xff);
-                conv_buff[wc++] = (uint8)((temp >> 20) & 0xff);
-                conv_buff[wc++] = (uint8)((temp >> 12) & 0xff);
-                conv_buff[wc++] = (uint8)((temp >> 4) & 0xff);
-                conv_buff[wc] = (uint8)((temp & 0xf) << 4);
-                temp = buffer[wp++];
-                conv_buff[wc++] |= (uint8)((temp >> 32) & 0xf);
-                conv_buff[wc++] = (uint8)((temp >> 24) & 0xff);
-                conv_buff[wc++] = (uint8)((temp >> 16) & 0xff);
-                conv_buff[wc++] = (uint8)((temp >> 8) & 0xff);
-                conv_buff[wc++] = (uint8)(temp & 0xff);
-            }
-            da = sector * bc;
-            (void)sim_fseek(uptr->fileref, da, SEEK_SET);
-            wc = sim_fwrite (&conv_buff, 1, bc, uptr->fileref);
-            return SCPE_OK;
-    case DLD9:
-            bc = (wps / 2) * 9;
-            for (wp = wc = 0; wp < wps;) {
-                temp = buffer[wp++];
-                conv_buff[wc++] = (uint8)(temp & 0xff);
-                conv_buff[wc++] = (uint8)((temp >> 8) & 0xff);
-                conv_buff[wc++] = (uint8)((temp >> 16) & 0xff);
-                conv_buff[wc++] = (uint8)((temp >> 24) & 0xff);
-                conv_buff[wc] = (uint8)((temp >> 32)  & 0xf);
-                temp = buffer[wp++];
-                conv_buff[wc++] |= (uint8)((temp << 4) & 0xf0);
-                conv_buff[wc++] = (uint8)((temp >> 4) & 0xff);
-                conv_buff[wc++] = (uint8)((temp >> 12) & 0xff);
-                conv_buff[wc++] = (uint8)((temp >> 20) & 0xff);
-                conv_buff[wc++] = (uint8)((temp >> 28) & 0xff);
-            }
-            da = sector * bc;
-            (void)sim_fseek(uptr->fileref, da, SEEK_SET);
-            wc = sim_fwrite (&conv_buff, 1, bc, uptr->fileref);
-            return SCPE_OK;
+    struct disk_cache *dc = (struct disk_cache *)uptr->CACHE;
+    struct disk_blk   *bp;
+    t_addr             wa = (t_addr)sector * wps;
+    int                off;
+    int                wc;
+
+    if (dc == NULL)
+        return disk_wrwds(uptr, buffer, wa, wps);
+    while (wps > 0) {
+        bp = disk_blk_get(uptr, dc, (int32)(wa / DISK_BLK_WDS));
+        off = (int)(wa % DISK_BLK_WDS);
+        wc = DISK_BLK_WDS - off;
+        if (wc > wps)
+            wc = wps;
+        memcpy(&bp->data[off], buffer, wc * sizeof(uint64));
+        if (bp->hi == 0 || off < bp->lo)
+            bp->lo = off;
+        if (off + wc > bp->hi)
+            bp->hi = off + wc;
+        buffer += wc;
+        wa += wc;
+        wps -= wc;
     }
     return SCPE_OK;
 }
 
-
 /* Set disk format */
 t_stat disk_set_fmt (UNIT *uptr, int32 val, CONST char *cptr, void *desc)
 {
@@ -232,6 +346,8 @@ t_stat disk_attach (UNIT *uptr, CONST char *cptr)
 {
     t_stat r;
     char                 gbuf[30];
+    struct disk_cache   *dc;
+    int                  i;
 
     /* Reset to SIMH format on attach */
     uptr->flags &= ~UNIT_FMT;
@@ -247,6 +363,15 @@ t_stat disk_attach (UNIT *uptr, CONST char *cptr)
     r = attach_unit (uptr, cptr);
     if (r != SCPE_OK)
         return r;
+    dc = (struct disk_cache *)calloc(1, sizeof(struct disk_cache));
+    if (dc == NULL) {
+        (void)detach_unit (uptr);
+        return SCPE_MEM;
+    }
+    for (i = 0; i < DISK_CACHE_BLKS; i++)
+        dc->blks[i].blk = -1;
+    uptr->CACHE = (void *)dc;
+    uptr->io_flush = &disk_flush;
     return SCPE_OK;
 }
 
@@ -254,6 +379,11 @@ t_stat disk_attach (UNIT *uptr, CONST char *cptr)
 
 t_stat disk_detach (UNIT *uptr)
 {
+    if (uptr->flags & UNIT_ATT)
+        disk_flush (uptr);
+    free (uptr->CACHE);
+    uptr->CACHE = NULL;
+    uptr->io_flush = NULL;
     return detach_unit (uptr);
 }
 
@@ -22,6 +22,7 @@
 */
 
 #include "kx10_defs.h"
+#include "kx10_disk.h"
 
 #ifndef NUM_DEVS_RC
 #define NUM_DEVS_RC 0
@@ -354,9 +355,9 @@ t_stat rc_svc (UNIT *uptr)
    int           wr    = (uptr->UFLAGS & 1);
    int           seg_size = rc_drv_tab[dtype].wd_seg;
    struct df10  *df10  = &rc_df10[ctlr];
-   int           tmp, wc;
+   int           tmp;
    DEVICE       *dptr;
-   t_stat        err, r;
+   t_stat        r;
 
    dptr = rc_devs[ctlr];
    /* Check if we need to seek */
@@ -387,14 +388,10 @@ t_stat rc_svc (UNIT *uptr)
         if (!wr) {
                  /* Read the block */
            int da;
-           da = ((cyl * rc_drv_tab[dtype].seg) + seg) * seg_size;
-           err = sim_fseek(uptr->fileref, da * sizeof(uint64), SEEK_SET);
-           wc = sim_fread (&rc_buf[ctlr][0], sizeof(uint64),
-                        seg_size, uptr->fileref);
+           da = (cyl * rc_drv_tab[dtype].seg) + seg;
+           (void)disk_read(uptr, &rc_buf[ctlr][0], da, seg_size);
            sim_debug(DEBUG_DETAIL, dptr, "HK %d Read %d %d %d %x\n",
-                ctlr, da, cyl, seg, uptr->UFLAGS << 1 );
-           for (; wc < seg_size; wc++)
-                rc_buf[ctlr][wc] = 0;
+                ctlr, da * seg_size, cyl, seg, uptr->UFLAGS << 1 );
          }
          uptr->DATAPTR = 0;
          df10->status |= SCRCHCMP;
@@ -423,12 +420,10 @@ t_stat rc_svc (UNIT *uptr)
                  rc_buf[ctlr][uptr->DATAPTR] = 0;
                  uptr->DATAPTR++;
              }
-             da = ((cyl * rc_drv_tab[dtype].seg) + seg) * seg_size;
+             da = (cyl * rc_drv_tab[dtype].seg) + seg;
              sim_debug(DEBUG_DETAIL, dptr, "HK %d Write %d %d %d %x %d\n",
-                  ctlr, da, cyl, seg, uptr->UFLAGS << 1, uptr->DATAPTR );
-             err = sim_fseek(uptr->fileref, da * sizeof(uint64), SEEK_SET);
-             wc = sim_fwrite(&rc_buf[ctlr][0],sizeof(uint64),
-                        seg_size, uptr->fileref);
+                  ctlr, da * seg_size, cyl, seg, uptr->UFLAGS << 1, uptr->DATAPTR );
+             (void)disk_write(uptr, &rc_buf[ctlr][0], da, seg_size);
         }
         uptr->DATAPTR = -1;
         seg++;
@@ -514,8 +509,7 @@ rc_boot(int32 unit_num, DEVICE * dptr)
    wps = rc_drv_tab[dtype].wd_seg;
    for (sect = 4; sect <= 7; sect++) {
        seg = (sect * 128) / wps;
-       (void)sim_fseek(uptr->fileref, (seg * wps) * sizeof(uint64), SEEK_SET);
-       (void)sim_fread (&rc_buf[0][0], sizeof(uint64), wps, uptr->fileref);
+       (void)disk_read(uptr, &rc_buf[0][0], seg, wps);
        ptr = 0;
        for(wc = wps; wc > 0; wc--) {
           M[addr++] = rc_buf[0][ptr++];
@@ -532,7 +526,7 @@ t_stat rc_attach (UNIT *uptr, CONST char *cptr)
 t_stat r;
 
 uptr->capac = rc_drv_tab[GET_DTYPE (uptr->flags)].size;
-r = attach_unit (uptr, cptr);
+r = disk_attach (uptr, cptr);
 if (r != SCPE_OK || (sim_switches & SIM_SW_REST) != 0)
     return r;
 uptr->CUR_CYL = 0;
@@ -548,7 +542,7 @@ if (!(uptr->flags & UNIT_ATT))                          /* attached? */
     return SCPE_OK;
 if (sim_is_active (uptr))                              /* unit active? */
     sim_cancel (uptr);                                  /* cancel operation */
-return detach_unit (uptr);
+return disk_detach (uptr);
 }
 
 t_stat rc_help (FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, const char *cptr)
@@ -22,6 +22,7 @@
 */
 
 #include "kx10_defs.h"
+#include "kx10_disk.h"
 
 #ifndef NUM_DEVS_DSK
 #define NUM_DEVS_DSK 0
@@ -261,10 +262,8 @@ dsk_svc (UNIT *uptr)
    int           ctlr  = (dsk_addr >> 16) & 03;
    int           cyl;
    int           sec;
-   int           wc;
    uint64        data;
    DEVICE       *dptr;
-   t_stat        err;
 
    dptr = &dsk_dev;
 
@@ -279,11 +278,9 @@ dsk_svc (UNIT *uptr)
            sec = dsk_addr & 077;
            if (sec > DSK_SECS)
               sec -= DSK_SECS;
-           da = (sec + (cyl * DSK_SECS)) * DSK_WDS;
-           err = sim_fseek(uptr->fileref, da * sizeof(uint64), SEEK_SET);
-           (void)sim_fwrite (&dsk_buf[0], sizeof(uint64),
-                        DSK_WDS, uptr->fileref);
-           sim_debug(DEBUG_DETAIL, dptr, "DSK %d Write %d %d\n", ctlr, da, cyl);
+           da = sec + (cyl * DSK_SECS);
+           (void)disk_write(uptr, &dsk_buf[0], da, DSK_WDS);
+           sim_debug(DEBUG_DETAIL, dptr, "DSK %d Write %d %d\n", ctlr, da * DSK_WDS, cyl);
        }
        uptr->DATAPTR = 0;
        sec = (dsk_addr + 1) & 077;
@@ -337,13 +334,9 @@ dsk_svc (UNIT *uptr)
            sec = dsk_addr & 077;
            if (sec > DSK_SECS)
               sec -= DSK_SECS;
-           da = (sec + (cyl * DSK_SECS)) * DSK_WDS;
-           err = sim_fseek(uptr->fileref, da * sizeof(uint64), SEEK_SET);
-           wc = sim_fread (&dsk_buf[0], sizeof(uint64),
-                        DSK_WDS, uptr->fileref);
-           sim_debug(DEBUG_DETAIL, dptr, "DSK %d Read %d %d\n", ctlr, da, cyl);
-           for (; wc < DSK_WDS; wc++)
-                dsk_buf[wc] = 0;
+           da = sec + (cyl * DSK_SECS);
+           (void)disk_read(uptr, &dsk_buf[0], da, DSK_WDS);
+           sim_debug(DEBUG_DETAIL, dptr, "DSK %d Read %d %d\n", ctlr, da * DSK_WDS, cyl);
        } else if (dsk_cmd & WR_CMD) {
            /* Check if we can write disk */
            if (uptr->flags & UNIT_WLK) {
@@ -472,7 +465,7 @@ dsk_attach (UNIT *uptr, CONST char *cptr)
 {
      t_stat r;
 
-     r = attach_unit (uptr, cptr);
+     r = disk_attach (uptr, cptr);
      if (r != SCPE_OK)
          return r;
      uptr->CUR_CYL = 0;
@@ -488,7 +481,7 @@ dsk_detach (UNIT *uptr)
         return SCPE_OK;
     if (sim_is_active (uptr))                              /* unit active? */
         sim_cancel (uptr);                                  /* cancel operation */
-    return detach_unit (uptr);
+    return disk_detach (uptr);
 }
 
 t_stat
@@ -99,6 +99,14 @@ uint16      loading;                        /* set when booting */
 
 #define get_chan(chsa)  ((chsa>>8)&0x7f)    /* get channel number from ch/sa */
 
+/* channel programs that may have a channel end pending, one bit per ch/sa */
+/* and one bit per channel with any ch/sa bit set.  Set whenever a chanp */
+/* gets STATUS_CEND, cleared by scan_chan once it has looked at the entry */
+uint32  chan_cend_map[MAX_CHAN/32];         /* channels with a marked ch/sa */
+uint32  chsa_cend_map[MAX_DEV/32];          /* ch/sa with channel end posted */
+#define CEND_MARK(chsa)  { chsa_cend_map[(chsa) >> 5] |= (1u << ((chsa) & 0x1f)); \
+                           chan_cend_map[get_chan(chsa) >> 5] |= (1u << (get_chan(chsa) & 0x1f)); }
+
 /* forward definitions */
 CHANP *find_chanp_ptr(uint16 chsa);             /* find chanp pointer */
 UNIT *find_unit_ptr(uint16 chsa);               /* find unit pointer */
@@ -594,6 +602,7 @@ loop:
         /* see if bad status */
         if (chp->chan_status & (STATUS_ATTN|STATUS_CHECK|STATUS_EXPT)) {
             chp->chan_status |= STATUS_CEND;        /* channel end status */
+            CEND_MARK(chp->chan_dev);               /* let scan_chan find it */
             chp->ccw_flags = 0;                     /* no flags */
             chp->ccw_cmd = 0;                       /* stop IOCD processing */
             irq_pend = 1;                           /* int coming */
@@ -606,6 +615,7 @@ loop:
         /* see if command completed */
         if (chp->chan_status & (STATUS_DEND|STATUS_CEND)) {
             chp->chan_status |= STATUS_CEND;        /* set channel end status */
+            CEND_MARK(chp->chan_dev);               /* let scan_chan find it */
             chp->chan_byte = BUFF_NEWCMD;           /* ready for new cmd */
             chp->ccw_cmd = 0;                       /* stop IOCD processing */
             irq_pend = 1;                           /* int coming */
@@ -637,6 +647,7 @@ int chan_read_byte(uint16 chsa, uint8 *data)
     if (chp->ccw_count == 0) {                      /* see if more data required */
          if ((chp->ccw_flags & FLAG_DC) == 0) {     /* see if Data Chain */
             chp->chan_status |= STATUS_CEND;        /* no, end of data */
+            CEND_MARK(chp->chan_dev);               /* let scan_chan find it */
             chp->chan_byte = BUFF_CHNEND;           /* buffer end too */
             sim_debug(DEBUG_EXP, &cpu_dev,
                 "chan_read_byte no DC chan end, cnt %04x addr %06x chan %04x\n",
@@ -688,6 +699,7 @@ int test_write_byte_end(uint16 chsa)
         }
         if ((chp->ccw_flags & FLAG_DC) == 0) {      /* see if we have data chaining */
             chp->chan_status |= STATUS_CEND;        /* no, end of data */
+            CEND_MARK(chp->chan_dev);               /* let scan_chan find it */
             chp->chan_byte = BUFF_CHNEND;           /* thats all the data we want */
             return 1;                               /* return done */
         }
@@ -733,6 +745,7 @@ int chan_write_byte(uint16 chsa, uint8 *data)
         if ((chp->ccw_flags & FLAG_DC) == 0) {      /* see if we have data chaining */
             sim_debug(DEBUG_EXP, &cpu_dev, "chan_write_byte no DC\n");
             chp->chan_status |= STATUS_CEND;        /* no, end of data */
+            CEND_MARK(chp->chan_dev);               /* let scan_chan find it */
             chp->chan_byte = BUFF_CHNEND;           /* thats all the data we want */
             return 1;                               /* return error */
         } else {
@@ -841,6 +854,7 @@ void chan_end(uint16 chsa, uint16 flags) {
         chp->chan_byte = BUFF_EMPTY;                /* we are empty now */
     }
     chp->chan_status |= STATUS_CEND;                /* set channel end */
+    CEND_MARK(chp->chan_dev);                       /* let scan_chan find it */
     chp->chan_status |= ((uint16)flags);            /* add in the callers flags */
 //  chp->ccw_cmd = 0;                               /* reset the completed channel command */
 
@@ -1679,25 +1693,30 @@ uint32 scan_chan(int *ilev) {
     uint32      chan_icba;                          /* int level context block address */
     CHANP       *chp;                               /* channel prog pointer */
     DIB         *dibp;                              /* DIB pointer */
+    uint32      cw, sw;                             /* map words */
+    uint32      bit;                                /* map bit */
 
     if (irq_pend == 1) {                            /* pending int? */
-        /* see if we have a channel completed */
-    /* loop through all the channels/units for channel with pending I/O completion */
-    for (i = 0; sim_devices[i] != NULL; i++) {
-        DEVICE  *dptr = sim_devices[i];             /* get pointer to configured device */
-        DIB     *dibp = (DIB *)dptr->ctxt;          /* get pointer to DIB for this device */
-        UNIT    *uptr = dptr->units;                /* get pointer to units defined for this device */
-
-        if (dibp == NULL)                           /* If no DIB, not channel device */
-            continue;
-        if (dptr->flags & DEV_DIS) {                /* Skip disabled devices */
-            continue;
-        }
-        if ((chp = (CHANP *)dibp->chan_prg) == NULL)/* must have channel information for each device */
+    /* see if we have a channel completed */
+    /* loop through the marked channels/units for channel with pending I/O completion */
+    for (i = 0; i < MAX_CHAN; i++) {
+        cw = i >> 5;                                /* channel map word */
+        bit = 1u << (i & 0x1f);                     /* channel map bit */
+        if ((chan_cend_map[cw] & bit) == 0)         /* nothing posted on channel */
             continue;
-        /* Check if address is in unit or dev entry */
-        for (j = 0; j < dibp->numunits; j++) {      /* loop through unit entries */
-            chsa = GET_UADDR(uptr->u3);             /* ch/sa value */
+        chan_cend_map[cw] &= ~bit;                  /* remarked below if still pending */
+        for (j = 0; j < SUB_CHANS; j++) {           /* loop through ch/sa entries */
+            chsa = (i << 8) | j;                    /* ch/sa value */
+            sw = chsa >> 5;                         /* ch/sa map word */
+            if (chsa_cend_map[sw] == 0) {           /* none in these 32 */
+                j |= 0x1f;                          /* skip to next word */
+                continue;
+            }
+            if ((chsa_cend_map[sw] & (1u << (chsa & 0x1f))) == 0)
+                continue;
+            chsa_cend_map[sw] &= ~(1u << (chsa & 0x1f));  /* looked at now */
+            if ((chp = find_chanp_ptr(chsa)) == NULL)   /* device gone */
+                continue;
 
             /* If channel end, check if we should continue */
             if (chp->chan_status & STATUS_CEND) {   /* do we have channel end */
@@ -1714,8 +1733,10 @@ uint32 scan_chan(int *ilev) {
                             "scan_chan loading %02x dev end & CC chsa %04x status %04x\n",
                             loading, chsa, chp->chan_status);
                         (void)load_ccw(chp, 1);     /* go load the next IOCB */
-                    } else
+                    } else {
+                        CEND_MARK(chp->chan_dev);   /* look again */
                         irq_pend = 1;               /* still pending int */
+                    }
                 } else {
                     /* we have channel end and no CC flag, end command */
                     chsa = chp->chan_dev;           /* get the chan/sa */
@@ -1723,6 +1744,7 @@ uint32 scan_chan(int *ilev) {
                         "scan_chan loading %02x chan end & no CC chsa %04x status %04x\n",
                         loading, chsa, chp->chan_status);
                     dev_status[chsa] = 0;           /* no device status anymore */
+                    chan_cend_map[cw] |= bit;       /* rest not looked at yet */
                     /* handle case where we are loading the O/S on boot */
                     if (loading) {
                         if (chp->chan_status & 0x3f03) {    /* check if any channel errors */
@@ -1742,8 +1764,12 @@ uint32 scan_chan(int *ilev) {
                     return 0;                       /* just return */
                 }
             }
-            uptr++;                                 /* next UNIT pointer */
-            chp++;                                  /* next CHANP pointer */
+        }
+        for (j = 0; j < SUB_CHANS/32; j++) {        /* any remarked while scanning? */
+            if (chsa_cend_map[((i << 8) >> 5) + j] != 0) {
+                chan_cend_map[cw] |= bit;           /* yes, look again next time */
+                break;
+            }
         }
     }
     }
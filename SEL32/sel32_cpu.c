@@ -1987,7 +1987,7 @@ wait_loop:
         }
 
         /* stop simulator if user break requested */
-        if (sim_brk_summ && sim_brk_test(PC, SWMASK('E'))) {
+        if (SIM_BRK_TEST(PC, SWMASK('E'))) {
             reason = STOP_IBKPT;
             break;
         }
@@ -2213,7 +2213,7 @@ exec:
             PC, PSD1, PSD2, IR);
 
         /* check for breakpoint request */
-        if (sim_brk_summ && sim_brk_test(PC, SWMASK('E'))) {
+        if (SIM_BRK_TEST(PC, SWMASK('E'))) {
             reason = STOP_IBKPT;
             break;
         }
@@ -0,0 +1,199 @@
+/* sel32_dcache.c: SEL-32 disk track cache
+
+   Copyright (c) 2018-2020, James C. Bevier
+   Portions provided by Richard Cornwell and other SIMH contributers
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+   JAMES C. BEVIER BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+   IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   Common disk back end for the disk processor, HSDP and SCFI controllers.
+   Each attached unit gets a small cache of whole tracks, pointed to by up7.
+   The controllers keep the byte position interface they used with the
+   disk file: dcache_seek() sets the position, dcache_read() and
+   dcache_write() transfer data and advance it.  A track is read from the
+   file the first time any sector on it is used, and only the part of a
+   track that was written is put back, when the track is reused, when the
+   simulator stops (io_flush) and on detach.
+*/
+
+#include "sel32_defs.h"
+
+#define DCACHE_TRKS     16                      /* tracks cached per unit */
+
+/* one cached track */
+struct dtrk_t {
+    int32       trk;                            /* track number, -1 if empty */
+    uint32      lru;                            /* time of last use */
+    uint32      lo;                             /* first dirty byte */
+    uint32      hi;                             /* last dirty byte + 1, 0 if clean */
+    uint8       *data;                          /* track data */
+};
+
+/* cache held in up7 */
+struct dcache_t {
+    uint32      tsize;                          /* track size in bytes */
+    t_addr      pos;                            /* current byte position */
+    uint32      clock;                          /* lru counter */
+    struct dtrk_t   trk[DCACHE_TRKS];           /* cached tracks */
+};
+
+/* write back the dirty part of a track */
+static void dcache_clean(UNIT *uptr, struct dcache_t *dc, struct dtrk_t *tp)
+{
+    if (tp->hi == 0)
+        return;                                 /* nothing to write */
+    sim_fseek(uptr->fileref, (t_addr)tp->trk * dc->tsize + tp->lo, SEEK_SET);
+    sim_fwrite(&tp->data[tp->lo], 1, tp->hi - tp->lo, uptr->fileref);
+    tp->lo = tp->hi = 0;
+}
+
+/* find a track in the cache, loading it if needed */
+static struct dtrk_t *dcache_get(UNIT *uptr, struct dcache_t *dc, int32 trk)
+{
+    struct dtrk_t   *tp = &dc->trk[0];
+    uint32          len;
+    int             i;
+
+    for (i = 0; i < DCACHE_TRKS; i++) {
+        if (dc->trk[i].trk == trk) {
+            tp = &dc->trk[i];                   /* found it */
+            tp->lru = ++dc->clock;
+            return tp;
+        }
+        if (dc->trk[i].lru < tp->lru)
+            tp = &dc->trk[i];                   /* oldest so far */
+    }
+    /* reuse the oldest track */
+    dcache_clean(uptr, dc, tp);
+    tp->trk = trk;
+    tp->lru = ++dc->clock;
+    sim_fseek(uptr->fileref, (t_addr)trk * dc->tsize, SEEK_SET);
+    len = sim_fread(tp->data, 1, dc->tsize, uptr->fileref);
+    if (len < dc->tsize)                        /* past end of file reads zero */
+        memset(&tp->data[len], 0, dc->tsize - len);
+    return tp;
+}
+
+/* set the byte position for the next transfer */
+void dcache_seek(UNIT *uptr, t_addr pos)
+{
+    struct dcache_t *dc = (struct dcache_t *)uptr->up7;
+
+    if (dc != NULL)
+        dc->pos = pos;
+}
+
+/* read len bytes at the current position, return bytes read */
+uint32 dcache_read(UNIT *uptr, uint8 *buf, uint32 len)
+{
+    struct dcache_t *dc = (struct dcache_t *)uptr->up7;
+    struct dtrk_t   *tp;
+    uint32          off, cnt, done = 0;
+
+    if (dc == NULL)
+        return 0;
+    while (done < len) {
+        tp = dcache_get(uptr, dc, (int32)(dc->pos / dc->tsize));
+        off = (uint32)(dc->pos % dc->tsize);
+        cnt = dc->tsize - off;
+        if (cnt > len - done)
+            cnt = len - done;
+        memcpy(&buf[done], &tp->data[off], cnt);
+        dc->pos += cnt;
+        done += cnt;
+    }
+    return done;
+}
+
+/* write len bytes at the current position, return bytes written */
+uint32 dcache_write(UNIT *uptr, uint8 *buf, uint32 len)
+{
+    struct dcache_t *dc = (struct dcache_t *)uptr->up7;
+    struct dtrk_t   *tp;
+    uint32          off, cnt, done = 0;
+
+    if (dc == NULL)
+        return 0;
+    while (done < len) {
+        tp = dcache_get(uptr, dc, (int32)(dc->pos / dc->tsize));
+        off = (uint32)(dc->pos % dc->tsize);
+        cnt = dc->tsize - off;
+        if (cnt > len - done)
+            cnt = len - done;
+        memcpy(&tp->data[off], &buf[done], cnt);
+        /* grow the dirty range to cover this write */
+        if (tp->hi == 0 || off < tp->lo)
+            tp->lo = off;
+        if (off + cnt > tp->hi)
+            tp->hi = off + cnt;
+        dc->pos += cnt;
+        done += cnt;
+    }
+    return done;
+}
+
+/* write all dirty tracks back to the file */
+void dcache_flush(UNIT *uptr)
+{
+    struct dcache_t *dc = (struct dcache_t *)uptr->up7;
+    int             i;
+
+    if (dc == NULL)
+        return;
+    for (i = 0; i < DCACHE_TRKS; i++)
+        dcache_clean(uptr, dc, &dc->trk[i]);
+    fflush(uptr->fileref);
+}
+
+/* set up the cache for an attached unit, tsize is track size in bytes */
+t_stat dcache_attach(UNIT *uptr, uint32 tsize)
+{
+    struct dcache_t *dc;
+    int             i;
+
+    if ((dc = (struct dcache_t *)calloc(1, sizeof(struct dcache_t))) == 0)
+        return SCPE_MEM;
+    dc->tsize = tsize;
+    for (i = 0; i < DCACHE_TRKS; i++) {
+        dc->trk[i].trk = -1;                    /* nothing loaded yet */
+        if ((dc->trk[i].data = (uint8 *)malloc(tsize)) == 0) {
+            while (i-- > 0)
+                free(dc->trk[i].data);
+            free(dc);
+            return SCPE_MEM;
+        }
+    }
+    uptr->up7 = (void *)dc;
+    uptr->io_flush = dcache_flush;              /* write back when sim stops */
+    return SCPE_OK;
+}
+
+/* write back and release the cache of a unit */
+void dcache_detach(UNIT *uptr)
+{
+    struct dcache_t *dc = (struct dcache_t *)uptr->up7;
+    int             i;
+
+    if (dc == NULL)
+        return;
+    dcache_flush(uptr);
+    for (i = 0; i < DCACHE_TRKS; i++)
+        free(dc->trk[i].data);
+    free(dc);
+    uptr->up7 = NULL;
+    uptr->io_flush = NULL;
+}
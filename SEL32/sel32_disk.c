@@ -35,6 +35,12 @@ extern  DEVICE *get_dev(UNIT *uptr);
 extern  t_stat  set_inch(UNIT *uptr, uint32 inch_addr); /* set channel inch address */
 extern  CHANP  *find_chanp_ptr(uint16 chsa);             /* find chanp pointer */
 
+extern  void    dcache_seek(UNIT *uptr, t_addr pos);
+extern  uint32  dcache_read(UNIT *uptr, uint8 *buf, uint32 len);
+extern  uint32  dcache_write(UNIT *uptr, uint8 *buf, uint32 len);
+extern  t_stat  dcache_attach(UNIT *uptr, uint32 tsize);
+extern  void    dcache_detach(UNIT *uptr);
+
 extern  uint32  M[];                            /* our memory */
 extern  uint32  SPAD[];                         /* cpu SPAD memory */
 
@@ -254,7 +260,7 @@ bits 24-31 - FHD head count (number of heads on FHD or number head on FHD option
     mini-module)
 */
 
-/* Not Used     up7 */
+/* up7 holds the track cache, see sel32_dcache.c */
 
 #ifdef  NOUSED
 /* registers */
@@ -819,9 +825,7 @@ t_stat disk_srv(UNIT *uptr)
         /* file offset in bytes */
         tstart = STAR2SEC(uptr->STAR, SPT(type), SPC(type)) * SSB(type);
         /* just reseek to the location where we will r/w data */
-        if ((sim_fseek(uptr->fileref, tstart, SEEK_SET)) != 0) {  /* do seek */
-            sim_debug(DEBUG_DETAIL, dptr, "disk_srv Error on seek to %04x\n", tstart);
-        }
+        dcache_seek(uptr, tstart);
 #endif
                 uptr->CHS = uptr->STAR;         /* we are there */
                 sim_activate(uptr, 10);
@@ -910,9 +914,7 @@ rezero:
             tstart, cyl, trk, buf[3]);
 
         /* just seek to the location where we will r/w data */
-        if ((sim_fseek(uptr->fileref, tstart, SEEK_SET)) != 0) {  /* do seek */
-            sim_debug(DEBUG_DETAIL, dptr, "disk_srv Error on seek to %04x\n", tstart);
-        }
+        dcache_seek(uptr, tstart);
 
         /* Check if already on correct cylinder */
         /* if not, do a delay to slow things down */
@@ -982,6 +984,7 @@ rezero:
         }
 
         if (uptr->CMD & DSK_READING) {          /* see if we are reading data */
+rdsec:
             cyl = STAR2CYL(uptr->CHS);          /* get current cyl */
             trk = (uptr->CHS >> 8) & 0xff;      /* get trk/head */
             sec = uptr->CHS & 0xff;             /* get sec */
@@ -990,7 +993,7 @@ rezero:
             tstart = STAR2SEC(uptr->CHS, SPT(type), SPC(type));
 
             /* read in a sector of data from disk */
-            if ((len=sim_fread(buf, 1, ssize, uptr->fileref)) != ssize) {
+            if ((len=dcache_read(uptr, buf, ssize)) != ssize) {
                 sim_debug(DEBUG_CMD, dptr,
                     "Error %08x on read %04x of diskfile cyl %04x hds %02x sec %02x\n",
                     len, ssize, cyl, trk, sec);
@@ -1050,7 +1053,10 @@ rezero:
             sim_debug(DEBUG_DATA, dptr,
                 "DISK sector read complete, %x bytes to go from diskfile /%04x/%02x/%02x\n",
                 chp->ccw_count, STAR2CYL(uptr->CHS), ((uptr->CHS) >> 8)&0xff, (uptr->CHS&0xff));
-            sim_activate(uptr, 10);         /* wait to read next sector */
+            /* rest of the track is in the cache, keep going */
+            if ((tstart % SPT(type)) != 0)
+                goto rdsec;
+            sim_activate(uptr, 10);         /* wait to read next track */
             break;
 rddone:
             uptr->CMD &= ~(0xffff);             /* remove old status bits & cmd */
@@ -1064,6 +1070,7 @@ rddone:
                 "DISK WRITE starting unit=%02x CMD %02x\n", unit, uptr->CMD);
         }
         if (uptr->CMD & DSK_WRITING) {          /* see if we are writing data */
+wrsec:
             cyl = STAR2CYL(uptr->CHS);          /* get current cyl */
             trk = (uptr->CHS >> 8) & 0xff;      /* get trk/head */
             sec = uptr->CHS & 0xff;             /* get sec */
@@ -1091,7 +1098,7 @@ rddone:
             }
 
             /* write the sector to disk */
-            if ((i=sim_fwrite(buf2, 1, ssize, uptr->fileref)) != ssize) {
+            if ((i=dcache_write(uptr, buf2, ssize)) != ssize) {
                 sim_debug(DEBUG_CMD, dptr,
                     "Error %08x on write %04x bytes to diskfile cyl %04x hds %02x sec %02x\n",
                     i, ssize, cyl, trk, sec);
@@ -1127,6 +1134,9 @@ rddone:
                 chan_end(chsa, SNS_CHNEND|SNS_DEVEND|SNS_UNITCHK);
                 break;
             }
+            /* rest of the track is in the cache, keep going */
+            if ((tstart % SPT(type)) != 0)
+                goto wrsec;
             sim_activate(uptr, 10);             /* keep writing */
             break;
 wrdone:
@@ -1488,20 +1498,17 @@ int disk_format(UNIT *uptr) {
         "Creating disk file of trk size %04x bytes, capacity %d\n",
         tsize*ssize, cap*ssize);
 
-    /* write zeros to each track of the disk */
-    for (cyl = 0; cyl < cylv; cyl++) {
-        if ((sim_fwrite(buff, 1, csize*ssize, uptr->fileref)) != csize*ssize) {
-            sim_debug(DEBUG_CMD, dptr,
-            "Error on write to diskfile cyl %04x\n", cyl);
-        }
-        if (cyl == 0) {
-            buff[0] = 0;
-            buff[1] = 0;
-            buff[2] = 0;
-            buff[3] = 0;
-        }
-        if ((cyl % 100) == 0)
-            fputc('.', stderr);
+    /* write the first cylinder and the last sector of the disk. */
+    /* the space between reads back as zeros without writing it */
+    if ((sim_fwrite(buff, 1, csize*ssize, uptr->fileref)) != csize*ssize) {
+        sim_debug(DEBUG_CMD, dptr,
+            "Error on write to diskfile cyl %04x\n", 0);
+    }
+    memset(buff, 0, ssize);
+    sim_fseek(uptr->fileref, ((t_addr)cylv*csize*ssize)-ssize, SEEK_SET);
+    if ((sim_fwrite(buff, 1, ssize, uptr->fileref)) != ssize) {
+        sim_debug(DEBUG_CMD, dptr,
+            "Error on write to diskfile cyl %04x\n", cylv-1);
     }
     fputc('\r', stderr);
     fputc('\n', stderr);
@@ -1640,6 +1647,11 @@ fmt:
     sim_debug(DEBUG_CMD, dptr, "File %s attached to %s\r\n",
         file, disk_type[type].name);
 
+    /* set up the track cache */
+    if ((r = dcache_attach(uptr, SPT(type)*SSB(type))) != SCPE_OK) {
+        detach_unit(uptr);                      /* no memory, error */
+        return r;
+    }
     set_devattn(chsa, SNS_DEVEND);
     return SCPE_OK;
 }
@@ -1648,6 +1660,7 @@ fmt:
 t_stat disk_detach(UNIT *uptr) {
     uptr->SNS = 0;                              /* clear sense data */
     uptr->CMD &= ~0xffff;                       /* no cmd and flags */
+    dcache_detach(uptr);                        /* write back the cache */
     return detach_unit(uptr);                   /* tell simh we are done with disk */
 }
 
@@ -241,6 +241,10 @@
 #endif
 #include <sys/stat.h>
 #include <setjmp.h>
+#if !defined(_WIN32) && !defined(VMS)
+#include <sys/wait.h>
+#include <poll.h>
+#endif
 
 #if defined(HAVE_DLOPEN)                                /* Dynamic Readline support */
 #include <dlfcn.h>
@@ -269,8 +273,13 @@
 
 #define MAX_DO_NEST_LVL 20                              /* DO cmd nesting level */
 #define SRBSIZ          1024                            /* save/restore buffer */
+#define SAVE_BLKSIZ     4096                            /* [V4.1] save memory block */
+#define SAVE_MINRUN     16                              /* [V4.1] shortest saved run */
+#define SAVE_RUN        0x40000000                      /* [V4.1] run record */
+#define SAVE_SAME       0x20000000                      /* [V4.1] unchanged record */
 #define SIM_BRK_INILNT  4096                            /* bpt tbl length */
 #define SIM_BRK_ALLTYP  0xFFFFFFFB
+#if defined (SIM_CLOCK_QUEUE_LIST)
 #define UPDATE_SIM_TIME                                         \
     if (1) {                                                    \
         int32 _x;                                               \
@@ -290,6 +299,25 @@
     else                                                        \
         (void)0                                                 \
 
+#else
+/* With the event heap, noqueue_time is the value sim_interval was
+   last loaded with, whether or not the queue is empty */
+#define UPDATE_SIM_TIME                                         \
+    if (1) {                                                    \
+        int32 _x;                                               \
+        AIO_LOCK;                                               \
+        _x = noqueue_time - sim_interval;                       \
+        sim_time = sim_time + _x;                               \
+        sim_rtime = sim_rtime + ((uint32) _x);                  \
+        sim_clock_heap_time = sim_clock_heap_time + _x;         \
+        noqueue_time = sim_interval;                            \
+        AIO_UNLOCK;                                             \
+        }                                                       \
+    else                                                        \
+        (void)0                                                 \
+
+#endif
+
 #define SZ_D(dp) (size_map[((dp)->dwidth + CHAR_BIT - 1) / CHAR_BIT])
 #define SZ_R(rp) \
     (size_map[((rp)->width + (rp)->offset + CHAR_BIT - 1) / CHAR_BIT])
@@ -464,6 +492,7 @@ t_stat set_dev_radix (DEVICE *dptr, UNIT *uptr, int32 flag, CONST char *cptr);
 t_stat set_dev_enbdis (DEVICE *dptr, UNIT *uptr, int32 flag, CONST char *cptr);
 t_stat set_dev_debug (DEVICE *dptr, UNIT *uptr, int32 flag, CONST char *cptr);
 t_stat set_unit_enbdis (DEVICE *dptr, UNIT *uptr, int32 flag, CONST char *cptr);
+t_stat set_unit_asynch (DEVICE *dptr, UNIT *uptr, int32 flag, CONST char *cptr);
 t_stat ssh_break (FILE *st, const char *cptr, int32 flg);
 t_stat show_cmd_fi (FILE *ofile, int32 flag, CONST char *cptr);
 t_stat show_config (FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, CONST char *cptr);
@@ -550,6 +579,8 @@ t_stat step_svc (UNIT *ptr);
 t_stat runlimit_svc (UNIT *ptr);
 t_stat expect_svc (UNIT *ptr);
 t_stat flush_svc (UNIT *ptr);
+t_stat save_bg_svc (UNIT *ptr);
+t_stat save_bg_poll (t_bool wait);
 t_stat shift_args (char *do_arg[], size_t arg_count);
 t_stat set_on (int32 flag, CONST char *cptr);
 t_stat set_verify (int32 flag, CONST char *cptr);
@@ -566,6 +597,10 @@ static const char *_get_dbg_verb (uint32 dbits, DEVICE* dptr, UNIT *uptr);
 static t_stat sim_sanity_check_register_declarations (void);
 static t_stat sim_library_unit_tests (void);
 static t_stat _sim_debug_flush (void);
+static const char *_find_dbg_verb (uint32 dbits, DEVICE* dptr);
+#if !defined (SIM_CLOCK_QUEUE_LIST)
+static UNIT **_sim_clock_heap_sorted (void);
+#endif
 
 /* Global data */
 
@@ -593,6 +628,7 @@ BRKTYPTAB *sim_brk_type_desc = NULL;                  /* type descriptions */
 uint32 sim_brk_dflt = 0;
 uint32 sim_brk_match_type;
 t_addr sim_brk_match_addr;
+uint32 sim_brk_map[SIM_BRK_MAP_SIZE];
 char *sim_brk_act[MAX_DO_NEST_LVL];
 char *sim_brk_act_buf[MAX_DO_NEST_LVL];
 BRKTAB **sim_brk_tab = NULL;
@@ -614,6 +650,13 @@ size_t *sim_sub_instr_off = NULL;   /* offsets in substitution buffer where orig
 static double sim_time;
 static uint32 sim_rtime;
 static int32 noqueue_time;
+#if !defined (SIM_CLOCK_QUEUE_LIST)
+static UNIT **sim_clock_heap = NULL;                    /* event heap, earliest first */
+static int32 sim_clock_heap_count = 0;                  /* entries in use */
+static int32 sim_clock_heap_size = 0;                   /* entries allocated */
+static double sim_clock_heap_time = 0.0;                /* absolute event clock */
+static t_uint64 sim_clock_heap_seq = 0;                 /* FIFO order for equal times */
+#endif
 volatile t_bool stop_cpu = FALSE;
 volatile t_bool sigterm_received = FALSE;
 static unsigned int sim_stop_sleep_ms = 250;
@@ -727,6 +770,21 @@ DEVICE sim_flush_dev = {
     NULL, NULL, NULL, NULL, NULL, NULL,
     sim_int_flush_description};
 
+static const char *sim_int_save_description (DEVICE *dptr)
+{
+return "Background save facility";
+}
+
+#define SAVE_BG_INTERVAL 1000000            /* Check background save every second */
+static UNIT sim_save_bg_unit = { UDATA (&save_bg_svc, UNIT_IDLE, 0) };
+DEVICE sim_save_bg_dev = {
+    "INT-SAVE", &sim_save_bg_unit, NULL, NULL, 
+    1, 0, 0, 0, 0, 0, 
+    NULL, NULL, NULL, NULL, NULL, NULL, 
+    NULL, DEV_NOSAVE, 0, 
+    NULL, NULL, NULL, NULL, NULL, NULL,
+    sim_int_save_description};
+
 #if defined USE_INT64
 static const char *sim_si64 = "64b data";
 #else
@@ -741,7 +799,8 @@ const char *sim_savename = sim_name;      /* Simulator Name used in SAVE/RESTORE
 
 /* Tables and strings */
 
-const char save_vercur[] = "V4.0";
+const char save_vercur[] = "V4.1";
+const char save_ver41[] = "V4.1";
 const char save_ver40[] = "V4.0";
 const char save_ver35[] = "V3.5";
 const char save_ver32[] = "V3.2";
@@ -985,7 +1044,17 @@ static const char simh_help[] =
       " The SAVE command (abbreviation SA) save the complete state of the simulator\n"
       " to a file.  This includes the contents of main memory and all registers,\n"
       " and the I/O connections of devices:\n\n"
-      "++SAVE <filename>\n\n"
+      "++SAVE {-I|-B} <filename>\n\n"
+      " The -I switch writes an incremental checkpoint.  It only records the\n"
+      " memory which changed since the previous SAVE -I, together with the name\n"
+      " of that checkpoint file.  The first SAVE -I, and the first after a\n"
+      " RESTORE, writes a full save which later ones are relative to.  Restoring\n"
+      " an incremental checkpoint restores the whole chain, so earlier files\n"
+      " must be kept.\n\n"
+      " The -B switch writes the file in the background, from a copy of the\n"
+      " simulator's state taken when the command is entered, so that the\n"
+      " simulation can continue at once.  Completion is reported on the console.\n"
+      " A following SAVE, RESTORE or EXIT waits for it to finish.\n\n"
 #define HLP_RESTORE     "*Commands Saving_and_Restoring_State RESTORE"
       "3RESTORE\n"
       " The RESTORE command (abbreviation REST, alternately GET) restores a\n"
@@ -998,7 +1067,8 @@ static const char simh_help[] =
       "++-F      Overrides the related file timestamp validation check\n"
       "\n"
       "4Notes:\n"
-      " 1) SAVE file format compresses zeroes to minimize file size.\n"
+      " 1) SAVE file format compresses zeroes and repeated values to minimize\n"
+      " file size.\n"
       " 2) The simulator can't restore active incoming telnet sessions to\n"
       " multiplexer devices, but the listening ports will be restored across a\n"
       " save/restore.\n"
@@ -1365,6 +1435,16 @@ static const char simh_help[] =
       " The size of the circular memory buffer that is used is specified on\n"
       " the SET DEBUG command line, for example:\n\n"
       "++SET DEBUG -B <sizeinMB> <debug-destination>\n\n"
+      "5-Z\n"
+      " The -Z switch causes debug messages to be recorded, without being\n"
+      " formatted, in a binary trace buffer in memory.  This is much faster\n"
+      " than formatting each message as it is generated.  The messages are\n"
+      " formatted and written to the debug destination when debugging is\n"
+      " disabled (SET NODEBUG or simulator exit), and the current contents of\n"
+      " the trace buffer can be displayed with SHOW DEBUG TRACE.  When the\n"
+      " buffer is full, the oldest messages are discarded.  The size of the\n"
+      " trace buffer is specified on the SET DEBUG command line, for example:\n\n"
+      "++SET DEBUG -Z <sizeinMB> <debug-destination>\n\n"
 #define HLP_SET_BREAK  "*Commands SET Breakpoints"
       "3Breakpoints\n"
       "+SET BREAK <list>            set breakpoints\n"
@@ -1413,6 +1493,10 @@ static const char simh_help[] =
       "3Asynch\n"
       "+SET ASYNCH                  enable asynchronous I/O\n"
       "+SET NOASYNCH                disable asynchronous I/O\n"
+      "+SET <unit> ASYNCH{=depth}   queue up to depth (default 1) requests\n"
+      "++++++++                     on an attached disk unit\n"
+      "+SET <unit> NOASYNCH         perform an attached disk unit's I/O\n"
+      "++++++++                     synchronously\n"
 #define HLP_SET_ENVIRON "*Commands SET Environment"
       "3Environment\n"
       "4Explicitily Changing a Variable\n"
@@ -1525,6 +1609,7 @@ static const char simh_help[] =
       "+sh{ow} ve{rsion}            show simulator version\n"
       "+sh{ow} def{ault}            show current directory\n" 
       "+sh{ow} re{mote}             show remote console configuration\n" 
+      "+sh{ow} debug {TRACE}        show debug state or debug trace contents\n"
       "+sh{ow} <dev> RADIX          show device display radix\n"
       "+sh{ow} <dev> DEBUG          show device debug flags\n"
       "+sh{ow} <dev> MODIFIERS      show device modifiers\n"
@@ -2503,6 +2588,8 @@ static C1TAB set_dev_tab[] = {
 static C1TAB set_unit_tab[] = {
     { "ENABLED",    &set_unit_enbdis,   1 },
     { "DISABLED",   &set_unit_enbdis,   0 },
+    { "ASYNCH",     &set_unit_asynch,   1 },
+    { "NOASYNCH",   &set_unit_asynch,   0 },
     { "DEBUG",      &set_dev_debug,     2+1 },
     { "NODEBUG",    &set_dev_debug,     2+0 },
     { NULL,         NULL,               0 }
@@ -2686,6 +2773,7 @@ sim_register_internal_device (&sim_scp_dev);
 sim_register_internal_device (&sim_expect_dev);
 sim_register_internal_device (&sim_step_dev);
 sim_register_internal_device (&sim_flush_dev);
+sim_register_internal_device (&sim_save_bg_dev);
 sim_register_internal_device (&sim_runlimit_dev);
 
 if ((stat = sim_ttinit ()) != SCPE_OK) {
@@ -2804,6 +2892,7 @@ if (SCPE_BARE_STATUS(stat) == SCPE_OPENERR)             /* didn't exist/can't op
 if (SCPE_BARE_STATUS(stat) != SCPE_EXIT)
     process_stdin_commands (SCPE_BARE_STATUS(stat), argv);
 
+save_bg_poll (TRUE);                                    /* finish background save */
 detach_all (0, TRUE);                                   /* close files */
 sim_set_deboff (0, NULL);                               /* close debug */
 sim_set_logoff (0, NULL);                               /* close log */
@@ -5561,6 +5650,30 @@ else {
 return SCPE_OK;
 }
 
+/* Set unit asynch/noasynch routine (disk units) */
+
+t_stat set_unit_asynch (DEVICE *dptr, UNIT *uptr, int32 flag, CONST char *cptr)
+{
+int32 depth = 1;
+t_stat r;
+
+if (DEV_TYPE(dptr) != DEV_DISK)                         /* sim_disk unit? */
+    return SCPE_NOFNC;
+if (!(uptr->flags & UNIT_ATT))                          /* attached? */
+    return SCPE_UNATT;
+if (!flag) {                                            /* noasynch? */
+    if (cptr)
+        return SCPE_ARG;
+    return sim_disk_clr_async (uptr);
+    }
+if (cptr) {                                             /* queue depth? */
+    depth = (int32) get_uint (cptr, 10, INT_MAX, &r);
+    if (r != SCPE_OK)
+        return sim_messagef (SCPE_ARG, "Invalid queue depth: %s\n", cptr);
+    }
+return sim_disk_set_async_depth (uptr, depth);
+}
+
 /* Set device/unit debug enabled/disabled routine */
 
 t_stat set_dev_debug (DEVICE *dptr, UNIT *uptr, int32 flags, CONST char *cptr)
@@ -6171,6 +6284,10 @@ t_stat show_queue (FILE *st, DEVICE *dnotused, UNIT *unotused, int32 flag, CONST
 DEVICE *dptr;
 UNIT *uptr;
 MEMFILE buf;
+#if !defined (SIM_CLOCK_QUEUE_LIST)
+UNIT **ordered;
+int32 i;
+#endif
 
 memset (&buf, 0, sizeof (buf));
 if (cptr && (*cptr != 0))
@@ -6184,7 +6301,14 @@ else {
 
     fprintf (st, "%s event queue status, time = %.0f, executing %s instructions/sec\n",
              sim_name, sim_time, sim_fmt_numeric (inst_per_sec));
+#if defined (SIM_CLOCK_QUEUE_LIST)
     for (uptr = sim_clock_queue; uptr != QUEUE_LIST_END; uptr = uptr->next) {
+#else
+    ordered = _sim_clock_heap_sorted ();
+    if (ordered == NULL)
+        return SCPE_MEM;
+    for (i = 0; (uptr = ordered[i]) != QUEUE_LIST_END; i++) {
+#endif
         if (uptr == &sim_step_unit)
             fprintf (st, "  Step timer");
         else
@@ -6209,6 +6333,9 @@ else {
                                             (*tim) ? " (" : "", tim, (*tim) ? ")" : "",
                                             (uptr->flags & UNIT_IDLE) ? " (Idle capable)" : "");
         }
+#if !defined (SIM_CLOCK_QUEUE_LIST)
+    free (ordered);
+#endif
     }
 sim_show_clock_queues (st, dnotused, unotused, flag, cptr);
 #if defined (SIM_ASYNCH_IO)
@@ -7572,9 +7699,485 @@ return uptr->uname = strcpy ((char *)malloc (1 + strlen (uname)), uname);
 }
 
 
+/* Save/restore memory support
+
+   Memory-like units are saved in blocks of SAVE_BLKSIZ words.  Each block
+   is a sequence of records, each introduced by an int32 record word:
+
+        < 0             -count words of zero
+        SAVE_RUN + n    n copies of the single word which follows
+        SAVE_SAME + n   n words unchanged from the base checkpoint
+        otherwise       count words of literal data follow
+
+   V4.0 and earlier files only contain zero and literal records, so they
+   restore unchanged.  A simulator which keeps a unit's memory in a plain
+   host array can register it with sim_register_memory; the save and
+   restore paths then copy directly to and from that array rather than
+   calling the device's examine and deposit routines once per word.
+
+   SAVE -I writes an incremental checkpoint.  The first one is a full save;
+   each following one only records the blocks which changed since the
+   previous checkpoint, plus the name and identity of that checkpoint so
+   that RESTORE can rebuild the chain.
+*/
+
+typedef struct SAVE_MEM {
+    UNIT            *uptr;                              /* memory unit */
+    void            *base;                              /* registered host array */
+    size_t          size;                               /* bytes per word */
+    void            *shadow;                            /* memory as of last checkpoint */
+    t_addr          shadow_words;                       /* words in shadow */
+    } SAVE_MEM;
+
+static SAVE_MEM *save_mem = NULL;                       /* memory units */
+static int32 save_mem_count = 0;
+static char save_ckpt_id[CBUFSIZE] = "";                /* last checkpoint id */
+static char *save_ckpt_file = NULL;                     /* last checkpoint file */
+static t_bool save_incremental = FALSE;                 /* SAVE -I in progress */
+static t_bool save_delta = FALSE;                       /* writing a delta */
+
+static SAVE_MEM *save_find_mem (UNIT *uptr, t_bool create)
+{
+int32 i;
+
+for (i = 0; i < save_mem_count; i++)
+    if (save_mem[i].uptr == uptr)
+        return &save_mem[i];
+if (!create)
+    return NULL;
+save_mem = (SAVE_MEM *)realloc (save_mem, (save_mem_count + 1) * sizeof (*save_mem));
+memset (&save_mem[save_mem_count], 0, sizeof (*save_mem));
+save_mem[save_mem_count].uptr = uptr;
+return &save_mem[save_mem_count++];
+}
+
+/* Register the host array holding a memory unit's contents
+
+   base is an array of at least uptr->capac words of size bytes each, laid
+   out so that word k of the unit is element k of the array.
+*/
+
+t_stat sim_register_memory (UNIT *uptr, void *base, size_t size)
+{
+SAVE_MEM *smp = save_find_mem (uptr, TRUE);
+
+smp->base = base;
+smp->size = size;
+return SCPE_OK;
+}
+
+/* Return the registered array for a unit, if it can be accessed directly */
+
+static void *save_mem_direct (DEVICE *dptr, UNIT *uptr, size_t sz)
+{
+SAVE_MEM *smp = save_find_mem (uptr, FALSE);
+
+if ((smp == NULL) || (smp->base == NULL) ||
+    (smp->size != sz) || (dptr->aincr != 1))
+    return NULL;
+return smp->base;
+}
+
+/* Forget the current incremental checkpoint chain */
+
+static void save_ckpt_clear (void)
+{
+int32 i;
+
+for (i = 0; i < save_mem_count; i++) {
+    free (save_mem[i].shadow);
+    save_mem[i].shadow = NULL;
+    save_mem[i].shadow_words = 0;
+    }
+free (save_ckpt_file);
+save_ckpt_file = NULL;
+}
+
+/* Read cnt words of memory starting at address k into mbuf */
+
+static t_stat save_mem_read (DEVICE *dptr, UNIT *uptr, t_addr k, void *mbuf,
+                             int32 cnt, size_t sz)
+{
+void *mem = save_mem_direct (dptr, uptr, sz);
+t_value val;
+t_stat r;
+int32 l;
+
+if (mem != NULL) {
+    memcpy (mbuf, (uint8 *)mem + (size_t)k * sz, cnt * sz);
+    return SCPE_OK;
+    }
+for (l = 0; l < cnt; l++, k = k + (dptr->aincr)) {
+    r = dptr->examine (&val, k, uptr, SIM_SW_REST);
+    if (r != SCPE_OK)
+        return r;
+    SZ_STORE (sz, val, mbuf, l);
+    }
+return SCPE_OK;
+}
+
+/* Write one block of memory as zero, run and literal records */
+
+static void save_mem_block (FILE *sfile, void *mbuf, int32 cnt, size_t sz)
+{
+int32 i, j, lit, rec;
+t_value val, nval;
+
+for (i = lit = 0; i < cnt; i = j) {
+    SZ_LOAD (sz, val, mbuf, i);
+    for (j = i + 1; j < cnt; j++) {                     /* find run length */
+        SZ_LOAD (sz, nval, mbuf, j);
+        if (nval != val)
+            break;
+        }
+    if ((j - i < SAVE_MINRUN) && ((val != 0) || (j - i < cnt)))
+        continue;                                       /* too short, literal */
+    if (lit < i) {                                      /* flush literal data */
+        rec = i - lit;
+        sim_fwrite (&rec, sizeof (rec), 1, sfile);
+        sim_fwrite ((uint8 *)mbuf + lit * sz, sz, rec, sfile);
+        }
+    if (val == 0) {                                     /* zero run? */
+        rec = -(j - i);
+        sim_fwrite (&rec, sizeof (rec), 1, sfile);
+        }
+    else {
+        rec = SAVE_RUN + (j - i);
+        sim_fwrite (&rec, sizeof (rec), 1, sfile);
+        sim_fwrite ((uint8 *)mbuf + i * sz, sz, 1, sfile);
+        }
+    lit = j;
+    }
+if (lit < cnt) {                                        /* remaining literal */
+    rec = cnt - lit;
+    sim_fwrite (&rec, sizeof (rec), 1, sfile);
+    sim_fwrite ((uint8 *)mbuf + lit * sz, sz, rec, sfile);
+    }
+}
+
+/* Save a memory-like unit */
+
+static t_stat save_mem_unit (FILE *sfile, DEVICE *dptr, UNIT *uptr, t_addr high)
+{
+SAVE_MEM *smp = NULL;
+uint8 *shadow = NULL;
+void *mbuf;
+int32 l, rec;
+t_addr k, w, words;
+t_stat r;
+size_t sz = SZ_D (dptr);
+
+words = (high + dptr->aincr - 1) / dptr->aincr;
+if (save_incremental) {                                 /* keeping a shadow? */
+    smp = save_find_mem (uptr, TRUE);
+    if ((smp->shadow != NULL) && (smp->shadow_words == words) && save_delta)
+        shadow = (uint8 *)smp->shadow;                  /* compare against it */
+    else {                                              /* start a new one */
+        free (smp->shadow);
+        smp->shadow_words = 0;
+        if ((smp->shadow = malloc ((size_t)words * sz)) == NULL)
+            return SCPE_MEM;
+        smp->shadow_words = words;
+        }
+    }
+if ((mbuf = calloc (SAVE_BLKSIZ, sz)) == NULL)
+    return SCPE_MEM;
+for (k = 0, w = 0; k < high; w = w + l, k = k + l * dptr->aincr) {
+    l = (int32)(((words - w) < SAVE_BLKSIZ) ? (words - w) : SAVE_BLKSIZ);
+    r = save_mem_read (dptr, uptr, k, mbuf, l, sz);
+    if (r != SCPE_OK) {
+        free (mbuf);
+        return r;
+        }
+    if ((shadow != NULL) &&                             /* unchanged block? */
+        (memcmp (mbuf, shadow + w * sz, l * sz) == 0)) {
+        rec = SAVE_SAME + l;
+        sim_fwrite (&rec, sizeof (rec), 1, sfile);
+        continue;
+        }
+    save_mem_block (sfile, mbuf, l, sz);
+    if (smp != NULL)                                    /* update shadow */
+        memcpy ((uint8 *)smp->shadow + w * sz, mbuf, l * sz);
+    }
+free (mbuf);
+return SCPE_OK;
+}
+
+/* Restore a memory-like unit */
+
+static t_stat rest_mem_unit (FILE *rfile, DEVICE *dptr, UNIT *uptr, t_addr high,
+                             t_bool direct, t_bool delta)
+{
+void *mbuf, *mem;
+int32 j, blkcnt, limit;
+t_addr k;
+t_value val;
+t_stat r = SCPE_OK;
+size_t sz = SZ_D (dptr);
+
+mem = direct? save_mem_direct (dptr, uptr, sz): NULL;
+if ((mbuf = calloc (SAVE_BLKSIZ, sz)) == NULL)
+    return SCPE_MEM;
+for (k = 0; k < high; ) {                               /* loop thru mem */
+    if (sim_fread (&blkcnt, sizeof (blkcnt), 1, rfile) == 0) {/* block count */
+        r = SCPE_IOERR;
+        break;
+        }
+    val = 0;
+    if (blkcnt < 0)                                     /* compressed? */
+        limit = -blkcnt;
+    else if (blkcnt & SAVE_RUN) {                       /* run of one value? */
+        limit = blkcnt - SAVE_RUN;
+        if (sim_fread (mbuf, sz, 1, rfile) == 0) {
+            r = SCPE_IOERR;
+            break;
+            }
+        SZ_LOAD (sz, val, mbuf, 0);
+        }
+    else if (blkcnt & SAVE_SAME) {                      /* unchanged? */
+        if (!delta) {
+            r = SCPE_INCOMP;
+            break;
+            }
+        k = k + (blkcnt - SAVE_SAME) * dptr->aincr;
+        continue;
+        }
+    else if (blkcnt > SAVE_BLKSIZ)                      /* too big? */
+        limit = 0;
+    else limit = (int32)sim_fread (mbuf, sz, blkcnt, rfile);
+    if ((limit <= 0) || (limit > SAVE_BLKSIZ) ||        /* invalid or err? */
+        ((mem != NULL) && (k + limit > high))) {
+        r = SCPE_IOERR;
+        break;
+        }
+    if (mem != NULL) {                                  /* direct access? */
+        if ((blkcnt > 0) && !(blkcnt & SAVE_RUN))
+            memcpy ((uint8 *)mem + (size_t)k * sz, mbuf, limit * sz);
+        else if (val == 0)
+            memset ((uint8 *)mem + (size_t)k * sz, 0, limit * sz);
+        else for (j = 0; j < limit; j++) {
+            SZ_STORE (sz, val, mem, k + j);
+            }
+        k = k + limit;
+        continue;
+        }
+    for (j = 0; j < limit; j++, k = k + (dptr->aincr)) {
+        if ((blkcnt > 0) && !(blkcnt & SAVE_RUN)) {     /* literal? */
+            SZ_LOAD (sz, val, mbuf, j);                 /* saved value */
+            }
+        r = dptr->deposit (val, k, uptr, SIM_SW_REST);
+        if (r != SCPE_OK)
+            break;
+        }                                               /* end for j */
+    if (r != SCPE_OK)
+        break;
+    }                                                   /* end for k */
+free (mbuf);                                            /* dealloc buffer */
+return r;
+}
+
+/* Write a buffered unit's data back to its file */
+
+static void save_flush_unit (DEVICE *dptr, UNIT *uptr)
+{
+if ((uptr->flags & UNIT_ATT) &&
+    (uptr->flags & UNIT_BUF) &&                         /* writable buffered */
+    uptr->hwmark &&                                     /* files need to be */
+    ((uptr->flags & UNIT_RO) == 0)) {                   /* written on save */
+    uint32 cap = (uptr->hwmark + dptr->aincr - 1) / dptr->aincr;
+    rewind (uptr->fileref);
+    sim_fwrite (uptr->filebuf, SZ_D (dptr), cap, uptr->fileref);
+    fclose (uptr->fileref);                             /* flush data and state */
+    uptr->fileref = sim_fopen (uptr->filename, "rb+");  /* reopen r/w */
+    }
+}
+
+/* Background save
+
+   SAVE -B forks a child process which inherits a copy-on-write image of
+   the whole simulator at the moment of the command, writes the save file
+   from that image and exits.  The simulator itself carries on as soon as
+   the fork returns.  Buffered units are written back by the parent before
+   the fork, since the child must not touch files the simulator is still
+   using.  Completion is reported on the console, and a following SAVE,
+   RESTORE or EXIT waits for an outstanding background save to finish.
+   Hosts without fork save in the foreground.
+
+   The child reports its result by writing one status byte to a pipe just
+   before it exits.  The parent polls the pipe, or blocks reading it when
+   it has to wait, so a slow save is never mistaken for a stuck one.  End
+   of file without a status byte means the child died part way through.
+
+   The fork happens with the multiplexer poll, disk I/O pool, timer and
+   asynchronous event queue locks held, taken in the order the threads
+   using them nest them, so the child can't inherit a lock from a thread
+   which was in the middle of an update.  Debug output is serialized by
+   the event queue lock.  The child doesn't use the tape or network
+   threads' data.
+*/
+
+#if defined(_WIN32) || defined(VMS)
+static t_bool save_bg_child = FALSE;
+
+t_stat save_bg_poll (t_bool wait)
+{
+return SCPE_OK;
+}
+
+t_stat save_bg_svc (UNIT *uptr)
+{
+return SCPE_OK;
+}
+
+static t_stat save_background (const char *filename)
+{
+FILE *sfile;
+t_stat r;
+
+if ((sfile = sim_fopen (filename, "r+b")) == NULL)
+    return SCPE_OPENERR;
+r = sim_save (sfile);
+fclose (sfile);
+return r;
+}
+
+#else
+static t_bool save_bg_child = FALSE;                    /* in the child process */
+static pid_t save_bg_pid = 0;                           /* outstanding child */
+static char *save_bg_file = NULL;                       /* and its save file */
+static int save_bg_fd = -1;                             /* its status pipe */
+
+/* Collect the status byte of the background save, waiting for it if asked.
+   Returns FALSE if the child is still running. */
+
+static t_bool save_bg_status (t_bool wait, t_stat *r)
+{
+struct pollfd pfd;
+unsigned char st;
+ssize_t n;
+int status;
+pid_t pid;
+
+if (!wait) {
+    pfd.fd = save_bg_fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if (poll (&pfd, 1, 0) <= 0)                         /* nothing to read yet? */
+        return FALSE;
+    }
+do {
+    n = read (save_bg_fd, &st, 1);                      /* blocks until child exits */
+    } while ((n < 0) && (errno == EINTR));
+*r = (n == 1) ? (t_stat)st : SCPE_IOERR;                /* EOF: child died early */
+close (save_bg_fd);
+save_bg_fd = -1;
+do {                                                    /* reap the child, */
+    pid = waitpid (save_bg_pid, &status, 0);            /* which is exiting */
+    } while ((pid < 0) && (errno == EINTR));
+return TRUE;
+}
+
+t_stat save_bg_poll (t_bool wait)
+{
+t_stat r;
+
+if (save_bg_pid == 0)                                   /* nothing pending? */
+    return SCPE_OK;
+if (!save_bg_status (wait, &r))                         /* still running? */
+    return SCPE_OK;
+if (r == SCPE_OK)
+    sim_printf ("Background save to %s complete\n", save_bg_file);
+else
+    sim_printf ("Background save to %s failed: %s\n", save_bg_file, sim_error_text (r));
+free (save_bg_file);
+save_bg_file = NULL;
+save_bg_pid = 0;
+return r;
+}
+
+t_stat save_bg_svc (UNIT *uptr)
+{
+save_bg_poll (FALSE);
+if (save_bg_pid != 0)                                   /* still going? */
+    sim_activate_after (uptr, SAVE_BG_INTERVAL);
+return SCPE_OK;
+}
+
+static t_stat save_background (const char *filename)
+{
+FILE *sfile;
+uint32 i, j;
+DEVICE *dptr;
+pid_t pid;
+int fds[2];
+unsigned char st;
+t_stat r;
+
+for (i = 0; (dptr = sim_devices[i]) != NULL; i++) {     /* write back buffered */
+    if (dptr->flags & DEV_NOSAVE)                       /* units while the */
+        continue;                                       /* simulator owns them */
+    for (j = 0; j < dptr->numunits; j++)
+        save_flush_unit (dptr, dptr->units + j);
+    }
+fflush (stdout);                                        /* don't duplicate output */
+if (sim_log)
+    fflush (sim_log);
+if (pipe (fds) < 0)                                     /* no status pipe? */
+    pid = -1;                                           /* save in foreground */
+else {
+#if defined(SIM_ASYNCH_IO)
+    pthread_mutex_lock (&sim_tmxr_poll_lock);           /* same order as the */
+    sim_disk_aio_lock (TRUE);                           /* threads which use */
+    pthread_mutex_lock (&sim_timer_lock);               /* them take them */
+    AIO_LOCK;
+#endif
+    pid = fork ();
+#if defined(SIM_ASYNCH_IO)
+    AIO_UNLOCK;                                         /* parent and child */
+    pthread_mutex_unlock (&sim_timer_lock);             /* each release */
+    sim_disk_aio_lock (FALSE);                          /* their copy */
+    pthread_mutex_unlock (&sim_tmxr_poll_lock);
+#endif
+    if (pid == 0) {                                     /* child? */
+        save_bg_child = TRUE;
+        close (fds[0]);
+        if ((sfile = sim_fopen (filename, "r+b")) == NULL)
+            r = SCPE_OPENERR;
+        else {
+            r = sim_save (sfile);
+            if (fclose (sfile) && (r == SCPE_OK))
+                r = SCPE_IOERR;
+            }
+        st = (unsigned char)SCPE_BARE_STATUS (r);
+        if (write (fds[1], &st, 1) != 1)                /* report result */
+            r = SCPE_IOERR;
+        _exit (SCPE_BARE_STATUS (r));                   /* no atexit or stdio flush */
+        }
+    close (fds[1]);
+    if (pid < 0)
+        close (fds[0]);
+    }
+if (pid < 0) {                                          /* can't fork? */
+    if ((sfile = sim_fopen (filename, "r+b")) == NULL)
+        return SCPE_OPENERR;
+    r = sim_save (sfile);                               /* save in foreground */
+    fclose (sfile);
+    return r;
+    }
+save_bg_pid = pid;
+save_bg_fd = fds[0];
+save_bg_file = (char *)malloc (1 + strlen (filename));
+strcpy (save_bg_file, filename);
+sim_activate_after (&sim_save_bg_unit, SAVE_BG_INTERVAL);
+return SCPE_OK;
+}
+#endif
+
 /* Save command
 
    sa[ve] filename              save state to specified file
+   sa[ve] -i filename           save an incremental checkpoint
+   sa[ve] -b filename           save in the background
 */
 
 t_stat save_cmd (int32 flag, CONST char *cptr)
@@ -7582,6 +8185,7 @@ t_stat save_cmd (int32 flag, CONST char *cptr)
 FILE *sfile;
 t_stat r;
 char gbuf[4*CBUFSIZE];
+char *fullname;
 
 GET_SWITCHES (cptr);                                    /* get switches */
 if (*cptr == 0)                                         /* must be more */
@@ -7589,25 +8193,51 @@ if (*cptr == 0)                                         /* must be more */
 gbuf[sizeof(gbuf)-1] = '\0';
 strlcpy (gbuf, cptr, sizeof(gbuf));
 sim_trim_endspc (gbuf);
+save_bg_poll (TRUE);                                    /* one at a time */
+if (sim_switches & SWMASK ('B')) {                      /* background? */
+    if (sim_switches & SWMASK ('I'))
+        return sim_messagef (SCPE_ARG, "SAVE -B can't be combined with -I\n");
+    if ((sfile = sim_fopen (gbuf, "r+b")) == NULL) {/* make sure it can */
+        if ((sfile = sim_fopen (gbuf, "wb")) == NULL)/* be written */
+            return SCPE_OPENERR;
+        }
+    fclose (sfile);
+    return save_background (gbuf);
+    }
+save_incremental = ((sim_switches & SWMASK ('I')) != 0);
+fullname = sim_filepath_parts (gbuf, "f");
+save_delta = save_incremental && (save_ckpt_file != NULL) &&
+             (strcmp (save_ckpt_file, fullname) != 0);
 if ((sfile = sim_fopen (gbuf, "r+b")) == NULL) {    /* try existing file */
-    if ((sfile = sim_fopen (gbuf, "wb")) == NULL)   /* create new empty file */
+    if ((sfile = sim_fopen (gbuf, "wb")) == NULL) { /* create new empty file */
+        free (fullname);
+        save_incremental = save_delta = FALSE;
         return SCPE_OPENERR;
+        }
     }
 r = sim_save (sfile);
 fclose (sfile);
+if (save_incremental) {                                 /* checkpoint? */
+    if (r == SCPE_OK) {                                 /* next delta is */
+        free (save_ckpt_file);                          /* relative to this one */
+        save_ckpt_file = fullname;
+        fullname = NULL;
+        }
+    else save_ckpt_clear ();                            /* shadows are suspect */
+    }
+free (fullname);
+save_incremental = save_delta = FALSE;
 return r;
 }
 
 t_stat sim_save (FILE *sfile)
 {
-void *mbuf;
-int32 l, t;
+int32 t;
 uint32 i, j, device_count;
-t_addr k, high;
+t_addr high;
 t_value val;
 t_stat r;
-t_bool zeroflg;
-size_t sz;
+char ckpt_id[20];
 DEVICE *dptr;
 UNIT *uptr;
 REG *rptr;
@@ -7631,6 +8261,14 @@ fprintf (sfile, "git commit id: %8.8s\n", S_xstr(SIM_GIT_COMMIT_ID));
 #else
 fprintf (sfile, "git commit id: unknown\n");
 #endif
+sprintf (ckpt_id, "%08X%08X", (uint32)time (NULL), sim_os_msec ());
+fprintf (sfile, "checkpoint id: %s\n", ckpt_id);       /* [V4.1] checkpoint */
+if (save_delta)
+    fprintf (sfile, "base checkpoint: %s %s\n", save_ckpt_id, save_ckpt_file);
+else
+    fprintf (sfile, "base checkpoint: none\n");
+if (save_incremental)
+    strlcpy (save_ckpt_id, ckpt_id, sizeof (save_ckpt_id));
 
 for (device_count = 0; sim_devices[device_count]; device_count++);/* count devices */
 for (i = 0; i < (device_count + sim_internal_device_count); i++) {/* loop thru devices */
@@ -7666,48 +8304,17 @@ for (i = 0; i < (device_count + sim_internal_device_count); i++) {/* loop thru d
         WRITE_I (uptr->pos);
         if (uptr->flags & UNIT_ATT) {
             fputs (uptr->filename, sfile);
-            if ((uptr->flags & UNIT_BUF) &&             /* writable buffered */
-                uptr->hwmark &&                         /* files need to be */
-                ((uptr->flags & UNIT_RO) == 0)) {       /* written on save */
-                uint32 cap = (uptr->hwmark + dptr->aincr - 1) / dptr->aincr;
-                rewind (uptr->fileref);
-                sim_fwrite (uptr->filebuf, SZ_D (dptr), cap, uptr->fileref);
-                fclose (uptr->fileref);                 /* flush data and state */
-                uptr->fileref = sim_fopen (uptr->filename, "rb+");/* reopen r/w */
-                }
+            if (!save_bg_child)                         /* parent already did */
+                save_flush_unit (dptr, uptr);
             }
         fputc ('\n', sfile);
         if (((uptr->flags & (UNIT_FIX + UNIT_ATTABLE)) == UNIT_FIX) &&
              (dptr->examine != NULL) &&
              ((high = uptr->capac) != 0)) {             /* memory-like unit? */
             WRITE_I (high);                             /* [V2.5] write size */
-            sz = SZ_D (dptr);
-            if ((mbuf = calloc (SRBSIZ, sz)) == NULL) {
-                fclose (sfile);
-                return SCPE_MEM;
-                }
-            for (k = 0; k < high; ) {                   /* loop thru mem */
-                zeroflg = TRUE;
-                for (l = 0; (l < SRBSIZ) && (k < high); l++,
-                     k = k + (dptr->aincr)) {           /* check for 0 block */
-                    r = dptr->examine (&val, k, uptr, SIM_SW_REST);
-                    if (r != SCPE_OK) {
-                        free (mbuf);
-                        return r;
-                        }
-                    if (val) zeroflg = FALSE;
-                    SZ_STORE (sz, val, mbuf, l);
-                    }                                   /* end for l */
-                if (zeroflg) {                          /* all zero's? */
-                    l = -l;                             /* invert block count */
-                    WRITE_I (l);                        /* write only count */
-                    }
-                else {
-                    WRITE_I (l);                        /* block count */
-                    sim_fwrite (mbuf, sz, l, sfile);
-                    }
-                }                                       /* end for k */
-            free (mbuf);                                /* dealloc buffer */
+            r = save_mem_unit (sfile, dptr, uptr, high);/* [V4.1] write blocks */
+            if (r != SCPE_OK)
+                return r;
             }                                           /* end if mem */
         else {                                          /* no memory */
             high = 0;                                   /* write 0 */
@@ -7742,6 +8349,10 @@ return (ferror (sfile))? SCPE_IOERR: SCPE_OK;           /* error during save? */
 /* Restore command
 
    re[store] filename           restore state from specified file
+
+   Restoring an incremental checkpoint first restores the checkpoints it
+   was based on.  Only the restored checkpoint id is kept; no memory shadow
+   is taken, so the next SAVE -I is a full save which starts a new chain.
 */
 
 t_stat restore_cmd (int32 flag, CONST char *cptr)
@@ -7756,8 +8367,10 @@ if (*cptr == 0)                                         /* must be more */
 gbuf[sizeof(gbuf)-1] = '\0';
 strlcpy (gbuf, cptr, sizeof(gbuf));
 sim_trim_endspc (gbuf);
+save_bg_poll (TRUE);                                    /* file may be in progress */
 if ((rfile = sim_fopen (gbuf, "rb")) == NULL)
     return SCPE_OPENERR;
+save_ckpt_clear ();                                     /* memory will differ */
 r = sim_rest (rfile);
 fclose (rfile);
 return r;
@@ -7770,14 +8383,13 @@ char **attnames = NULL;
 UNIT **attunits = NULL;
 int32 *attswitches = NULL;
 int32 attcnt = 0;
-void *mbuf;
-int32 j, blkcnt, limit, unitno, time, flg;
+int32 j, unitno, time, flg;
 uint32 us, depth;
-t_addr k, high, old_capac;
+t_addr high, old_capac;
 t_value val, mask;
 t_stat r;
-size_t sz;
-t_bool v40, v35, v32;
+t_bool v41, v40, v35, v32;
+char ckpt_id[CBUFSIZE], base_id[CBUFSIZE], *base_file = NULL;
 DEVICE *dptr;
 UNIT *uptr;
 REG *rptr;
@@ -7802,8 +8414,10 @@ if (fstat (fileno (rfile), &rstat)) {
     goto Cleanup_Return;
     }
 READ_S (buf);                                           /* [V2.5+] read version */
-v40 = v35 = v32 = FALSE;
-if (strcmp (buf, save_ver40) == 0)                      /* version 4.0? */
+v41 = v40 = v35 = v32 = FALSE;
+if (strcmp (buf, save_ver41) == 0)                      /* version 4.1? */
+    v41 = v40 = v35 = v32 = TRUE;
+else if (strcmp (buf, save_ver40) == 0)                 /* version 4.0? */
     v40 = v35 = v32 = TRUE;
 else if (strcmp (buf, save_ver35) == 0)                 /* version 3.5? */
     v35 = v32 = TRUE;
@@ -7813,7 +8427,7 @@ else if (strcmp (buf, save_ver30) != 0) {               /* version 3.0? */
     sim_printf ("Invalid file version: %s\n", buf);
     return SCPE_INCOMP;
     }
-if ((strcmp (buf, save_ver40) != 0) && (!sim_quiet) && (!suppress_warning)) {
+if ((strcmp (buf, save_vercur) != 0) && (!sim_quiet) && (!suppress_warning)) {
     sim_printf ("warning - attempting to restore a saved simulator image in %s image format.\n", buf);
     warned = TRUE;
     }
@@ -7855,6 +8469,51 @@ if (v40) {
 #undef S_xstr
 #endif
     }
+save_ckpt_id[0] = ckpt_id[0] = base_id[0] = '\0';
+if (v41) {
+    READ_S (buf);                                       /* [V4.1] checkpoint id */
+    if (sscanf (buf, "checkpoint id: %s", ckpt_id) != 1) {
+        r = SCPE_INCOMP;
+        goto Cleanup_Return;
+        }
+    READ_S (buf);                                       /* [V4.1] base checkpoint */
+    if (strncmp (buf, "base checkpoint: ", 17) != 0) {
+        r = SCPE_INCOMP;
+        goto Cleanup_Return;
+        }
+    if (strcmp (buf + 17, "none") != 0) {               /* incremental? */
+        FILE *bfile;
+        char *cp = strchr (buf + 17, ' ');
+
+        if (cp == NULL) {
+            r = SCPE_INCOMP;
+            goto Cleanup_Return;
+            }
+        *cp++ = '\0';
+        strlcpy (base_id, buf + 17, sizeof (base_id));
+        base_file = (char *)malloc (1 + strlen (cp));
+        strcpy (base_file, cp);
+        if ((bfile = sim_fopen (base_file, "rb")) == NULL) {
+            sim_printf ("Can't open base checkpoint: %s\n", base_file);
+            r = SCPE_OPENERR;
+            goto Cleanup_Return;
+            }
+        sim_switches = (force_restore ? SWMASK ('F') : 0) |
+                       (dont_detach_attach ? SWMASK ('D') : 0) |
+                       (suppress_warning ? SWMASK ('Q') : 0);
+        r = sim_rest (bfile);                           /* restore the base first */
+        fclose (bfile);
+        if (r != SCPE_OK)
+            goto Cleanup_Return;
+        if (strcmp (save_ckpt_id, base_id) != 0) {
+            sim_printf ("Base checkpoint mismatch: %s is %s, expected %s\n",
+                        base_file, save_ckpt_id, base_id);
+            r = SCPE_INCOMP;
+            goto Cleanup_Return;
+            }
+        }
+    strlcpy (save_ckpt_id, ckpt_id, sizeof (save_ckpt_id));
+    }
 if (!dont_detach_attach)
     detach_all (0, 0);                                  /* Detach everything to start from a consistent state */
 else {
@@ -7986,37 +8645,10 @@ for ( ;; ) {                                            /* device loop */
                     fprint_capac (sim_log, dptr, uptr);
                 sim_printf ("\n");
                 }
-            sz = SZ_D (dptr);                           /* allocate buffer */
-            if ((mbuf = calloc (SRBSIZ, sz)) == NULL) {
-                r = SCPE_MEM;
+            r = rest_mem_unit (rfile, dptr, uptr, high, /* read blocks */
+                               v41, (base_file != NULL));
+            if (r != SCPE_OK)
                 goto Cleanup_Return;
-                }
-            for (k = 0; k < high; ) {                   /* loop thru mem */
-                if (sim_fread (&blkcnt, sizeof (blkcnt), 1, rfile) == 0) {/* block count */
-                    free (mbuf);
-                    r = SCPE_IOERR;
-                    goto Cleanup_Return;
-                    }
-                if (blkcnt < 0)                         /* compressed? */
-                    limit = -blkcnt;
-                else limit = (int32)sim_fread (mbuf, sz, blkcnt, rfile);
-                if (limit <= 0) {                       /* invalid or err? */
-                    free (mbuf);
-                    r = SCPE_IOERR;
-                    goto Cleanup_Return;
-                    }
-                for (j = 0; j < limit; j++, k = k + (dptr->aincr)) {
-                    if (blkcnt < 0)                     /* compressed? */
-                        val = 0;
-                    else SZ_LOAD (sz, val, mbuf, j);    /* saved value */
-                    r = dptr->deposit (val, k, uptr, SIM_SW_REST);
-                    if (r != SCPE_OK) {
-                        free (mbuf);
-                        goto Cleanup_Return;
-                        }
-                    }                                   /* end for j */
-                }                                       /* end for k */
-            free (mbuf);                                /* dealloc buffer */
             }                                           /* end if high */
         }                                               /* end unit loop */
     for ( ;; ) {                                        /* register loop */
@@ -8091,6 +8723,7 @@ for (j=0, r = SCPE_OK; j<attcnt; j++) {
 Cleanup_Return:
 for (j=0; j < attcnt; j++)
     free (attnames[j]);
+free (base_file);
 free (attnames);
 free (attunits);
 free (attswitches);
@@ -11077,8 +11710,16 @@ return buf;
    and to see if further events need to be processed, or sim_interval
    reset to count the next one.
 
-   The event queue is maintained in clock order; entry timeouts are
-   RELATIVE to the time in the previous entry.
+   By default the event queue is a binary heap ordered by absolute due
+   time (on a private event clock which advances with sim_time), with
+   entries due at the same time kept in the order they were activated.
+   Activation and cancellation cost O(log n) in the number of pending
+   events.  sim_clock_queue always points at the earliest entry, and
+   an entry's next pointer is non NULL while it is queued.
+
+   When built with SIM_CLOCK_QUEUE_LIST defined, the original linked
+   list is used instead: the event queue is maintained in clock order;
+   entry timeouts are RELATIVE to the time in the previous entry.
 
    sim_process_event - process event
 
@@ -11089,6 +11730,133 @@ return buf;
                         or 0 (SCPE_OK) if no exceptions
 */
 
+#if !defined (SIM_CLOCK_QUEUE_LIST)
+static t_bool _sim_clock_heap_before (UNIT *a, UNIT *b)
+{
+return ((a->q_due_time < b->q_due_time) ||
+        ((a->q_due_time == b->q_due_time) && (a->q_seq < b->q_seq)));
+}
+
+static void _sim_clock_heap_place (int32 i, UNIT *uptr)
+{
+sim_clock_heap[i] = uptr;
+uptr->q_index = i + 1;
+}
+
+static void _sim_clock_heap_sift_up (int32 i)
+{
+UNIT *uptr = sim_clock_heap[i];
+
+while (i > 0) {
+    int32 parent = (i - 1) / 2;
+
+    if (!_sim_clock_heap_before (uptr, sim_clock_heap[parent]))
+        break;
+    _sim_clock_heap_place (i, sim_clock_heap[parent]);
+    i = parent;
+    }
+_sim_clock_heap_place (i, uptr);
+}
+
+static void _sim_clock_heap_sift_down (int32 i)
+{
+UNIT *uptr = sim_clock_heap[i];
+
+while (1) {
+    int32 child = 2 * i + 1;
+
+    if (child >= sim_clock_heap_count)
+        break;
+    if ((child + 1 < sim_clock_heap_count) &&
+        _sim_clock_heap_before (sim_clock_heap[child + 1], sim_clock_heap[child]))
+        ++child;
+    if (!_sim_clock_heap_before (sim_clock_heap[child], uptr))
+        break;
+    _sim_clock_heap_place (i, sim_clock_heap[child]);
+    i = child;
+    }
+_sim_clock_heap_place (i, uptr);
+}
+
+static t_bool _sim_clock_heap_member (UNIT *uptr)
+{
+return ((uptr->q_index > 0) &&
+        (uptr->q_index <= sim_clock_heap_count) &&
+        (sim_clock_heap[uptr->q_index - 1] == uptr));
+}
+
+static t_stat _sim_clock_heap_insert (UNIT *uptr)
+{
+if (sim_clock_heap_count == sim_clock_heap_size) {
+    int32 new_size = (sim_clock_heap_size == 0) ? 64 : 2 * sim_clock_heap_size;
+    UNIT **new_heap = (UNIT **)realloc (sim_clock_heap, new_size * sizeof (*sim_clock_heap));
+
+    if (new_heap == NULL)
+        return SCPE_MEM;
+    sim_clock_heap = new_heap;
+    sim_clock_heap_size = new_size;
+    }
+sim_clock_heap[sim_clock_heap_count++] = uptr;
+_sim_clock_heap_sift_up (sim_clock_heap_count - 1);
+return SCPE_OK;
+}
+
+static void _sim_clock_heap_remove (UNIT *uptr)
+{
+int32 i = uptr->q_index - 1;
+UNIT *last = sim_clock_heap[--sim_clock_heap_count];
+
+uptr->q_index = 0;
+if (last == uptr)
+    return;
+_sim_clock_heap_place (i, last);
+if ((i > 0) && _sim_clock_heap_before (last, sim_clock_heap[(i - 1) / 2]))
+    _sim_clock_heap_sift_up (i);
+else
+    _sim_clock_heap_sift_down (i);
+}
+
+/* Point sim_clock_queue at the earliest event and reload sim_interval.
+   The caller must have just done UPDATE_SIM_TIME. */
+
+static void _sim_clock_heap_reload (void)
+{
+if (sim_clock_heap_count == 0) {
+    sim_clock_queue = QUEUE_LIST_END;
+    sim_interval = noqueue_time = NOQUEUE_WAIT;
+    }
+else {
+    sim_clock_queue = sim_clock_heap[0];
+    sim_interval = noqueue_time = (int32)(sim_clock_queue->q_due_time - sim_clock_heap_time);
+    }
+}
+
+static int _sim_clock_heap_compare (const void *pa, const void *pb)
+{
+UNIT *a = *(UNIT * const *)pa;
+UNIT *b = *(UNIT * const *)pb;
+
+if (_sim_clock_heap_before (a, b))
+    return -1;
+return _sim_clock_heap_before (b, a) ? 1 : 0;
+}
+
+/* Return a malloc'd copy of the queued units in due time order */
+
+static UNIT **_sim_clock_heap_sorted (void)
+{
+UNIT **list = (UNIT **)malloc ((sim_clock_heap_count + 1) * sizeof (*list));
+
+if (list == NULL)
+    return NULL;
+if (sim_clock_heap_count)
+    memcpy (list, sim_clock_heap, sim_clock_heap_count * sizeof (*list));
+qsort (list, sim_clock_heap_count, sizeof (*list), _sim_clock_heap_compare);
+list[sim_clock_heap_count] = QUEUE_LIST_END;
+return list;
+}
+#endif /* !defined (SIM_CLOCK_QUEUE_LIST) */
+
 t_stat sim_process_event (void)
 {
 UNIT *uptr;
@@ -11109,6 +11877,7 @@ if (sim_clock_queue == QUEUE_LIST_END) {                /* queue empty? */
 sim_processing_event = TRUE;
 do {
     uptr = sim_clock_queue;                             /* get first */
+#if defined (SIM_CLOCK_QUEUE_LIST)
     sim_clock_queue = uptr->next;                       /* remove first */
     uptr->next = NULL;                                  /* hygiene */
     uptr->time = 0;
@@ -11116,6 +11885,12 @@ do {
         sim_interval += sim_clock_queue->time;
     else
         sim_interval = noqueue_time = NOQUEUE_WAIT;
+#else
+    _sim_clock_heap_remove (uptr);                      /* remove first */
+    uptr->next = NULL;                                  /* hygiene */
+    uptr->time = 0;
+    _sim_clock_heap_reload ();
+#endif
     AIO_EVENT_BEGIN(uptr);
     if (uptr->usecs_remaining) {
         sim_debug (SIM_DBG_EVENT, &sim_scp_dev, "Requeueing %s after %.0f usecs\n", sim_uname (uptr), uptr->usecs_remaining);
@@ -11178,8 +11953,12 @@ return _sim_activate (uptr, event_time);
 
 t_stat _sim_activate (UNIT *uptr, int32 event_time)
 {
+#if defined (SIM_CLOCK_QUEUE_LIST)
 UNIT *cptr, *prvptr;
 int32 accum;
+#else
+t_stat r;
+#endif
 
 AIO_ACTIVATE (_sim_activate, uptr, event_time);
 if (sim_is_active (uptr))                               /* already active? */
@@ -11188,6 +11967,17 @@ UPDATE_SIM_TIME;                                        /* update sim time */
 
 sim_debug (SIM_DBG_ACTIVATE, &sim_scp_dev, "Activating %s delay=%d\n", sim_uname (uptr), event_time);
 
+#if !defined (SIM_CLOCK_QUEUE_LIST)
+uptr->q_due_time = sim_clock_heap_time + event_time;
+uptr->q_seq = sim_clock_heap_seq++;
+r = _sim_clock_heap_insert (uptr);
+if (r != SCPE_OK)
+    return r;
+uptr->next = QUEUE_LIST_END;                            /* mark active */
+uptr->time = event_time;
+_sim_clock_heap_reload ();
+return SCPE_OK;
+#else
 prvptr = NULL;
 accum = 0;
 for (cptr = sim_clock_queue; cptr != QUEUE_LIST_END; cptr = cptr->next) {
@@ -11209,6 +11999,7 @@ if (cptr != QUEUE_LIST_END)
     cptr->time = cptr->time - uptr->time;
 sim_interval = sim_clock_queue->time;
 return SCPE_OK;
+#endif
 }
 
 /* sim_activate_abs - activate (queue) event even if event already scheduled
@@ -11306,7 +12097,9 @@ return sim_timer_activate_after (uptr, usec_delay);
 
 t_stat sim_cancel (UNIT *uptr)
 {
+#if defined (SIM_CLOCK_QUEUE_LIST)
 UNIT *cptr, *nptr;
+#endif
 
 AIO_VALIDATE(uptr);
 if ((uptr->cancel) && uptr->cancel (uptr))
@@ -11321,6 +12114,15 @@ UPDATE_SIM_TIME;                                        /* update sim time */
 if (!sim_is_active (uptr))
     return SCPE_OK;
 sim_debug (SIM_DBG_EVENT, &sim_scp_dev, "Canceling Event for %s\n", sim_uname(uptr));
+#if !defined (SIM_CLOCK_QUEUE_LIST)
+if (_sim_clock_heap_member (uptr)) {
+    _sim_clock_heap_remove (uptr);
+    uptr->next = NULL;                                  /* hygiene */
+    uptr->time = 0;
+    }
+uptr->usecs_remaining = 0;
+_sim_clock_heap_reload ();
+#else
 nptr = QUEUE_LIST_END;
 
 if (sim_clock_queue == uptr) {
@@ -11345,6 +12147,7 @@ if (sim_clock_queue != QUEUE_LIST_END)
     sim_interval = sim_clock_queue->time;
 else
     sim_interval = noqueue_time = NOQUEUE_WAIT;
+#endif
 if (uptr->next) {
     sim_printf ("Cancel failed for %s\n", sim_uname(uptr));
     if (sim_deb)
@@ -11377,8 +12180,21 @@ return (((uptr->next) || AIO_IS_ACTIVE(uptr) || ((uptr->dynflags & UNIT_TMR_UNIT
         result =        absolute activation time + 1, 0 if inactive
 */
 
+#if !defined (SIM_CLOCK_QUEUE_LIST)
+/* Instructions remaining until a queued entry is due, without
+   disturbing the current interval count */
+
+static int32 _sim_clock_heap_remaining (UNIT *uptr)
+{
+double remaining = uptr->q_due_time - (sim_clock_heap_time + (noqueue_time - sim_interval));
+
+return (remaining > 0) ? (int32)remaining : 0;
+}
+#endif
+
 int32 _sim_activate_queue_time (UNIT *uptr)
 {
+#if defined (SIM_CLOCK_QUEUE_LIST)
 UNIT *cptr;
 int32 accum;
 
@@ -11394,6 +12210,11 @@ for (cptr = sim_clock_queue; cptr != QUEUE_LIST_END; cptr = cptr->next) {
         return accum + 1;
     }
 return 0;
+#else
+if (!_sim_clock_heap_member (uptr))
+    return 0;
+return _sim_clock_heap_remaining (uptr) + 1;
+#endif
 }
 
 int32 _sim_activate_time (UNIT *uptr)
@@ -11418,14 +12239,21 @@ return _sim_activate_time (uptr);
 
 double sim_activate_time_usecs (UNIT *uptr)
 {
+#if defined (SIM_CLOCK_QUEUE_LIST)
 UNIT *cptr;
 int32 accum;
+#endif
 double result;
 
 AIO_VALIDATE(uptr);
 result = sim_timer_activate_time_usecs (uptr);
 if (result >= 0)
     return result;
+#if !defined (SIM_CLOCK_QUEUE_LIST)
+if (_sim_clock_heap_member (uptr))
+    return 1.0 + uptr->usecs_remaining + ((1000000.0 * _sim_clock_heap_remaining (uptr)) / sim_timer_inst_per_sec ());
+return 0.0;
+#else
 accum = 0;
 for (cptr = sim_clock_queue; cptr != QUEUE_LIST_END; cptr = cptr->next) {
     if (cptr == sim_clock_queue) {
@@ -11438,6 +12266,7 @@ for (cptr = sim_clock_queue; cptr != QUEUE_LIST_END; cptr = cptr->next) {
         return 1.0 + uptr->usecs_remaining + ((1000000.0 * accum) / sim_timer_inst_per_sec ());
     }
 return 0.0;
+#endif
 }
 
 /* sim_gtime - return global time
@@ -11471,6 +12300,7 @@ return sim_rtime;
 
 int32 sim_qcount (void)
 {
+#if defined (SIM_CLOCK_QUEUE_LIST)
 int32 cnt;
 UNIT *uptr;
 
@@ -11478,6 +12308,9 @@ cnt = 0;
 for (uptr = sim_clock_queue; uptr != QUEUE_LIST_END; uptr = uptr->next)
     cnt++;
 return cnt;
+#else
+return sim_clock_heap_count;
+#endif
 }
 
 /* Breakpoint package.  This module replaces the VM-implemented one
@@ -11499,6 +12332,11 @@ return cnt;
    is the bitwise OR of all the type fields).  A simulator need only check for
    a breakpoint of type X if bit SWMASK('X') is set in sim_brk_summ.
 
+   sim_brk_map refines the summary by address: entry SIM_BRK_MAP_IDX(addr) is
+   the OR of the type fields of the breakpoints whose addresses hash to it.
+   sim_brk_test (and the SIM_BRK_TEST macro) consult it before searching the
+   table, so only addresses on a page holding a breakpoint pay for the search.
+
    The package contains the following public routines:
 
         sim_brk_init            initialize
@@ -11536,6 +12374,7 @@ sim_brk_tab = (BRKTAB **) realloc (sim_brk_tab, sim_brk_lnt*sizeof (BRKTAB*));
 if (sim_brk_tab == NULL)
     return SCPE_MEM;
 memset (sim_brk_tab, 0, sim_brk_lnt*sizeof (BRKTAB*));
+memset (sim_brk_map, 0, sizeof (sim_brk_map));
 sim_brk_ent = sim_brk_ins = 0;
 sim_brk_clract ();
 sim_brk_npc (0);
@@ -11669,6 +12508,7 @@ if ((act != NULL) && (*act != 0)) {                     /* new action? */
     bp->act = newp;                                     /* set pointer */
     }
 sim_brk_summ = sim_brk_summ | (sw & ~BRK_TYP_TEMP);
+sim_brk_map[SIM_BRK_MAP_IDX (loc)] |= (sw & ~BRK_TYP_TEMP);
 return SCPE_OK;
 }
 
@@ -11706,10 +12546,12 @@ if (sim_brk_tab[sim_brk_ins] == NULL) {                 /* erased entry */
         sim_brk_tab[i] = sim_brk_tab[i+1];
     }
 sim_brk_summ = 0;                                       /* recalc summary */
+memset (sim_brk_map, 0, sizeof (sim_brk_map));          /* and page map */
 for (i = 0; i < sim_brk_ent; i++) {
     bp = sim_brk_tab[i];
     while (bp) {
         sim_brk_summ |= (bp->typ & ~BRK_TYP_TEMP);
+        sim_brk_map[SIM_BRK_MAP_IDX (bp->addr)] |= (bp->typ & ~BRK_TYP_TEMP);
         bp = bp->next;
         }
     }
@@ -11855,6 +12697,8 @@ uint32 spc = (btyp >> SIM_BKPT_V_SPC) & (SIM_BKPT_N_SPC - 1);
 if (sim_brk_summ & BRK_TYP_DYN_ALL)
     btyp |= BRK_TYP_DYN_ALL;
 
+if (!(sim_brk_map[SIM_BRK_MAP_IDX (loc)] & btyp))       /* none of these types on page? */
+    return 0;
 if ((bp = sim_brk_fnd_ex (loc, btyp, TRUE, spc))) {     /* in table, and type match? */
     if (bp->time_fired[spc] == sim_time)                /* already taken?  */
         return 0;
@@ -12141,6 +12985,261 @@ for (i=start_rule; i<exp->size; i++)
 return NULL;
 }
 
+/* Compiled expect rule matching
+
+   The match strings of all literal rules are compiled into a single
+   Aho-Corasick automaton.  Each output byte advances the automaton with
+   one table lookup and every state records the lowest numbered rule
+   whose match string ends there, so checking literal rules costs the
+   same no matter how many of them are defined.  Bytes are mapped into
+   classes (one for each distinct byte present in any match string plus
+   one for everything else) to keep the transition table small.
+
+   Regular expression rules still need pcre_exec, but a pattern which
+   always ends with a particular literal character, and which can't
+   examine text beyond the end of its match, can only begin to match when
+   that character arrives since it didn't match the data before it.
+   Such rules are skipped for all other bytes.  Every regex rule is
+   checked once after the rules change or the buffer slides.
+
+   The matcher is discarded whenever the rule list changes and is rebuilt,
+   and resynchronized with the buffered data, when the next byte arrives.
+*/
+
+struct sim_exp_matcher {
+    int32               states;                         /* automaton state count */
+    int32               classes;                        /* byte class count */
+    uint16              cls[256];                       /* byte to class map */
+    int32               *delta;                         /* state transitions [states][classes] */
+    int32               *rule;                          /* lowest matching rule per state (rule count if none) */
+    uint32              *depth;                         /* matched prefix length per state */
+    int32               state;                          /* current automaton state */
+    int32               first_regex;                    /* lowest regex rule number (rule count if none) */
+#if defined(USE_REGEX)
+    int32               regex_count;                    /* count of regex rules */
+    struct sim_exp_regex {
+        int32           rule;                           /* rule number */
+        int             last;                           /* final character of every match (-1 if unknown) */
+        int             *ovector;                       /* match offset vector */
+        }               *regex;
+    t_bool              regex_all;                      /* check every regex rule on the next byte */
+#endif
+    };
+
+static void _sim_exp_matcher_free (EXPECT *exp)
+{
+struct sim_exp_matcher *m = exp->matcher;
+
+if (m == NULL)
+    return;
+#if defined(USE_REGEX)
+while (m->regex_count > 0)
+    free (m->regex[--m->regex_count].ovector);
+free (m->regex);
+#endif
+free (m->delta);
+free (m->rule);
+free (m->depth);
+free (m);
+exp->matcher = NULL;
+}
+
+/* Position the automaton as if the buffered data had just been checked */
+
+static void _sim_exp_matcher_sync (EXPECT *exp, struct sim_exp_matcher *m)
+{
+uint32 off = (exp->buf_data > exp->buf_ins) ? exp->buf_ins + exp->buf_size - exp->buf_data : exp->buf_ins - exp->buf_data;
+uint32 n;
+
+m->state = 0;
+for (n = 0; n < exp->buf_data; n++) {
+    m->state = m->delta[m->state * m->classes + m->cls[exp->buf[off++]]];
+    if (off == exp->buf_size)                           /* wrapped data? */
+        off = 0;
+    }
+}
+
+#if defined(USE_REGEX)
+/* Determine the character which ends every match of a regex rule, or -1
+   when the pattern isn't simple enough to be sure that any new match must
+   end with the most recently arrived character */
+
+static int _sim_exp_regex_last (const EXPTAB *ep)
+{
+const char *cptr = ep->match_pattern + 1;               /* skip surrounding quotes */
+const char *eptr = ep->match_pattern + strlen (ep->match_pattern) - 1;
+const char *esc;
+int last = -1;
+
+while (cptr < eptr) {
+    switch (*cptr) {
+        case '|':                                       /* alternation */
+        case '$':                                       /* end anchor */
+            return -1;
+        case '(':
+            if ((cptr[1] == '?') || (cptr[1] == '*'))   /* lookaround, options or verb */
+                return -1;
+            last = -1;
+            break;
+        case '[':                                       /* character class */
+            if (*++cptr == '^')
+                ++cptr;
+            if (*cptr == ']')
+                ++cptr;
+            while ((cptr < eptr) && (*cptr != ']')) {
+                if ((*cptr == '\\') && (cptr + 1 < eptr))
+                    ++cptr;
+                ++cptr;
+                }
+            last = -1;
+            break;
+        case '\\':
+            if (++cptr == eptr)
+                return -1;
+            if (sim_isalnum ((uint8)*cptr)) {
+                if (strchr ("dDsSwWhHvV", *cptr))       /* character type */
+                    last = -1;
+                else {
+                    if ((esc = strchr ("nrtfea", *cptr)) == NULL)
+                        return -1;                      /* assertion, reference or numeric escape */
+                    last = (uint8)"\n\r\t\f\033\007"[esc - "nrtfea"];
+                    }
+                }
+            else
+                last = (uint8)*cptr;                    /* escaped punctuation */
+            break;
+        case '^': case '.': case '?': case '*': case '+':
+        case ')': case '{': case '}': case ']':
+            last = -1;
+            break;
+        default:
+            last = (uint8)*cptr;
+            break;
+        }
+    ++cptr;
+    }
+if ((last >= 0) && (ep->switches & EXP_TYP_REGEX_I)) {
+    if (last & 0x80)
+        return -1;
+    last = sim_tolower (last);
+    }
+return last;
+}
+#endif
+
+static struct sim_exp_matcher *_sim_exp_matcher_build (EXPECT *exp)
+{
+struct sim_exp_matcher *m = (struct sim_exp_matcher *)calloc (1, sizeof (*m));
+int32 *fail = NULL, *queue = NULL;
+int32 i, c, s, max_states = 1, head = 0, tail = 0;
+uint32 j;
+
+if (m == NULL)
+    return NULL;
+exp->matcher = m;
+m->classes = 1;                                         /* class 0 is bytes in no match string */
+m->first_regex = exp->size;
+for (i=0; i<exp->size; i++) {
+    EXPTAB *ep = &exp->rules[i];
+
+    if (ep->switches & EXP_TYP_REGEX) {
+        if (m->first_regex == exp->size)
+            m->first_regex = i;
+#if defined(USE_REGEX)
+        ++m->regex_count;
+#endif
+        continue;
+        }
+    for (j=0; j<ep->size; j++)
+        if (m->cls[ep->match[j]] == 0)
+            m->cls[ep->match[j]] = (uint16)m->classes++;
+    max_states += ep->size;
+    }
+m->delta = (int32 *)malloc (max_states * m->classes * sizeof (*m->delta));
+m->rule = (int32 *)malloc (max_states * sizeof (*m->rule));
+m->depth = (uint32 *)calloc (max_states, sizeof (*m->depth));
+fail = (int32 *)calloc (max_states, sizeof (*fail));
+queue = (int32 *)malloc (max_states * sizeof (*queue));
+if ((m->delta == NULL) || (m->rule == NULL) || (m->depth == NULL) || (fail == NULL) || (queue == NULL))
+    goto Error;
+for (s=0; s<max_states * m->classes; s++)
+    m->delta[s] = -1;
+for (s=0; s<max_states; s++)
+    m->rule[s] = exp->size;
+m->states = 1;
+for (i=0; i<exp->size; i++) {                           /* build the match string trie */
+    EXPTAB *ep = &exp->rules[i];
+
+    if (ep->switches & EXP_TYP_REGEX)
+        continue;
+    for (j=0, s=0; j<ep->size; j++) {
+        int32 *next = &m->delta[s * m->classes + m->cls[ep->match[j]]];
+
+        if (*next < 0) {
+            *next = m->states++;
+            m->depth[*next] = m->depth[s] + 1;
+            }
+        s = *next;
+        }
+    if (m->rule[s] == exp->size)                        /* earlier rules take precedence */
+        m->rule[s] = i;
+    }
+for (c=0; c<m->classes; c++) {                          /* root transitions */
+    if (m->delta[c] < 0)
+        m->delta[c] = 0;
+    else
+        queue[tail++] = m->delta[c];
+    }
+while (head < tail) {                                   /* breadth first failure links */
+    s = queue[head++];
+    if (m->rule[fail[s]] < m->rule[s])                  /* shorter match strings end here too */
+        m->rule[s] = m->rule[fail[s]];
+    for (c=0; c<m->classes; c++) {
+        int32 *next = &m->delta[s * m->classes + c];
+
+        if (*next < 0)
+            *next = m->delta[fail[s] * m->classes + c];
+        else {
+            fail[*next] = m->delta[fail[s] * m->classes + c];
+            queue[tail++] = *next;
+            }
+        }
+    }
+#if defined(USE_REGEX)
+if (m->regex_count) {
+    int32 r = 0;
+
+    m->regex = (struct sim_exp_regex *)calloc (m->regex_count, sizeof (*m->regex));
+    if (m->regex == NULL) {
+        m->regex_count = 0;
+        goto Error;
+        }
+    for (i=0; i<exp->size; i++) {
+        EXPTAB *ep = &exp->rules[i];
+
+        if (!(ep->switches & EXP_TYP_REGEX))
+            continue;
+        m->regex[r].rule = i;
+        m->regex[r].last = _sim_exp_regex_last (ep);
+        m->regex[r].ovector = (int *)malloc (3 * (ep->re_nsub + 1) * sizeof (int));
+        if (m->regex[r++].ovector == NULL)
+            goto Error;
+        }
+    m->regex_all = TRUE;
+    }
+#endif
+free (fail);
+free (queue);
+_sim_exp_matcher_sync (exp, m);
+return m;
+
+Error:
+free (fail);
+free (queue);
+_sim_exp_matcher_free (exp);
+return NULL;
+}
+
 /* Clear (delete) an expect rule */
 
 t_stat sim_exp_clr_tab (EXPECT *exp, EXPTAB *ep)
@@ -12149,6 +13248,7 @@ int32 i;
 
 if (!ep)                                                /* not there? ok */
     return SCPE_OK;
+_sim_exp_matcher_free (exp);                            /* rules are changing */
 free (ep->match);                                       /* deallocate match string */
 free (ep->match_pattern);                               /* deallocate the display format match string */
 free (ep->act);                                         /* deallocate action */
@@ -12195,6 +13295,7 @@ for (i=0; i<exp->size; i++) {
 free (exp->rules);
 exp->rules = NULL;
 exp->size = 0;
+_sim_exp_matcher_free (exp);
 free (exp->buf);
 exp->buf = NULL;
 exp->buf_size = 0;
@@ -12261,6 +13362,7 @@ exp->rules = (EXPTAB *) realloc (exp->rules, sizeof (*exp->rules)*(exp->size + 1
 ep = &exp->rules[exp->size];
 exp->size += 1;
 memset (ep, 0, sizeof(*ep));
+_sim_exp_matcher_free (exp);                            /* rules are changing */
 ep->after = after;                                     /* set halt after value */
 ep->match_pattern = (char *)malloc (strlen (match) + 1);
 if (ep->match_pattern)
@@ -12317,6 +13419,7 @@ for (i=0; i<exp->size; i++) {
     uint32 compare_size = (exp->rules[i].switches & EXP_TYP_REGEX) ? MAX(10 * strlen(ep->match_pattern), 1024) : exp->rules[i].size;
     if (compare_size >= exp->buf_size) {
         exp->buf = (uint8 *)realloc (exp->buf, compare_size + 2); /* Extra byte to null terminate regex compares */
+        memset (&exp->buf[exp->buf_size], 0, compare_size + 2 - exp->buf_size);
         exp->buf_size = compare_size + 1;
         }
     }
@@ -12401,128 +13504,92 @@ t_stat sim_exp_check (EXPECT *exp, uint8 data)
 {
 int32 i;
 EXPTAB *ep;
-int regex_checks = 0;
+struct sim_exp_matcher *m;
+#if defined (USE_REGEX)
+static size_t sim_exp_match_sub_count = 0;
+int32 r;
+char *cbuf = NULL;
+size_t cbuf_len = 0;
+#endif
 char *tstr = NULL;
 
 if ((!exp) || (!exp->rules))                            /* Anying to check? */
     return SCPE_OK;
 
+m = exp->matcher;
+if ((m == NULL) &&                                      /* Rules changed? */
+    ((m = _sim_exp_matcher_build (exp)) == NULL))
+    return SCPE_MEM;
+
 exp->buf[exp->buf_ins++] = data;                        /* Save new data */
 exp->buf[exp->buf_ins] = '\0';                          /* Nul terminate for RegEx match */
 if (exp->buf_data < exp->buf_size)
     ++exp->buf_data;                                    /* Record amount of data in buffer */
 
-for (i=0; i < exp->size; i++) {
-    ep = &exp->rules[i];
-    if (ep->switches & EXP_TYP_REGEX) {
-#if defined (USE_REGEX)
-        int *ovector = NULL;
-        int rc;
-        char *cbuf = (char *)exp->buf;
-        static size_t sim_exp_match_sub_count = 0;
-
-        if (tstr)
-            cbuf = tstr;
-        else {
-            if (strlen ((char *)exp->buf) != exp->buf_ins) { /* Nul characters in buffer? */
-                size_t off;
+m->state = m->delta[m->state * m->classes + m->cls[data]];
+i = m->rule[m->state];                                  /* First literal rule matched (if any) */
 
-                tstr = (char *)malloc (exp->buf_ins + 1);
-                tstr[0] = '\0';
-                for (off=0; off < exp->buf_ins; off += 1 + strlen ((char *)&exp->buf[off]))
-                    strcpy (&tstr[strlen (tstr)], (char *)&exp->buf[off]);
+#if defined (USE_REGEX)
+for (r=0; (r < m->regex_count) && (m->regex[r].rule < i); r++) {
+    struct sim_exp_regex *rp = &m->regex[r];
+    int rc;
+
+    ep = &exp->rules[rp->rule];
+    if ((!m->regex_all) && (rp->last >= 0) &&
+        (rp->last != ((ep->switches & EXP_TYP_REGEX_I) ? sim_tolower (data) : data)))
+        continue;                                       /* Can't have started matching */
+    if (cbuf == NULL) {
+        cbuf = (char *)exp->buf;
+        cbuf_len = exp->buf_ins;
+        if (strlen (cbuf) != cbuf_len) {                /* Nul characters in buffer? */
+            size_t off;
+
+            tstr = (char *)malloc (exp->buf_ins + 1);
+            if (tstr != NULL) {
+                for (off=cbuf_len=0; off < exp->buf_ins; off++)
+                    if (exp->buf[off])
+                        tstr[cbuf_len++] = (char)exp->buf[off];
+                tstr[cbuf_len] = '\0';
                 cbuf = tstr;
                 }
             }
-        ++regex_checks;
-        ovector = (int *)malloc (3 * (ep->re_nsub + 1) * sizeof (*ovector));
-        if (sim_deb && exp->dptr && (exp->dptr->dctrl & exp->dbit)) {
-            char *estr = sim_encode_quoted_string (exp->buf, exp->buf_ins);
-            sim_debug (exp->dbit, exp->dptr, "Checking String: %s\n", estr);
-            sim_debug (exp->dbit, exp->dptr, "Against RegEx Match Rule: %s\n", ep->match_pattern);
-            free (estr);
-            }
-        rc = pcre_exec (ep->regex, NULL, cbuf, exp->buf_ins, 0, PCRE_NOTBOL, ovector, 3 * (ep->re_nsub + 1));
-        if (rc >= 0) {
-            size_t j;
-            char *buf = (char *)malloc (1 + exp->buf_ins);
-
-            for (j=0; j < (size_t)rc; j++) {
-                char env_name[32];
-
-                sprintf (env_name, "_EXPECT_MATCH_GROUP_%d", (int)j);
-                memcpy (buf, &cbuf[ovector[2 * j]], ovector[2 * j + 1] - ovector[2 * j]);
-                buf[ovector[2 * j + 1] - ovector[2 * j]] = '\0';
-                setenv (env_name, buf, 1);      /* Make the match and substrings available as environment variables */
-                sim_debug (exp->dbit, exp->dptr, "%s=%s\n", env_name, buf);
-                }
-            for (; j<sim_exp_match_sub_count; j++) {
-                char env_name[32];
-
-                sprintf (env_name, "_EXPECT_MATCH_GROUP_%d", (int)j);
-                setenv (env_name, "", 1);      /* Remove previous extra environment variables */
-                }
-            sim_exp_match_sub_count = ep->re_nsub;
-            free (ovector);
-            ovector = NULL;
-            free (buf);
-            break;
-            }
-        free (ovector);
-#endif
         }
-    else {
-        if (exp->buf_data < ep->size)                           /* Too little data to match yet? */
-            continue;                                           /* Yes, Try next one. */
-        if (exp->buf_ins < ep->size) {                          /* Match might stradle end of buffer */
-            /* 
-             * First compare the newly deposited data at the beginning 
-             * of buffer with the end of the match string
-             */
-            if (exp->buf_ins) {
-                if (sim_deb && exp->dptr && (exp->dptr->dctrl & exp->dbit)) {
-                    char *estr = sim_encode_quoted_string (exp->buf, exp->buf_ins);
-                    char *mstr = sim_encode_quoted_string (&ep->match[ep->size-exp->buf_ins], exp->buf_ins);
-
-                    sim_debug (exp->dbit, exp->dptr, "Checking String[0:%d]: %s\n", exp->buf_ins, estr);
-                    sim_debug (exp->dbit, exp->dptr, "Against Match Data: %s\n", mstr);
-                    free (estr);
-                    free (mstr);
-                    }
-                if (memcmp (exp->buf, &ep->match[ep->size-exp->buf_ins], exp->buf_ins)) /* Tail Match? */
-                    continue;                                   /* Nope, Try next one. */
-                }
-            if (sim_deb && exp->dptr && (exp->dptr->dctrl & exp->dbit)) {
-                char *estr = sim_encode_quoted_string (&exp->buf[exp->buf_size-(ep->size-exp->buf_ins)], ep->size-exp->buf_ins);
-                char *mstr = sim_encode_quoted_string (ep->match, ep->size-exp->buf_ins);
-
-                sim_debug (exp->dbit, exp->dptr, "Checking String[%d:%d]: %s\n", exp->buf_size-(ep->size-exp->buf_ins), ep->size-exp->buf_ins, estr);
-                sim_debug (exp->dbit, exp->dptr, "Against Match Data: %s\n", mstr);
-                free (estr);
-                free (mstr);
-                }
-            if (memcmp (&exp->buf[exp->buf_size-(ep->size-exp->buf_ins)], ep->match, ep->size-exp->buf_ins)) /* Front Match? */
-                continue;                                       /* Nope, Try next one. */
-            break;
+    if (sim_deb && exp->dptr && (exp->dptr->dctrl & exp->dbit)) {
+        char *estr = sim_encode_quoted_string (exp->buf, exp->buf_ins);
+        sim_debug (exp->dbit, exp->dptr, "Checking String: %s\n", estr);
+        sim_debug (exp->dbit, exp->dptr, "Against RegEx Match Rule: %s\n", ep->match_pattern);
+        free (estr);
+        }
+    rc = pcre_exec (ep->regex, NULL, cbuf, (int)cbuf_len, 0, PCRE_NOTBOL, rp->ovector, 3 * (ep->re_nsub + 1));
+    if (rc >= 0) {
+        size_t j;
+        char *buf = (char *)malloc (1 + cbuf_len);
+
+        for (j=0; j < (size_t)rc; j++) {
+            char env_name[32];
+
+            sprintf (env_name, "_EXPECT_MATCH_GROUP_%d", (int)j);
+            memcpy (buf, &cbuf[rp->ovector[2 * j]], rp->ovector[2 * j + 1] - rp->ovector[2 * j]);
+            buf[rp->ovector[2 * j + 1] - rp->ovector[2 * j]] = '\0';
+            setenv (env_name, buf, 1);      /* Make the match and substrings available as environment variables */
+            sim_debug (exp->dbit, exp->dptr, "%s=%s\n", env_name, buf);
             }
-        else {
-            if (sim_deb && exp->dptr && (exp->dptr->dctrl & exp->dbit)) {
-                char *estr = sim_encode_quoted_string (&exp->buf[exp->buf_ins-ep->size], ep->size);
-                char *mstr = sim_encode_quoted_string (ep->match, ep->size);
-
-                sim_debug (exp->dbit, exp->dptr, "Checking String[%d:%d]: %s\n", exp->buf_ins-ep->size, ep->size, estr);
-                sim_debug (exp->dbit, exp->dptr, "Against Match Data: %s\n", mstr);
-                free (estr);
-                free (mstr);
-                }
-            if (memcmp (&exp->buf[exp->buf_ins-ep->size], ep->match, ep->size)) /* Whole string match? */
-                continue;                                       /* Nope, Try next one. */
-            break;
+        for (; j<sim_exp_match_sub_count; j++) {
+            char env_name[32];
+
+            sprintf (env_name, "_EXPECT_MATCH_GROUP_%d", (int)j);
+            setenv (env_name, "", 1);      /* Remove previous extra environment variables */
             }
+        sim_exp_match_sub_count = ep->re_nsub;
+        free (buf);
+        i = rp->rule;
+        break;
         }
     }
+m->regex_all = FALSE;
+#endif
 if (exp->buf_ins == exp->buf_size) {                    /* At end of match buffer? */
-    if (regex_checks) {
+    if (m->first_regex < i) {
         /* When processing regular expressions, let the match buffer fill 
            up and then shuffle the buffer contents down by half the buffer size
            so that the regular expression has a single contiguous buffer to 
@@ -12532,6 +13599,11 @@ if (exp->buf_ins == exp->buf_size) {                    /* At end of match buffe
         exp->buf_ins -= exp->buf_size/2;
         exp->buf_data = exp->buf_ins;
         sim_debug (exp->dbit, exp->dptr, "Buffer Full - sliding the last %d bytes to start of buffer new insert at: %d\n", (exp->buf_size/2), exp->buf_ins);
+        if (m->depth[m->state] > exp->buf_data)         /* Partial match string discarded? */
+            _sim_exp_matcher_sync (exp, m);
+#if defined (USE_REGEX)
+        m->regex_all = TRUE;
+#endif
         }
     else {
         exp->buf_ins = 0;                               /* wrap around to beginning */
@@ -12539,6 +13611,7 @@ if (exp->buf_ins == exp->buf_size) {                    /* At end of match buffe
         }
     }
 if (i != exp->size) {                                   /* Found? */
+    ep = &exp->rules[i];
     sim_debug (exp->dbit, exp->dptr, "Matched expect pattern: %s\n", ep->match_pattern);
     setenv ("_EXPECT_MATCH_PATTERN", ep->match_pattern, 1);   /* Make the match detail available as an environment variable */
     if (ep->cnt > 0) {
@@ -12570,6 +13643,8 @@ if (i != exp->size) {                                   /* Found? */
         }
     /* Matched data is no longer available for future matching */
     exp->buf_data = exp->buf_ins = 0;
+    if (exp->matcher)
+        exp->matcher->state = 0;
     }
 free (tstr);
 return SCPE_OK;
@@ -12725,10 +13800,65 @@ size_t debug_line_bufsize = 0;
 size_t debug_line_offset = 0;
 size_t debug_line_count = 0;
 
+/* Binary debug trace.  When debug output is recorded in a trace buffer
+   (SET DEBUG -Z), sim_debug() messages are not formatted as they occur.
+   Each one is saved in a preallocated ring of fixed size records holding
+   the simulated time, the device, unit and matched debug bits, the format
+   string (whose address serves as the message's format id) and the raw
+   argument values.  The messages are formatted only when the trace is
+   displayed (SHOW DEBUG TRACE) or written out (SET NODEBUG), and they
+   produce exactly the text that formatting them at once would have.
+
+   Producers claim a record by advancing debug_trace_next, without a lock
+   when the asynchronous I/O intrinsics are available, and publish it by
+   storing its sequence number last.  Output which is already text (data
+   blobs, or formats the trace can't represent) is kept as text records. */
+
+#define DEBUG_TRACE_ARGS    16          /* max arguments per message */
+#define DEBUG_TRACE_WORDS   24          /* argument words per record */
+#define DEBUG_TRACE_ARGV    0           /* record holds format arguments */
+#define DEBUG_TRACE_MSG     1           /* record holds formatted message text */
+#define DEBUG_TRACE_RAW     2           /* record holds raw debug output */
+
+typedef union DEBUG_TRACE_ARG {
+    LL_TYPE             i;              /* integer argument */
+    double              d;              /* floating point argument */
+    const void          *p;             /* pointer argument */
+    const char          *s;             /* string argument */
+    } DEBUG_TRACE_ARG;
+
+typedef struct DEBUG_TRACE_REC {
+    size_t              seq;            /* record number + 1, 0 while being written */
+    double              time;           /* simulated time */
+    struct timespec     tod;            /* time of day (-T, -A or -R) */
+    t_value             pc;             /* PC value (-P) */
+    DEVICE              *dptr;          /* device */
+    UNIT                *uptr;          /* unit (or NULL) */
+    const char          *fmt;           /* format string */
+    uint32              dbits;          /* matched debug bits */
+    uint16              kind;           /* record contents */
+    uint16              len;            /* data bytes in use */
+    t_bool              main;           /* recorded by the main thread */
+    DEBUG_TRACE_ARG     data[DEBUG_TRACE_WORDS];
+    } DEBUG_TRACE_REC;
+
+static DEBUG_TRACE_REC *debug_trace = NULL;     /* trace ring */
+static size_t debug_trace_count = 0;            /* records in ring */
+static volatile size_t debug_trace_next = 0;    /* next record number */
+static t_bool debug_trace_rendering = FALSE;    /* writing out trace contents */
+static FILE *debug_trace_st = NULL;             /* SHOW DEBUG TRACE destination */
+
+static t_bool _sim_debug_trace_vrec (uint32 dbits, DEVICE *dptr, UNIT *uptr, const char *fmt, va_list arglist);
+static void _sim_debug_trace_text (int32 kind, uint32 dbits, DEVICE *dptr, UNIT *uptr, const char *buf, size_t len);
+
 static void _debug_fwrite (const char *buf, size_t len)
 {
 size_t move_size;
 
+if (debug_trace_st != NULL) {                   /* SHOW DEBUG TRACE? */
+    fwrite (buf, 1, len, debug_trace_st);
+    return;
+    }
 if (sim_deb_buffer == NULL) {
     fwrite (buf, 1, len, sim_deb);              /* output now. */
     return;
@@ -12837,6 +13967,11 @@ AIO_UNLOCK;
 
 static void _sim_debug_write (const char *buf, size_t len)
 {
+if ((debug_trace != NULL) && !debug_trace_rendering) {
+    if (len > 0)                                    /* keep in trace */
+        _sim_debug_trace_text (DEBUG_TRACE_RAW, 0, NULL, NULL, buf, len);
+    return;
+    }
 _sim_debug_write_flush (buf, len, FALSE);
 }
 
@@ -12858,7 +13993,7 @@ if (sim_deb == sim_log) {                               /* debug is log */
     return SCPE_OK;
     }
 
-if (!(saved_deb_switches & SWMASK ('B'))) {
+if (!(saved_deb_switches & (SWMASK ('B') | SWMASK ('Z')))) {
     strcpy (saved_debug_filename, sim_logfile_name (sim_deb, sim_deb_ref));
 
     sim_quiet = 1;
@@ -12877,6 +14012,12 @@ return SCPE_OK;
 
 static const char *_get_dbg_verb (uint32 dbits, DEVICE* dptr, UNIT *uptr)
 {
+dbits &= (dptr->dctrl | (uptr ? uptr->dctrl : 0));/* Look for just the bits that matched */
+return _find_dbg_verb (dbits, dptr);
+}
+
+static const char *_find_dbg_verb (uint32 dbits, DEVICE* dptr)
+{
 static const char *debtab_none    = "DEBTAB_ISNULL";
 static const char *debtab_nomatch = "DEBTAB_NOMATCH";
 const char *some_match = NULL;
@@ -12885,8 +14026,6 @@ int32 offset = 0;
 if (dptr->debflags == 0)
     return debtab_none;
 
-dbits &= (dptr->dctrl | (uptr ? uptr->dctrl : 0));/* Look for just the bits that matched */
-
 /* Find matching words for bitmask */
 
 while (dptr->debflags[offset].name && (offset < 32)) {
@@ -12899,18 +14038,38 @@ while (dptr->debflags[offset].name && (offset < 32)) {
 return some_match ? some_match : debtab_nomatch;
 }
 
-/* Prints standard debug prefix unless previous call unterminated */
+/* Captures the time of day and PC value a debug prefix may display */
 
-static const char *sim_debug_prefix (uint32 dbits, DEVICE* dptr, UNIT* uptr)
+static void _sim_debug_stamp (struct timespec *time_now, t_value *pc)
+{
+memset (time_now, 0, sizeof (*time_now));
+*pc = 0;
+if (sim_deb_switches & (SWMASK ('T') | SWMASK ('R') | SWMASK ('A')))
+    clock_gettime(CLOCK_REALTIME, time_now);
+if (sim_deb_switches & SWMASK ('P')) {
+    /* Some simulators expose the PC as a register, some don't expose it or expose a register 
+       which is not a variable which is updated during instruction execution (i.e. only upon
+       exit of sim_instr()).  For the -P debug option to be effective, such a simulator should
+       provide a routine which returns the value of the current PC and set the sim_vm_pc_value
+       routine pointer to that routine.
+     */
+    if (sim_vm_pc_value)
+        *pc = (*sim_vm_pc_value)();
+    else
+        *pc = get_rval (sim_PC, 0);
+    }
+}
+
+/* Formats the standard debug prefix from its captured values */
+
+static const char *_sim_debug_prefix (const char *debug_type, DEVICE* dptr, double gtime, const struct timespec *tod, t_value val, t_bool main_thread)
 {
-const char* debug_type = _get_dbg_verb (dbits, dptr, uptr);
 char tim_t[32] = "";
 char tim_a[32] = "";
 char pc_s[64] = "";
-struct timespec time_now;
+struct timespec time_now = *tod;
 
 if (sim_deb_switches & (SWMASK ('T') | SWMASK ('R') | SWMASK ('A'))) {
-    clock_gettime(CLOCK_REALTIME, &time_now);
     if (sim_deb_switches & SWMASK ('R'))
         sim_timespec_diff (&time_now, &time_now, &sim_deb_basetime);
     if (sim_deb_switches & SWMASK ('T')) {
@@ -12924,25 +14083,25 @@ if (sim_deb_switches & (SWMASK ('T') | SWMASK ('R') | SWMASK ('A'))) {
         }
     }
 if (sim_deb_switches & SWMASK ('P')) {
-    t_value val;
-    
-    /* Some simulators expose the PC as a register, some don't expose it or expose a register 
-       which is not a variable which is updated during instruction execution (i.e. only upon
-       exit of sim_instr()).  For the -P debug option to be effective, such a simulator should
-       provide a routine which returns the value of the current PC and set the sim_vm_pc_value
-       routine pointer to that routine.
-     */
-    if (sim_vm_pc_value)
-        val = (*sim_vm_pc_value)();
-    else
-        val = get_rval (sim_PC, 0);
     sprintf(pc_s, "-%s:", sim_PC->name);
     sprint_val (&pc_s[strlen(pc_s)], val, sim_PC->radix, sim_PC->width, sim_PC->flags & REG_FMT);
     }
-sprintf(debug_line_prefix, "DBG(%s%s%.0f%s)%s> %s %s: ", tim_t, tim_a, sim_gtime(), pc_s, AIO_MAIN_THREAD ? "" : "+", dptr->name, debug_type);
+sprintf(debug_line_prefix, "DBG(%s%s%.0f%s)%s> %s %s: ", tim_t, tim_a, gtime, pc_s, main_thread ? "" : "+", dptr->name, debug_type);
 return debug_line_prefix;
 }
 
+/* Prints standard debug prefix unless previous call unterminated */
+
+static const char *sim_debug_prefix (uint32 dbits, DEVICE* dptr, UNIT* uptr)
+{
+const char* debug_type = _get_dbg_verb (dbits, dptr, uptr);
+struct timespec time_now;
+t_value val;
+
+_sim_debug_stamp (&time_now, &val);
+return _sim_debug_prefix (debug_type, dptr, sim_gtime(), &time_now, val, AIO_MAIN_THREAD);
+}
+
 void fprint_fields (FILE *stream, t_value before, t_value after, BITFIELD* bitdefs)
 {
 int32 i, fields, offset;
@@ -13163,6 +14322,45 @@ if (buf != stackbuf)
 return stat | ((stat != SCPE_OK) ? SCPE_NOMESSAGE : 0);
 }
 
+/* Outputs a formatted debug message, adding the prefix to each line */
+
+static void _sim_debug_emit (const char *debug_prefix, const char *buf, int32 len)
+{
+int32 i, j;
+
+for (i = j = 0; i < len; ++i) {
+    if ('\n' == buf[i]) {
+        if (i >= j) {
+            if ((i != j) || (i == 0)) {
+                if (!debug_unterm)                      /* print prefix when required */
+                    _sim_debug_write (debug_prefix, strlen (debug_prefix));
+                _sim_debug_write (&buf[j], i-j);
+                _sim_debug_write ("\r\n", 2);
+                }
+            debug_unterm = 0;
+            }
+        j = i + 1;
+        }
+    else {
+        if (buf[i] == 0) {      /* Imbedded \0 character in formatted result? */
+            fprintf (stderr, "sim_debug() formatted result: '%s'\r\n"
+                             "            has an imbedded \\0 character.\r\n"
+                             "DON'T DO THAT!\r\n", buf);
+            abort();
+            }
+        }
+    }
+if (i > j) {
+    if (!debug_unterm)                              /* print prefix when required */
+        _sim_debug_write (debug_prefix, strlen (debug_prefix));
+    _sim_debug_write (&buf[j], i-j);
+    }
+
+/* Set unterminated flag for next time */
+
+debug_unterm = len ? (((buf[len-1]=='\n')) ? 0 : 1) : debug_unterm;
+}
+
 /* Inline debugging - will print debug message if debug file is
    set and the bitmask matches the current device debug options.
    Extra returns are added for un*x systems, since the output
@@ -13178,8 +14376,15 @@ if (sim_deb && dptr && ((dptr->dctrl | (uptr ? uptr->dctrl : 0)) & dbits)) {
     char stackbuf[STACKBUFSIZE];
     int32 bufsize = sizeof(stackbuf);
     char *buf = stackbuf;
-    int32 i, j, len;
-    const char* debug_prefix = sim_debug_prefix(dbits, dptr, uptr);   /* prefix to print if required */
+    int32 len;
+    const char* debug_prefix = NULL;
+
+    if (debug_trace != NULL) {                          /* binary trace? */
+        if (_sim_debug_trace_vrec (dbits, dptr, uptr, fmt, arglist))
+            return;                                     /* recorded unformatted */
+        }
+    else
+        debug_prefix = sim_debug_prefix(dbits, dptr, uptr);   /* prefix to print if required */
 
     sim_oline = NULL;                                   /* avoid potential debug to active socket */
     buf[bufsize-1] = '\0';
@@ -13210,37 +14415,10 @@ if (sim_deb && dptr && ((dptr->dctrl | (uptr ? uptr->dctrl : 0)) & dbits)) {
 
 /* Output the formatted data expanding newlines where they exist */
 
-    for (i = j = 0; i < len; ++i) {
-        if ('\n' == buf[i]) {
-            if (i >= j) {
-                if ((i != j) || (i == 0)) {
-                    if (!debug_unterm)                  /* print prefix when required */
-                        _sim_debug_write (debug_prefix, strlen (debug_prefix));
-                    _sim_debug_write (&buf[j], i-j);
-                    _sim_debug_write ("\r\n", 2);
-                    }
-                debug_unterm = 0;
-                }
-            j = i + 1;
-            }
-        else {
-            if (buf[i] == 0) {      /* Imbedded \0 character in formatted result? */
-                fprintf (stderr, "sim_debug() formatted result: '%s'\r\n"
-                                 "            has an imbedded \\0 character.\r\n"
-                                 "DON'T DO THAT!\r\n", buf);
-                abort();
-                }
-            }
-        }
-    if (i > j) {
-        if (!debug_unterm)                          /* print prefix when required */
-            _sim_debug_write (debug_prefix, strlen (debug_prefix));
-        _sim_debug_write (&buf[j], i-j);
-        }
-
-/* Set unterminated flag for next time */
-
-    debug_unterm = len ? (((buf[len-1]=='\n')) ? 0 : 1) : debug_unterm;
+    if (debug_trace != NULL)                            /* keep the text in the trace */
+        _sim_debug_trace_text (DEBUG_TRACE_MSG, dbits, dptr, uptr, buf, len);
+    else
+        _sim_debug_emit (debug_prefix, buf, len);
     if (buf != stackbuf)
         free (buf);
     sim_oline = saved_oline;                            /* restore original socket */
@@ -13269,6 +14447,471 @@ if (sim_deb && dptr && (dptr->dctrl & dbits)) {
     }
 }
 
+/* Binary debug trace routines */
+
+#define DEBUG_TRACE_INT     0           /* argument classes */
+#define DEBUG_TRACE_LONG    1
+#define DEBUG_TRACE_LLONG   2
+#define DEBUG_TRACE_SIZE    3
+#define DEBUG_TRACE_PTRDIFF 4
+#define DEBUG_TRACE_DOUBLE  5
+#define DEBUG_TRACE_PTR     6
+#define DEBUG_TRACE_STR     7
+#define DEBUG_TRACE_SPEC    32          /* max conversion specification length */
+
+/* Scans the conversion specification at fmt (which points at a '%').
+   Returns the length of the specification and the classes of the
+   arguments it consumes (a '*' width or precision first), or 0 if the
+   trace can't represent it.  *prec is the precision a string conversion
+   applies: -1 for none or -2 when it is given by a '*' argument. */
+
+static size_t _sim_debug_trace_spec (const char *fmt, int32 *cls, int32 *ncls, int32 *prec)
+{
+const char *p = fmt + 1;
+char size = 0;
+
+*ncls = 0;
+*prec = -1;
+if (*p == '%')
+    return 2;
+while ((*p != '\0') && (strchr ("-+ #0'", *p) != NULL))
+    ++p;
+if (*p == '*') {
+    cls[(*ncls)++] = DEBUG_TRACE_INT;
+    ++p;
+    }
+else {
+    while (sim_isdigit (*p))
+        ++p;
+    if (*p == '$')                              /* positional arguments? */
+        return 0;
+    }
+if (*p == '.') {
+    ++p;
+    if (*p == '*') {
+        cls[(*ncls)++] = DEBUG_TRACE_INT;
+        *prec = -2;
+        ++p;
+        }
+    else
+        for (*prec = 0; sim_isdigit (*p); ++p)
+            *prec = (*prec * 10) + (*p - '0');
+    }
+switch (*p) {                                   /* length modifier */
+    case 'h':
+        size = 'h';
+        p += (p[1] == 'h') ? 2 : 1;
+        break;
+    case 'l':
+        size = (p[1] == 'l') ? 'q' : 'l';
+        p += (p[1] == 'l') ? 2 : 1;
+        break;
+    case 'q': case 'z': case 't':
+        size = *p++;
+        break;
+    case 'I':
+        if ((p[1] == '6') && (p[2] == '4'))
+            size = 'q';
+        else
+            if ((p[1] != '3') || (p[2] != '2'))
+                return 0;
+        p += 3;
+        break;
+    }
+switch (*p) {                                   /* conversion */
+    case 'd': case 'i': case 'o': case 'u': case 'x': case 'X':
+        cls[(*ncls)++] = (size == 'l') ? DEBUG_TRACE_LONG :
+                         (size == 'q') ? DEBUG_TRACE_LLONG :
+                         (size == 'z') ? DEBUG_TRACE_SIZE :
+                         (size == 't') ? DEBUG_TRACE_PTRDIFF : DEBUG_TRACE_INT;
+        break;
+    case 'c':
+        if (size != 0)
+            return 0;
+        cls[(*ncls)++] = DEBUG_TRACE_INT;
+        break;
+    case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+        if ((size != 0) && (size != 'l'))
+            return 0;
+        cls[(*ncls)++] = DEBUG_TRACE_DOUBLE;
+        break;
+    case 's':
+        if (size != 0)
+            return 0;
+        cls[(*ncls)++] = DEBUG_TRACE_STR;
+        break;
+    case 'p':
+        if (size != 0)
+            return 0;
+        cls[(*ncls)++] = DEBUG_TRACE_PTR;
+        break;
+    default:
+        return 0;
+    }
+++p;
+if (p - fmt >= DEBUG_TRACE_SPEC)
+    return 0;
+return (size_t)(p - fmt);
+}
+
+/* Formats a message from its argument values.  The result is placed in
+   *pbuf, which starts as stackbuf and is grown with malloc as needed.
+   Returns the message length or -1 on error. */
+
+#define DEBUG_TRACE_PRINT(val)                                                          \
+    ((nstar == 0) ? snprintf (&(*pbuf)[len], avail, spec, val) :                        \
+     (nstar == 1) ? snprintf (&(*pbuf)[len], avail, spec, star[0], val) :               \
+                    snprintf (&(*pbuf)[len], avail, spec, star[0], star[1], val))
+
+static int32 _sim_debug_trace_format (const char *fmt, const DEBUG_TRACE_ARG *args, char **pbuf, size_t *psize, const char *stackbuf)
+{
+char spec[DEBUG_TRACE_SPEC];
+int32 cls[3], ncls, nstar, prec, star[2];
+size_t len = 0, need = 0, n, avail;
+const DEBUG_TRACE_ARG *a;
+int r;
+
+while (1) {
+    if (need > *psize) {                        /* grow the buffer? */
+        size_t size = MAX (need, *psize * 2);
+        char *nbuf = (char *)((*pbuf == stackbuf) ? malloc (size) : realloc (*pbuf, size));
+
+        if (nbuf == NULL)
+            return -1;
+        if (*pbuf == stackbuf)
+            memcpy (nbuf, stackbuf, len);
+        *pbuf = nbuf;
+        *psize = size;
+        }
+    if (*fmt == '\0')
+        break;
+    if (*fmt != '%') {                          /* literal text */
+        n = strcspn (fmt, "%");
+        need = len + n + 1;
+        if (need > *psize)
+            continue;
+        memcpy (&(*pbuf)[len], fmt, n);
+        len += n;
+        fmt += n;
+        continue;
+        }
+    n = _sim_debug_trace_spec (fmt, cls, &ncls, &prec);
+    if (n == 0)
+        return -1;
+    if (ncls == 0) {                            /* %% */
+        need = len + 2;
+        if (need > *psize)
+            continue;
+        (*pbuf)[len++] = '%';
+        fmt += n;
+        continue;
+        }
+    memcpy (spec, fmt, n);
+    spec[n] = '\0';
+    nstar = ncls - 1;
+    star[0] = (nstar > 0) ? (int)args[0].i : 0;
+    star[1] = (nstar > 1) ? (int)args[1].i : 0;
+    a = &args[nstar];
+    avail = *psize - len;
+    switch (cls[nstar]) {
+        case DEBUG_TRACE_INT:
+            r = DEBUG_TRACE_PRINT ((int)a->i);
+            break;
+        case DEBUG_TRACE_LONG:
+            r = DEBUG_TRACE_PRINT ((long)a->i);
+            break;
+        case DEBUG_TRACE_LLONG:
+            r = DEBUG_TRACE_PRINT ((LL_TYPE)a->i);
+            break;
+        case DEBUG_TRACE_SIZE:
+            r = DEBUG_TRACE_PRINT ((size_t)a->i);
+            break;
+        case DEBUG_TRACE_PTRDIFF:
+            r = DEBUG_TRACE_PRINT ((ptrdiff_t)a->i);
+            break;
+        case DEBUG_TRACE_DOUBLE:
+            r = DEBUG_TRACE_PRINT (a->d);
+            break;
+        case DEBUG_TRACE_PTR:
+            r = DEBUG_TRACE_PRINT (a->p);
+            break;
+        default:
+            r = DEBUG_TRACE_PRINT (a->s);
+            break;
+        }
+    if (r < 0)
+        return -1;
+    need = len + r + 1;
+    if (need > *psize)                          /* didn't fit? */
+        continue;
+    len += r;
+    fmt += n;
+    args += ncls;
+    }
+(*pbuf)[len] = '\0';
+return (int32)len;
+}
+
+/* Claims the next trace record and fills in its header.  The caller
+   publishes the record by storing *seq in its seq field. */
+
+static DEBUG_TRACE_REC *_sim_debug_trace_claim (int32 kind, uint32 dbits, DEVICE *dptr, UNIT *uptr, const char *fmt, size_t *seq)
+{
+DEBUG_TRACE_REC *rec;
+size_t n;
+
+#if defined (SIM_ASYNCH_IO) && defined (USE_AIO_INTRINSICS)
+do
+    n = debug_trace_next;
+while (InterlockedCompareExchangePointer ((void * volatile *)&debug_trace_next, (void *)(n + 1), (void *)n) != (void *)n);
+#else
+AIO_LOCK;
+n = debug_trace_next++;
+AIO_UNLOCK;
+#endif
+rec = &debug_trace[n % debug_trace_count];
+rec->seq = 0;
+rec->time = sim_gtime ();
+_sim_debug_stamp (&rec->tod, &rec->pc);
+rec->dptr = dptr;
+rec->uptr = uptr;
+rec->fmt = fmt;
+rec->dbits = dptr ? (dbits & (dptr->dctrl | (uptr ? uptr->dctrl : 0))) : dbits;
+rec->kind = (uint16)kind;
+rec->len = 0;
+rec->main = AIO_MAIN_THREAD;
+*seq = n + 1;
+return rec;
+}
+
+/* Records debug output which is already text */
+
+static void _sim_debug_trace_text (int32 kind, uint32 dbits, DEVICE *dptr, UNIT *uptr, const char *buf, size_t len)
+{
+do {
+    size_t seq;
+    DEBUG_TRACE_REC *rec = _sim_debug_trace_claim (kind, dbits, dptr, uptr, NULL, &seq);
+    size_t chunk = MIN (len, sizeof (rec->data));
+
+    memcpy (rec->data, buf, chunk);
+    rec->len = (uint16)chunk;
+    rec->seq = seq;
+    buf += chunk;
+    len -= chunk;
+    } while (len > 0);
+}
+
+/* Records a sim_debug() message as its format and argument values.
+   Returns FALSE, without consuming any arguments, if the format can't
+   be represented. */
+
+static t_bool _sim_debug_trace_vrec (uint32 dbits, DEVICE *dptr, UNIT *uptr, const char *fmt, va_list arglist)
+{
+DEBUG_TRACE_ARG args[DEBUG_TRACE_ARGS];
+int32 cls[DEBUG_TRACE_ARGS], prec[DEBUG_TRACE_ARGS];
+size_t slen[DEBUG_TRACE_ARGS];
+int32 spec[3], nspec, sprec, nargs = 0, i, words = 0;
+DEBUG_TRACE_REC *rec;
+const char *p;
+size_t n, seq;
+
+for (p = fmt; (p = strchr (p, '%')) != NULL; p += n) {
+    n = _sim_debug_trace_spec (p, spec, &nspec, &sprec);
+    if ((n == 0) || (nargs + nspec > DEBUG_TRACE_ARGS))
+        return FALSE;
+    for (i = 0; i < nspec; i++) {
+        prec[nargs] = sprec;
+        cls[nargs++] = spec[i];
+        }
+    }
+for (i = 0; i < nargs; i++) {                   /* collect the arguments */
+    switch (cls[i]) {
+        case DEBUG_TRACE_INT:
+            args[i].i = va_arg (arglist, int);
+            break;
+        case DEBUG_TRACE_LONG:
+            args[i].i = va_arg (arglist, long);
+            break;
+        case DEBUG_TRACE_LLONG:
+            args[i].i = va_arg (arglist, LL_TYPE);
+            break;
+        case DEBUG_TRACE_SIZE:
+            args[i].i = (LL_TYPE)va_arg (arglist, size_t);
+            break;
+        case DEBUG_TRACE_PTRDIFF:
+            args[i].i = va_arg (arglist, ptrdiff_t);
+            break;
+        case DEBUG_TRACE_DOUBLE:
+            args[i].d = va_arg (arglist, double);
+            break;
+        case DEBUG_TRACE_PTR:
+            args[i].p = va_arg (arglist, void *);
+            break;
+        case DEBUG_TRACE_STR:
+            args[i].s = va_arg (arglist, const char *);
+            slen[i] = 0;
+            if (args[i].s != NULL) {                /* copy up to the precision */
+                int32 max = (prec[i] == -2) ? (int32)args[i - 1].i : prec[i];
+
+                while (((max < 0) || (slen[i] < (size_t)max)) &&
+                       (slen[i] < sizeof (rec->data)) &&
+                       (args[i].s[slen[i]] != '\0'))
+                    ++slen[i];
+                words += (int32)((slen[i] + sizeof (args[i])) / sizeof (args[i]));
+                }
+            break;
+        }
+    ++words;
+    }
+if (words > DEBUG_TRACE_WORDS) {                /* too big for a record? */
+    char stackbuf[STACKBUFSIZE];
+    char *buf = stackbuf;
+    size_t bufsize = sizeof (stackbuf);
+    int32 len = _sim_debug_trace_format (fmt, args, &buf, &bufsize, stackbuf);
+
+    if (len >= 0)
+        _sim_debug_trace_text (DEBUG_TRACE_MSG, dbits, dptr, uptr, buf, len);
+    if (buf != stackbuf)
+        free (buf);
+    return TRUE;
+    }
+rec = _sim_debug_trace_claim (DEBUG_TRACE_ARGV, dbits, dptr, uptr, fmt, &seq);
+for (i = words = 0; i < nargs; i++) {
+    if ((cls[i] != DEBUG_TRACE_STR) || (args[i].s == NULL)) {
+        rec->data[words++] = args[i];
+        if (cls[i] == DEBUG_TRACE_STR)
+            rec->data[words - 1].i = -1;        /* NULL string */
+        continue;
+        }
+    rec->data[words++].i = (LL_TYPE)slen[i];
+    memcpy (&rec->data[words], args[i].s, slen[i]);
+    ((char *)&rec->data[words])[slen[i]] = '\0';
+    words += (int32)((slen[i] + sizeof (args[i])) / sizeof (args[i]));
+    }
+rec->len = (uint16)(words * sizeof (rec->data[0]));
+rec->seq = seq;
+return TRUE;
+}
+
+/* Formats and writes out one trace record */
+
+static void _sim_debug_trace_render (const DEBUG_TRACE_REC *rec)
+{
+DEBUG_TRACE_ARG args[DEBUG_TRACE_ARGS];
+char stackbuf[STACKBUFSIZE];
+char *buf = stackbuf;
+size_t bufsize = sizeof (stackbuf);
+int32 cls[3], ncls, prec, i, j, words, len;
+const char *debug_prefix;
+const char *p;
+size_t n;
+
+if (rec->kind == DEBUG_TRACE_RAW) {
+    _sim_debug_write ((const char *)rec->data, rec->len);
+    return;
+    }
+debug_prefix = _sim_debug_prefix (_find_dbg_verb (rec->dbits, rec->dptr), rec->dptr, rec->time, &rec->tod, rec->pc, rec->main);
+if (rec->kind == DEBUG_TRACE_MSG) {
+    _sim_debug_emit (debug_prefix, (const char *)rec->data, rec->len);
+    return;
+    }
+for (p = rec->fmt, i = words = 0; (p = strchr (p, '%')) != NULL; p += n) {
+    n = _sim_debug_trace_spec (p, cls, &ncls, &prec);
+    for (j = 0; j < ncls; j++, i++) {
+        args[i] = rec->data[words++];
+        if (cls[j] != DEBUG_TRACE_STR)
+            continue;
+        if (args[i].i == -1)
+            args[i].s = NULL;
+        else {
+            len = (int32)args[i].i;
+            args[i].s = (const char *)&rec->data[words];
+            words += (int32)((len + sizeof (args[i])) / sizeof (args[i]));
+            }
+        }
+    }
+len = _sim_debug_trace_format (rec->fmt, args, &buf, &bufsize, stackbuf);
+if (len >= 0)
+    _sim_debug_emit (debug_prefix, buf, len);
+if (buf != stackbuf)
+    free (buf);
+}
+
+/* Writes out the retained trace records, oldest first */
+
+static void _sim_debug_trace_walk (void)
+{
+size_t next = debug_trace_next;
+size_t n = (next > debug_trace_count) ? next - debug_trace_count : 0;
+
+for (; n < next; n++) {
+    const DEBUG_TRACE_REC *rec = &debug_trace[n % debug_trace_count];
+
+    if (rec->seq == n + 1)                      /* completely written? */
+        _sim_debug_trace_render (rec);
+    }
+}
+
+/* Allocates a trace buffer of size bytes and starts recording into it */
+
+t_stat sim_debug_trace_open (size_t size)
+{
+sim_debug_trace_close ();
+debug_trace_count = size / sizeof (*debug_trace);
+if (debug_trace_count == 0)
+    return SCPE_ARG;
+debug_trace = (DEBUG_TRACE_REC *)calloc (debug_trace_count, sizeof (*debug_trace));
+if (debug_trace == NULL) {
+    debug_trace_count = 0;
+    return SCPE_MEM;
+    }
+debug_trace_next = 0;
+return SCPE_OK;
+}
+
+/* Writes the trace contents to the debug output and frees the trace */
+
+void sim_debug_trace_close (void)
+{
+if (debug_trace == NULL)
+    return;
+if (sim_deb != NULL) {
+    const char *bufmsg = "Trace Buffer Contents follow here:\n\n";
+
+    fwrite (bufmsg, 1, strlen (bufmsg), sim_deb);
+    debug_trace_rendering = TRUE;
+    _sim_debug_trace_walk ();
+    _sim_debug_write_flush ("", 0, TRUE);
+    debug_trace_rendering = FALSE;
+    }
+free (debug_trace);
+debug_trace = NULL;
+debug_trace_count = debug_trace_next = 0;
+}
+
+/* SHOW DEBUG TRACE - displays the trace contents */
+
+t_stat sim_debug_trace_show (FILE *st)
+{
+int32 saved_unterm = debug_unterm;
+
+if (debug_trace == NULL) {
+    fprintf (st, "Debug output is not being recorded in a trace buffer\n");
+    return SCPE_OK;
+    }
+debug_trace_st = st;
+debug_trace_rendering = TRUE;
+debug_unterm = 0;
+_sim_debug_trace_walk ();
+_sim_debug_write_flush ("", 0, TRUE);
+if (debug_unterm)
+    fprintf (st, "\n");
+debug_unterm = saved_unterm;
+debug_trace_rendering = FALSE;
+debug_trace_st = NULL;
+return SCPE_OK;
+}
+
 void sim_data_trace(DEVICE *dptr, UNIT *uptr, const uint8 *data, const char *position, size_t len, const char *txt, uint32 reason)
 {
 
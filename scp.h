@@ -283,6 +283,7 @@ DEVICE *find_dev (const char *ptr);
 DEVICE *find_unit (const char *ptr, UNIT **uptr);
 DEVICE *find_dev_from_unit (UNIT *uptr);
 t_stat sim_register_internal_device (DEVICE *dptr);
+t_stat sim_register_memory (UNIT *uptr, void *base, size_t size);
 void sim_sub_args (char *in_str, size_t in_str_size, char *do_arg[]);
 REG *find_reg (CONST char *ptr, CONST char **optr, DEVICE *dptr);
 CTAB *find_ctab (CTAB *tab, const char *gbuf);
@@ -326,6 +327,9 @@ void sim_debug_bits_hdr (uint32 dbits, DEVICE* dptr, const char *header,
     BITFIELD* bitdefs, uint32 before, uint32 after, int terminate);
 void sim_debug_bits (uint32 dbits, DEVICE* dptr, BITFIELD* bitdefs,
     uint32 before, uint32 after, int terminate);
+t_stat sim_debug_trace_open (size_t size);
+void sim_debug_trace_close (void);
+t_stat sim_debug_trace_show (FILE *st);
 #if defined (__DECC) && defined (__VMS) && (defined (__VAX) || (__DECC_VER < 60590001))
 #define CANT_USE_MACRO_VA_ARGS 1
 #endif
@@ -391,6 +395,20 @@ extern uint32 sim_brk_summ;
 extern uint32 sim_brk_match_type;
 extern t_addr sim_brk_match_addr;
 extern BRKTYPTAB *sim_brk_type_desc;                    /* type descriptions */
+extern uint32 sim_brk_map[];                            /* breakpoint types by page */
+
+/* Breakpoint page map.  Each entry holds the types of the breakpoints set
+   on the pages of addresses which hash to it, so that a CPU loop can rule
+   out a breakpoint at most addresses with one table lookup.  SIM_BRK_TEST
+   is the inline equivalent of sim_brk_test for use in instruction loops;
+   it costs nothing beyond the sim_brk_summ test when no breakpoints are set. */
+
+#define SIM_BRK_PAGE_BITS       9                       /* log2 page size */
+#define SIM_BRK_MAP_SIZE        1024                    /* map entries (power of 2) */
+#define SIM_BRK_MAP_IDX(loc)    ((uint32)((loc) >> SIM_BRK_PAGE_BITS) & (SIM_BRK_MAP_SIZE - 1))
+#define SIM_BRK_TEST(loc,btyp)  ((sim_brk_summ && \
+                                  (sim_brk_map[SIM_BRK_MAP_IDX (loc)] & ((btyp) | BRK_TYP_DYN_ALL))) ? \
+                                 sim_brk_test ((loc), (btyp)) : 0)
 extern const char *sim_prog_name;                       /* executable program name */
 extern FILE *stdnul;
 extern t_bool sim_asynch_enabled;
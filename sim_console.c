@@ -2261,7 +2261,7 @@ sim_deb_switches = switches &
                     SWMASK ('T') | SWMASK ('A') | 
                     SWMASK ('F') | SWMASK ('N') |
                     SWMASK ('B') | SWMASK ('E') |
-                    SWMASK ('D') );                 /* save debug switches */
+                    SWMASK ('D') | SWMASK ('Z') );  /* save debug switches */
 return old_deb_switches;
 }
 
@@ -2276,7 +2276,9 @@ size_t buffer_size;
 
 if ((cptr == NULL) || (*cptr == 0))                     /* need arg */
     return SCPE_2FARG;
-if (sim_switches & SWMASK ('B')) {
+if ((sim_switches & SWMASK ('B')) && (sim_switches & SWMASK ('Z')))
+    return sim_messagef (SCPE_ARG, "The -B and -Z switches can't be combined\n");
+if (sim_switches & (SWMASK ('B') | SWMASK ('Z'))) {
     cptr = get_glyph_nc (cptr, gbuf, 0);                /* buffer size */
     buffer_size = (size_t)strtoul (gbuf, NULL, 10);
     if ((buffer_size == 0) || (buffer_size > 1024))
@@ -2319,6 +2321,9 @@ if (sim_deb_switches & SWMASK ('E'))
 if (sim_deb_switches & SWMASK ('B'))
     sim_messagef (SCPE_OK, "   Debug messages will be written to a %u MB circular memory buffer\n", 
                                 (unsigned int)buffer_size);
+if (sim_deb_switches & SWMASK ('Z'))
+    sim_messagef (SCPE_OK, "   Debug messages will be recorded in a %u MB binary trace buffer\n", 
+                                (unsigned int)buffer_size);
 time(&now);
 if (!sim_quiet) {
     fprintf (sim_deb, "Debug output to \"%s\" at %s", sim_logfile_name (sim_deb, sim_deb_ref), ctime(&now));
@@ -2333,6 +2338,13 @@ if (sim_deb_switches & SWMASK ('B')) {
     sim_debug_buffer_offset = sim_debug_buffer_inuse = 0;
     memset (sim_deb_buffer, 0, sim_deb_buffer_size);
     }
+if (sim_deb_switches & SWMASK ('Z')) {
+    r = sim_debug_trace_open ((size_t)(1024 * 1024 * buffer_size));
+    if (r != SCPE_OK) {
+        sim_set_deboff (0, NULL);
+        return r;
+        }
+    }
 
 return SCPE_OK;
 }
@@ -2345,6 +2357,8 @@ if (cptr && (*cptr != 0))                               /* now eol? */
     return SCPE_2MARG;
 if (sim_deb == NULL)                                    /* no debug? */
     return SCPE_OK;
+if (sim_deb_switches & SWMASK ('Z'))                    /* write out trace */
+    sim_debug_trace_close ();
 if (sim_deb_switches & SWMASK ('B')) {
     size_t offset = (sim_debug_buffer_inuse == sim_deb_buffer_size) ? sim_debug_buffer_offset : 0;
     const char *bufmsg = "Circular Buffer Contents follow here:\n\n";
@@ -2375,9 +2389,16 @@ return sim_messagef (SCPE_OK, "Debug output disabled\n");
 t_stat sim_show_debug (FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, CONST char *cptr)
 {
 int32 i;
+char gbuf[CBUFSIZE];
 
-if (cptr && (*cptr != 0))
-    return SCPE_2MARG;
+if (cptr && (*cptr != 0)) {
+    cptr = get_glyph (cptr, gbuf, 0);
+    if (*cptr != 0)
+        return SCPE_2MARG;
+    if (MATCH_CMD (gbuf, "TRACE") != 0)
+        return SCPE_ARG;
+    return sim_debug_trace_show (st);
+    }
 if (sim_deb) {
     fprintf (st, "Debug output enabled to \"%s\"\n", 
                  sim_logfile_name (sim_deb, sim_deb_ref));
@@ -2391,6 +2412,8 @@ if (sim_deb) {
         fprintf (st, "   Debug messages are not being filtered to summarize duplicate lines\n");
     if (sim_deb_switches & SWMASK ('E'))
         fprintf (st, "   Debug messages containing blob data in EBCDIC will display in readable form\n");
+    if (sim_deb_switches & SWMASK ('Z'))
+        fprintf (st, "   Debug messages are recorded in a binary trace buffer (see SHOW DEBUG TRACE)\n");
     for (i = 0; (dptr = sim_devices[i]) != NULL; i++) {
         t_bool unit_debug = FALSE;
         uint32 unit;
@@ -601,6 +601,9 @@ struct UNIT {
     char                *uname;                         /* Unit name */
     DEVICE              *dptr;                          /* DEVICE linkage (backpointer) */
     uint32              dctrl;                          /* debug control */
+    double              q_due_time;                     /* absolute event due time */
+    t_uint64            q_seq;                          /* event insertion sequence */
+    int32               q_index;                        /* event heap slot + 1 (0 if not queued) */
 #ifdef SIM_ASYNCH_IO
     void                (*a_check_completion)(UNIT *);
     t_bool              (*a_is_active)(UNIT *);
@@ -665,6 +668,9 @@ struct UNIT {
 #define UNIT_V_TAPE_ANSI    16              /* Bit offset for ANSI Tape Type */
 #define UNIT_S_TAPE_ANSI    4               /* Bits Reserved for ANSI Tape Type */
 #define UNIT_M_TAPE_ANSI    (((1 << UNIT_S_TAPE_ANSI) - 1) << UNIT_V_TAPE_ANSI)
+#define UNIT_V_DF_DISK_RA   20              /* Bit offset for Disk Read-Ahead window */
+#define UNIT_S_DF_DISK_RA   12              /* Bits Reserved for Disk Read-Ahead window */
+#define UNIT_M_DF_DISK_RA   (((1u << UNIT_S_DF_DISK_RA) - 1) << UNIT_V_DF_DISK_RA)
 
 struct BITFIELD {
     const char      *name;                              /* field name */
@@ -839,6 +845,7 @@ struct EXPECT {
     uint32              buf_ins;                        /* buffer insertion point for the next output data */
     uint32              buf_size;                       /* buffer size */
     uint32              buf_data;                       /* count of data in buffer */
+    struct sim_exp_matcher *matcher;                    /* compiled match rules - private */
     };
 
 /* Send Context */
@@ -50,6 +50,9 @@ Public routines:
    sim_disk_show_capac       show disk capacity
    sim_disk_set_async        enable asynchronous operation
    sim_disk_clr_async        disable asynchronous operation
+   sim_disk_set_async_depth  set asynchronous request queue depth
+   sim_disk_set_readahead    set sequential read-ahead window
+   sim_disk_show_readahead   show sequential read-ahead window
    sim_disk_data_trace       debug support
    sim_disk_test             unit test routine
 
@@ -85,6 +88,11 @@ Internal routines:
 #include <pthread.h>
 #endif
 
+#if defined (__linux) || defined (__linux__) || defined (__APPLE__)|| defined (__sun) || defined (__sun__) || defined (__hpux) || defined (_AIX)
+#include <unistd.h>
+#define DISK_HAVE_PREAD 1               /* SIMH format I/O with pread/pwrite */
+#endif
+
 struct disk_context {
     DEVICE              *dptr;              /* Device for unit (access to debug flags) */
     uint32              dbit;               /* debugging bit */
@@ -96,58 +104,89 @@ struct disk_context {
     uint32              is_cdrom;           /* Host system CDROM Device */
     uint32              media_removed;      /* Media not available flag */
     uint32              auto_format;        /* Format determined dynamically */
+    uint8               *bounce_buf;        /* reusable transfer buffer */
+    size_t              bounce_size;        /* size of bounce_buf */
+    uint8               *ra_buf;            /* read-ahead buffer */
+    t_seccnt            ra_size;            /* sectors allocated in ra_buf */
+    t_lba               ra_lba;             /* first sector in ra_buf */
+    t_seccnt            ra_count;           /* sectors in ra_buf (0 = empty) */
+    t_seccnt            ra_valid;           /* of which were present in the file */
+    t_lba               ra_next;            /* sector following the last read */
 #if defined _WIN32
     HANDLE              disk_handle;        /* OS specific Raw device handle */
 #endif
 #if defined SIM_ASYNCH_IO
     int                 asynch_io;          /* Asynchronous Interrupt scheduling enabled */
     int                 asynch_io_latency;  /* instructions to delay pending interrupt */
-    pthread_mutex_t     lock;
-    pthread_t           io_thread;          /* I/O Thread Id */
-    pthread_mutex_t     io_lock;
-    pthread_cond_t      io_cond;
-    pthread_cond_t      io_done;
-    pthread_cond_t      startup_cond;
-    int                 io_dop;
+    int                 async_depth;        /* requests which may be queued */
+    struct disk_aio_req *io_queue;          /* request queue (async_depth entries) */
+    int                 io_depth;           /* size of io_queue */
+    int                 io_head;            /* oldest request */
+    int                 io_count;           /* requests queued */
+    int                 io_done;            /* of which completed */
+    t_bool              io_busy;            /* request in progress */
+    t_bool              io_ready;           /* on the ready list */
+    UNIT                *io_next;           /* next unit on the ready list */
+#endif
+    };
+
+#if defined SIM_ASYNCH_IO
+struct disk_aio_req {
+    int                 dop;                /* operation (DOP_DONE when complete) */
     uint8               *buf;
     t_seccnt            *rsects;
     t_seccnt            sects;
     t_lba               lba;
     DISK_PCALLBACK      callback;
     t_stat              io_status;
-#endif
     };
+#endif
 
 #define disk_ctx up8                        /* Field in Unit structure which points to the disk_context */
 
 #if defined SIM_ASYNCH_IO
+/* Asynchronous I/O
+
+   All asynchronous disk units share one pool of I/O threads.  Each unit
+   has a queue of up to async_depth outstanding requests (1 unless set
+   deeper with SET <unit> ASYNCH=depth).  Requests
+   for one unit are performed one at a time and in order, since stdio and
+   the VHD layer don't have an atomic seek+(read|write) operation, but
+   requests to different units proceed in parallel on different threads.
+   As each request completes the unit is activated, and the completion
+   callbacks are made in order from the main simulator thread. */
+
+#define DISK_AIO_MAX_THREADS    8               /* I/O threads in pool */
+#define DISK_AIO_MAX_DEPTH      64              /* requests queued per unit */
+
+static struct {
+    pthread_mutex_t     lock;                   /* protects all queues */
+    pthread_cond_t      work;                   /* a unit has work */
+    pthread_cond_t      done;                   /* a request completed */
+    pthread_t           threads[DISK_AIO_MAX_THREADS];
+    int                 thread_count;
+    int                 unit_count;             /* units using the pool */
+    t_bool              shutdown;
+    UNIT                *ready_head;            /* units with requests to start */
+    UNIT                *ready_tail;
+    } disk_aio;
+static pthread_once_t disk_aio_once = PTHREAD_ONCE_INIT;
+
+static void _disk_aio_init (void)
+{
+pthread_mutex_init (&disk_aio.lock, NULL);
+pthread_cond_init (&disk_aio.work, NULL);
+pthread_cond_init (&disk_aio.done, NULL);
+}
+
 #define AIO_CALLSETUP                                               \
 struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;   \
                                                                     \
 if ((!callback) || !ctx->asynch_io)
 
 #define AIO_CALL(op, _lba, _buf, _rsects, _sects,  _callback)   \
-    if (ctx->asynch_io) {                                       \
-        struct disk_context *ctx =                              \
-                      (struct disk_context *)uptr->disk_ctx;    \
-                                                                \
-        pthread_mutex_lock (&ctx->io_lock);                     \
-                                                                \
-        sim_debug_unit (ctx->dbit, uptr,                        \
-      "sim_disk AIO_CALL(op=%d, unit=%d, lba=0x%X, sects=%d)\n",\
-                op, (int)(uptr-ctx->dptr->units), _lba, _sects);\
-                                                                \
-        if (ctx->callback)                                      \
-            abort(); /* horrible mistake, stop */               \
-        ctx->io_dop = op;                                       \
-        ctx->lba = _lba;                                        \
-        ctx->buf = _buf;                                        \
-        ctx->sects = _sects;                                    \
-        ctx->rsects = _rsects;                                  \
-        ctx->callback = _callback;                              \
-        pthread_cond_signal (&ctx->io_cond);                    \
-        pthread_mutex_unlock (&ctx->io_lock);                   \
-        }                                                       \
+    if (ctx->asynch_io)                                         \
+        _disk_aio_queue (uptr, op, _lba, _buf, _rsects, _sects, _callback);\
     else                                                        \
         if (_callback)                                          \
             (_callback) (uptr, r);
@@ -158,46 +197,92 @@ if ((!callback) || !ctx->asynch_io)
 #define DOP_WSEC  2             /* sim_disk_wrsect_a */
 #define DOP_IAVL  3             /* sim_disk_isavailable_a */
 
+/* Add a unit to the list of units with requests ready to start (pool locked) */
+
+static void _disk_aio_ready (UNIT *uptr)
+{
+struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
+
+ctx->io_next = NULL;
+if (disk_aio.ready_tail)
+    ((struct disk_context *)disk_aio.ready_tail->disk_ctx)->io_next = uptr;
+else
+    disk_aio.ready_head = uptr;
+disk_aio.ready_tail = uptr;
+ctx->io_ready = TRUE;
+pthread_cond_signal (&disk_aio.work);
+}
+
+static void _disk_aio_queue (UNIT *uptr, int op, t_lba lba, uint8 *buf, t_seccnt *rsects, t_seccnt sects, DISK_PCALLBACK callback)
+{
+struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
+struct disk_aio_req *req;
+
+pthread_mutex_lock (&disk_aio.lock);
+sim_debug_unit (ctx->dbit, uptr, "sim_disk AIO_CALL(op=%d, unit=%d, lba=0x%X, sects=%d, queued=%d)\n",
+                op, (int)(uptr-ctx->dptr->units), lba, sects, ctx->io_count);
+if (ctx->io_count >= ctx->io_depth)
+    abort(); /* horrible mistake, stop */
+req = &ctx->io_queue[(ctx->io_head + ctx->io_count) % ctx->io_depth];
+req->dop = op;
+req->lba = lba;
+req->buf = buf;
+req->sects = sects;
+req->rsects = rsects;
+req->callback = callback;
+req->io_status = SCPE_OK;
+++ctx->io_count;
+if (!ctx->io_busy && !ctx->io_ready)
+    _disk_aio_ready (uptr);
+pthread_mutex_unlock (&disk_aio.lock);
+}
+
 static void *
 _disk_io(void *arg)
 {
-UNIT* volatile uptr = (UNIT*)arg;
-struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
+UNIT *uptr;
+struct disk_context *ctx;
+struct disk_aio_req *req;
 
 /* Boost Priority for this I/O thread vs the CPU instruction execution
    thread which in general won't be readily yielding the processor when
    this thread needs to run */
 sim_os_set_thread_priority (PRIORITY_ABOVE_NORMAL);
 
-sim_debug_unit (ctx->dbit, uptr, "_disk_io(unit=%d) starting\n", (int)(uptr-ctx->dptr->units));
-
-pthread_mutex_lock (&ctx->io_lock);
-pthread_cond_signal (&ctx->startup_cond);   /* Signal we're ready to go */
-while (ctx->asynch_io) {
-    pthread_cond_wait (&ctx->io_cond, &ctx->io_lock);
-    if (ctx->io_dop == DOP_DONE)
-        break;
-    pthread_mutex_unlock (&ctx->io_lock);
-    switch (ctx->io_dop) {
+pthread_mutex_lock (&disk_aio.lock);
+while (!disk_aio.shutdown) {
+    if ((uptr = disk_aio.ready_head) == NULL) {
+        pthread_cond_wait (&disk_aio.work, &disk_aio.lock);
+        continue;
+        }
+    ctx = (struct disk_context *)uptr->disk_ctx;
+    if ((disk_aio.ready_head = ctx->io_next) == NULL)
+        disk_aio.ready_tail = NULL;
+    ctx->io_ready = FALSE;
+    ctx->io_busy = TRUE;
+    req = &ctx->io_queue[(ctx->io_head + ctx->io_done) % ctx->io_depth];
+    pthread_mutex_unlock (&disk_aio.lock);
+    switch (req->dop) {
         case DOP_RSEC:
-            ctx->io_status = sim_disk_rdsect (uptr, ctx->lba, ctx->buf, ctx->rsects, ctx->sects);
+            req->io_status = sim_disk_rdsect (uptr, req->lba, req->buf, req->rsects, req->sects);
             break;
         case DOP_WSEC:
-            ctx->io_status = sim_disk_wrsect (uptr, ctx->lba, ctx->buf, ctx->rsects, ctx->sects);
+            req->io_status = sim_disk_wrsect (uptr, req->lba, req->buf, req->rsects, req->sects);
             break;
         case DOP_IAVL:
-            ctx->io_status = sim_disk_isavailable (uptr);
+            req->io_status = sim_disk_isavailable (uptr);
             break;
         }
-    pthread_mutex_lock (&ctx->io_lock);
-    ctx->io_dop = DOP_DONE;
-    pthread_cond_signal (&ctx->io_done);
+    pthread_mutex_lock (&disk_aio.lock);
+    req->dop = DOP_DONE;
+    ++ctx->io_done;
+    ctx->io_busy = FALSE;
+    if (ctx->io_done < ctx->io_count)                   /* more for this unit? */
+        _disk_aio_ready (uptr);
+    pthread_cond_broadcast (&disk_aio.done);
     sim_activate (uptr, ctx->asynch_io_latency);
     }
-pthread_mutex_unlock (&ctx->io_lock);
-
-sim_debug_unit (ctx->dbit, uptr, "_disk_io(unit=%d) exiting\n", (int)(uptr-ctx->dptr->units));
-
+pthread_mutex_unlock (&disk_aio.lock);
 return NULL;
 }
 
@@ -207,25 +292,34 @@ return NULL;
    routine is to put the unit in proper condition to digest what may have
    occurred in the asynchrconous thread.
   
-   Since disk processing only handles a single I/O at a time to a
-   particular disk device (due to using stdio for the SimH Disk format
-   and stdio doesn't have an atomic seek+(read|write) operation),
-   we have the opportunity to possibly detect improper attempts to
-   issue multiple concurrent I/O requests. */
+   Completed requests are always at the head of the unit's queue, so their
+   callbacks are made here in the order the requests were issued. */
 static void _disk_completion_dispatch (UNIT *uptr)
 {
 struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
-DISK_PCALLBACK callback = ctx->callback;
-
-sim_debug_unit (ctx->dbit, uptr, "_disk_completion_dispatch(unit=%d, dop=%d, callback=%p)\n", (int)(uptr-ctx->dptr->units), ctx->io_dop, (void *)(ctx->callback));
-
-if (ctx->io_dop != DOP_DONE)
-    abort();                                            /* horribly wrong, stop */
+struct disk_aio_req *req;
+DISK_PCALLBACK callback;
+t_stat status;
 
-if (ctx->callback && ctx->io_dop == DOP_DONE) {
-    ctx->callback = NULL;
-    callback (uptr, ctx->io_status);
+if (!ctx)                                               /* detached meanwhile? */
+    return;
+pthread_mutex_lock (&disk_aio.lock);
+sim_debug_unit (ctx->dbit, uptr, "_disk_completion_dispatch(unit=%d, done=%d, queued=%d)\n", (int)(uptr-ctx->dptr->units), ctx->io_done, ctx->io_count);
+while (ctx->io_done > 0) {
+    req = &ctx->io_queue[ctx->io_head];
+    if (req->dop != DOP_DONE)
+        abort();                                        /* horribly wrong, stop */
+    callback = req->callback;
+    status = req->io_status;
+    ctx->io_head = (ctx->io_head + 1) % ctx->io_depth;
+    --ctx->io_count;
+    --ctx->io_done;
+    pthread_mutex_unlock (&disk_aio.lock);
+    if (callback)
+        callback (uptr, status);
+    pthread_mutex_lock (&disk_aio.lock);
     }
+pthread_mutex_unlock (&disk_aio.lock);
 }
 
 static t_bool _disk_is_active (UNIT *uptr)
@@ -233,24 +327,32 @@ static t_bool _disk_is_active (UNIT *uptr)
 struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
 
 if (ctx) {
-    sim_debug_unit (ctx->dbit, uptr, "_disk_is_active(unit=%d, dop=%d)\n", (int)(uptr-ctx->dptr->units), ctx->io_dop);
-    return (ctx->io_dop != DOP_DONE);
+    sim_debug_unit (ctx->dbit, uptr, "_disk_is_active(unit=%d, queued=%d)\n", (int)(uptr-ctx->dptr->units), ctx->io_count);
+    return (ctx->io_count > ctx->io_done);
     }
 return FALSE;
 }
 
+/* Wait for every started or queued request on a unit to complete */
+
+static void _disk_aio_drain (UNIT *uptr)
+{
+struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
+
+pthread_mutex_lock (&disk_aio.lock);
+while (ctx->io_count > ctx->io_done)
+    pthread_cond_wait (&disk_aio.done, &disk_aio.lock);
+pthread_mutex_unlock (&disk_aio.lock);
+}
+
 static t_bool _disk_cancel (UNIT *uptr)
 {
 struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
 
 if (ctx) {
-    sim_debug_unit (ctx->dbit, uptr, "_disk_cancel(unit=%d, dop=%d)\n", (int)(uptr-ctx->dptr->units), ctx->io_dop);
-    if (ctx->asynch_io) {
-        pthread_mutex_lock (&ctx->io_lock);
-        while (ctx->io_dop != DOP_DONE)
-            pthread_cond_wait (&ctx->io_done, &ctx->io_lock);
-        pthread_mutex_unlock (&ctx->io_lock);
-        }
+    sim_debug_unit (ctx->dbit, uptr, "_disk_cancel(unit=%d, queued=%d)\n", (int)(uptr-ctx->dptr->units), ctx->io_count);
+    if (ctx->asynch_io)
+        _disk_aio_drain (uptr);
     }
 return FALSE;
 }
@@ -261,8 +363,23 @@ return FALSE;
         (_callback) (uptr, r);
 #endif
 
+/* Take or release the I/O pool lock around a fork, so that the child
+   doesn't inherit it from an I/O thread in the middle of a queue update */
+
+void sim_disk_aio_lock (t_bool lock)
+{
+#if defined(SIM_ASYNCH_IO)
+pthread_once (&disk_aio_once, _disk_aio_init);
+if (lock)
+    pthread_mutex_lock (&disk_aio.lock);
+else
+    pthread_mutex_unlock (&disk_aio.lock);
+#endif
+}
+
 /* Forward declarations */
 
+t_stat sim_disk_clr_async (UNIT *uptr);
 static t_stat sim_vhd_disk_implemented (void);
 static FILE *sim_vhd_disk_open (const char *rawdevicename, const char *openmode);
 static FILE *sim_vhd_disk_create (const char *szVHDPath, t_offset desiredsize);
@@ -383,6 +500,46 @@ else fprintf (st, "undefined capacity");
 return SCPE_OK;
 }
 
+/* Set disk read-ahead window
+
+   READAHEAD=n reads n sectors ahead whenever a SIMH format or raw disk
+   read continues where the previous one ended, so sequential scans
+   are satisfied from memory rather than with a host read per sector.
+   READAHEAD=0 disables it. */
+
+t_stat sim_disk_set_readahead (UNIT *uptr, int32 val, CONST char *cptr, void *desc)
+{
+struct disk_context *ctx;
+uint32 window;
+t_stat r;
+
+if (uptr == NULL)
+    return SCPE_IERR;
+if ((cptr == NULL) || (*cptr == 0))
+    return SCPE_ARG;
+window = (uint32) get_uint (cptr, 10, UNIT_M_DF_DISK_RA >> UNIT_V_DF_DISK_RA, &r);
+if (r != SCPE_OK)
+    return sim_messagef (SCPE_ARG, "Invalid read-ahead window: %s\n", cptr);
+uptr->dynflags = (uptr->dynflags & ~UNIT_M_DF_DISK_RA) | (window << UNIT_V_DF_DISK_RA);
+ctx = (struct disk_context *)uptr->disk_ctx;
+if (ctx)
+    ctx->ra_count = 0;                                  /* discard current window */
+return SCPE_OK;
+}
+
+/* Show disk read-ahead window */
+
+t_stat sim_disk_show_readahead (FILE *st, UNIT *uptr, int32 val, CONST void *desc)
+{
+uint32 window = DK_GET_RA (uptr);
+
+if (window)
+    fprintf (st, "readahead=%d sectors", (int)window);
+else
+    fprintf (st, "no readahead");
+return SCPE_OK;
+}
+
 /* Test for available */
 
 t_bool sim_disk_isavailable (UNIT *uptr)
@@ -489,21 +646,32 @@ pthread_attr_t attr;
 
 sim_debug_unit (ctx->dbit, uptr, "sim_disk_set_async(unit=%d)\n", (int)(uptr-ctx->dptr->units));
 
+if (ctx->asynch_io)                                     /* already enabled? */
+    sim_disk_clr_async (uptr);                          /* wait for requests */
+_disk_completion_dispatch (uptr);                       /* and report them */
 ctx->asynch_io = sim_asynch_enabled;
 ctx->asynch_io_latency = latency;
 if (ctx->asynch_io) {
-    pthread_mutex_init (&ctx->io_lock, NULL);
-    pthread_cond_init (&ctx->io_cond, NULL);
-    pthread_cond_init (&ctx->io_done, NULL);
-    pthread_cond_init (&ctx->startup_cond, NULL);
-    pthread_attr_init(&attr);
-    pthread_attr_setscope(&attr, PTHREAD_SCOPE_SYSTEM);
-    pthread_mutex_lock (&ctx->io_lock);
-    pthread_create (&ctx->io_thread, &attr, _disk_io, (void *)uptr);
-    pthread_attr_destroy(&attr);
-    pthread_cond_wait (&ctx->startup_cond, &ctx->io_lock); /* Wait for thread to stabilize */
-    pthread_mutex_unlock (&ctx->io_lock);
-    pthread_cond_destroy (&ctx->startup_cond);
+    pthread_once (&disk_aio_once, _disk_aio_init);
+    if (ctx->io_count == 0) {                           /* (re)size idle queue */
+        free (ctx->io_queue);
+        ctx->io_depth = (ctx->async_depth > 0) ? ctx->async_depth : 1;
+        ctx->io_queue = (struct disk_aio_req *)calloc (ctx->io_depth, sizeof (*ctx->io_queue));
+        ctx->io_head = ctx->io_done = 0;
+        }
+    ctx->io_busy = ctx->io_ready = FALSE;
+    pthread_mutex_lock (&disk_aio.lock);
+    ++disk_aio.unit_count;
+    disk_aio.shutdown = FALSE;
+    if ((disk_aio.thread_count < disk_aio.unit_count) &&/* one thread per unit, */
+        (disk_aio.thread_count < DISK_AIO_MAX_THREADS)) {/* up to a limit */
+        pthread_attr_init(&attr);
+        pthread_attr_setscope(&attr, PTHREAD_SCOPE_SYSTEM);
+        if (0 == pthread_create (&disk_aio.threads[disk_aio.thread_count], &attr, _disk_io, NULL))
+            ++disk_aio.thread_count;
+        pthread_attr_destroy(&attr);
+        }
+    pthread_mutex_unlock (&disk_aio.lock);
     }
 uptr->a_check_completion = _disk_completion_dispatch;
 uptr->a_is_active = _disk_is_active;
@@ -527,27 +695,93 @@ if (!ctx) return SCPE_UNATT;
 sim_debug_unit (ctx->dbit, uptr, "sim_disk_clr_async(unit=%d)\n", (int)(uptr-ctx->dptr->units));
 
 if (ctx->asynch_io) {
-    pthread_mutex_lock (&ctx->io_lock);
+    _disk_aio_drain (uptr);                             /* finish outstanding I/O */
+    pthread_mutex_lock (&disk_aio.lock);
     ctx->asynch_io = 0;
-    pthread_cond_signal (&ctx->io_cond);
-    pthread_mutex_unlock (&ctx->io_lock);
-    pthread_join (ctx->io_thread, NULL);
-    pthread_mutex_destroy (&ctx->io_lock);
-    pthread_cond_destroy (&ctx->io_cond);
-    pthread_cond_destroy (&ctx->io_done);
+    if (--disk_aio.unit_count == 0) {                   /* last unit? */
+        int i, count = disk_aio.thread_count;
+
+        disk_aio.shutdown = TRUE;                       /* stop the pool */
+        pthread_cond_broadcast (&disk_aio.work);
+        pthread_mutex_unlock (&disk_aio.lock);
+        for (i = 0; i < count; i++)
+            pthread_join (disk_aio.threads[i], NULL);
+        pthread_mutex_lock (&disk_aio.lock);
+        disk_aio.thread_count = 0;
+        }
+    pthread_mutex_unlock (&disk_aio.lock);
     }
 return SCPE_OK;
 #endif
 }
 
+/* Enable asynchronous operation with up to depth requests outstanding on
+   a unit (SET <unit> ASYNCH=depth).  The unit still only runs
+   asynchronously while SET ASYNCH is in effect. */
+
+t_stat sim_disk_set_async_depth (UNIT *uptr, int depth)
+{
+#if !defined(SIM_ASYNCH_IO)
+return sim_messagef (SCPE_NOFNC, "Disk: can't operate asynchronously\n");
+#else
+struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
+t_stat r;
+
+if (!ctx) return SCPE_UNATT;
+if ((depth < 1) || (depth > DISK_AIO_MAX_DEPTH))
+    return SCPE_ARG;
+ctx->async_depth = depth;
+r = sim_disk_set_async (uptr, ctx->asynch_io_latency);  /* (re)size queue */
+if ((r == SCPE_OK) && ctx->asynch_io && (ctx->io_depth != depth))
+    return sim_messagef (SCPE_IERR, "%s: queue depth still %d, requests outstanding\n", sim_uname (uptr), ctx->io_depth);
+return r;
+#endif
+}
+
+/* Return the unit's transfer buffer, enlarged to at least size bytes.
+   Requests for a unit are performed one at a time, so a single buffer
+   per unit replaces allocating one for each unaligned transfer. */
+
+static uint8 *_sim_disk_bounce_buf (struct disk_context *ctx, size_t size)
+{
+if (size > ctx->bounce_size) {
+    uint8 *nbuf = (uint8 *)realloc (ctx->bounce_buf, size);
+
+    if (nbuf == NULL)
+        return NULL;
+    ctx->bounce_buf = nbuf;
+    ctx->bounce_size = size;
+    }
+return ctx->bounce_buf;
+}
+
+static void _sim_disk_free_bufs (struct disk_context *ctx)
+{
+free (ctx->bounce_buf);
+ctx->bounce_buf = NULL;
+ctx->bounce_size = 0;
+free (ctx->ra_buf);
+ctx->ra_buf = NULL;
+ctx->ra_size = ctx->ra_count = 0;
+}
+
 /* Read Sectors */
 
+/* Read sectors from a SIMH format file.  The data is returned in file
+   byte order.  Where available pread is used, so a transfer is a single
+   system call without a seek or a copy through the stdio buffer. */
+
 static t_stat _sim_disk_rdsect (UNIT *uptr, t_lba lba, uint8 *buf, t_seccnt *sectsread, t_seccnt sects)
 {
 t_offset da;
-uint32 err, tbc;
+uint32 tbc;
 size_t i;
 struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
+#if defined (DISK_HAVE_PREAD)
+ssize_t bytesread;
+#else
+uint32 err;
+#endif
 
 sim_debug_unit (ctx->dbit, uptr, "_sim_disk_rdsect(unit=%d, lba=0x%X, sects=%d)\n", (int)(uptr-ctx->dptr->units), lba, sects);
 
@@ -555,16 +789,80 @@ da = ((t_offset)lba) * ctx->sector_size;
 tbc = sects * ctx->sector_size;
 if (sectsread)
     *sectsread = 0;
+#if defined (DISK_HAVE_PREAD)
+bytesread = pread (fileno (uptr->fileref), buf, tbc, (off_t)da);
+if (bytesread < 0)
+    return SCPE_IOERR;
+i = (size_t)bytesread;
+#else
 err = sim_fseeko (uptr->fileref, da, SEEK_SET);          /* set pos */
-if (!err) {
-    i = sim_fread (buf, ctx->xfer_element_size, tbc/ctx->xfer_element_size, uptr->fileref);
-    if (i < tbc/ctx->xfer_element_size)                 /* fill */
-        memset (&buf[i*ctx->xfer_element_size], 0, tbc-(i*ctx->xfer_element_size));
-    err = ferror (uptr->fileref);
-    if ((!err) && (sectsread))
-        *sectsread = (t_seccnt)((i*ctx->xfer_element_size+ctx->sector_size-1)/ctx->sector_size);
+if (err)
+    return err;
+i = fread (buf, 1, tbc, uptr->fileref);
+err = ferror (uptr->fileref);
+if (err)
+    return err;
+#endif
+if (i < tbc)                                            /* fill */
+    memset (&buf[i], 0, tbc - i);
+if (sectsread)
+    *sectsread = (t_seccnt)((i + ctx->sector_size - 1) / ctx->sector_size);
+return SCPE_OK;
+}
+
+/* Read sectors from a SIMH format file or a raw device in container byte
+   order.  With a read-ahead window set, a read which starts where the
+   previous one ended fills the window, and reads falling within the
+   window are then copied from memory. */
+
+static t_stat _sim_disk_rdsect_ra (UNIT *uptr, t_lba lba, uint8 *buf, t_seccnt *sectsread, t_seccnt sects)
+{
+struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
+t_seccnt window = DK_GET_RA (uptr);
+t_seccnt offset, sread = 0;
+t_stat r;
+
+if ((ctx->ra_count == 0) ||                             /* outside the window? */
+    (lba < ctx->ra_lba) ||
+    ((lba - ctx->ra_lba) + sects > ctx->ra_count)) {
+    if ((window <= sects) ||                            /* window no help */
+        (lba != ctx->ra_next)) {                        /* or not sequential? */
+        ctx->ra_next = lba + sects;
+        if (DK_GET_FMT (uptr) == DKUF_F_RAW)
+            return sim_os_disk_rdsect (uptr, lba, buf, sectsread, sects);
+        return _sim_disk_rdsect (uptr, lba, buf, sectsread, sects);
+        }
+    if (window > ctx->ra_size) {
+        uint8 *nbuf = (uint8 *)realloc (ctx->ra_buf, window * ctx->sector_size);
+
+        if (nbuf == NULL)
+            return SCPE_MEM;
+        ctx->ra_buf = nbuf;
+        ctx->ra_size = window;
+        }
+    ctx->ra_count = 0;
+    if (DK_GET_FMT (uptr) == DKUF_F_RAW)
+        r = sim_os_disk_rdsect (uptr, lba, ctx->ra_buf, &sread, window);
+    else
+        r = _sim_disk_rdsect (uptr, lba, ctx->ra_buf, &sread, window);
+    if (r != SCPE_OK) {
+        if (sectsread)
+            *sectsread = 0;
+        return r;
+        }
+    if (sread < window)                                 /* zero past end of data */
+        memset (ctx->ra_buf + sread * ctx->sector_size, 0, (window - sread) * ctx->sector_size);
+    ctx->ra_lba = lba;
+    ctx->ra_count = window;
+    ctx->ra_valid = sread;
     }
-return err;
+offset = lba - ctx->ra_lba;
+memcpy (buf, ctx->ra_buf + offset * ctx->sector_size, sects * ctx->sector_size);
+if (sectsread)
+    *sectsread = (ctx->ra_valid <= offset) ? 0 :
+                 ((ctx->ra_valid - offset < sects) ? ctx->ra_valid - offset : sects);
+ctx->ra_next = lba + sects;
+return SCPE_OK;
 }
 
 t_stat sim_disk_rdsect (UNIT *uptr, t_lba lba, uint8 *buf, t_seccnt *sectsread, t_seccnt sects)
@@ -588,13 +886,12 @@ if ((0 == (ctx->sector_size & (ctx->storage_sector_size - 1))) ||   /* Sector Al
      (0 == ((sects*ctx->sector_size) & (ctx->storage_sector_size - 1))))) {
     switch (DK_GET_FMT (uptr)) {                        /* case on format */
         case DKUF_F_STD:                                /* SIMH format */
-            return _sim_disk_rdsect (uptr, lba, buf, sectsread, sects);
+        case DKUF_F_RAW:                                /* Raw Physical Disk Access */
+            r = _sim_disk_rdsect_ra (uptr, lba, buf, &sread, sects);
+            break;
         case DKUF_F_VHD:                                /* VHD format */
             r = sim_vhd_disk_rdsect (uptr, lba, buf, &sread, sects);
             break;
-        case DKUF_F_RAW:                                /* Raw Physical Disk Access */
-            r = sim_os_disk_rdsect (uptr, lba, buf, &sread, sects);
-            break;
         default:
             return SCPE_NOFNC;
         }
@@ -606,7 +903,7 @@ if ((0 == (ctx->sector_size & (ctx->storage_sector_size - 1))) ||   /* Sector Al
     return r;
     }
 else { /* Unaligned and/or partial sector transfers */
-    uint8 *tbuf = (uint8*) malloc (sects*ctx->sector_size + 2*ctx->storage_sector_size);
+    uint8 *tbuf = _sim_disk_bounce_buf (ctx, sects*ctx->sector_size + 2*ctx->storage_sector_size);
     t_lba sspsts = ctx->storage_sector_size/ctx->sector_size; /* sim sectors in a storage sector */
     t_lba tlba = lba & ~(sspsts - 1);
     t_seccnt tsects = sects + (lba - tlba);
@@ -618,20 +915,17 @@ else { /* Unaligned and/or partial sector transfers */
         return SCPE_MEM;
     switch (DK_GET_FMT (uptr)) {                        /* case on format */
         case DKUF_F_STD:                                /* SIMH format */
-            r = _sim_disk_rdsect (uptr, tlba, tbuf, &sread, tsects);
-            break;
-        case DKUF_F_VHD:                                /* VHD format */
-            r = sim_vhd_disk_rdsect (uptr, tlba, tbuf, &sread, tsects);
+        case DKUF_F_RAW:                                /* Raw Physical Disk Access */
+            r = _sim_disk_rdsect_ra (uptr, tlba, tbuf, &sread, tsects);
             if (r == SCPE_OK)
                 sim_buf_swap_data (tbuf, ctx->xfer_element_size, (sread * ctx->sector_size) / ctx->xfer_element_size);
             break;
-        case DKUF_F_RAW:                                /* Raw Physical Disk Access */
-            r = sim_os_disk_rdsect (uptr, tlba, tbuf, &sread, tsects);
+        case DKUF_F_VHD:                                /* VHD format */
+            r = sim_vhd_disk_rdsect (uptr, tlba, tbuf, &sread, tsects);
             if (r == SCPE_OK)
                 sim_buf_swap_data (tbuf, ctx->xfer_element_size, (sread * ctx->sector_size) / ctx->xfer_element_size);
             break;
         default:
-            free (tbuf);
             return SCPE_NOFNC;
         }
     if (r == SCPE_OK) {
@@ -642,7 +936,6 @@ else { /* Unaligned and/or partial sector transfers */
                 *sectsread = sects;
             }
         }
-    free (tbuf);
     return r;
     }
 }
@@ -661,9 +954,15 @@ return r;
 static t_stat _sim_disk_wrsect (UNIT *uptr, t_lba lba, uint8 *buf, t_seccnt *sectswritten, t_seccnt sects)
 {
 t_offset da;
-uint32 err, tbc;
-size_t i;
+uint32 tbc;
 struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
+#if defined (DISK_HAVE_PREAD)
+uint8 *wbuf = buf;
+ssize_t byteswritten;
+#else
+uint32 err;
+size_t i;
+#endif
 
 sim_debug_unit (ctx->dbit, uptr, "_sim_disk_wrsect(unit=%d, lba=0x%X, sects=%d)\n", (int)(uptr-ctx->dptr->units), lba, sects);
 
@@ -671,6 +970,20 @@ da = ((t_offset)lba) * ctx->sector_size;
 tbc = sects * ctx->sector_size;
 if (sectswritten)
     *sectswritten = 0;
+#if defined (DISK_HAVE_PREAD)
+if ((!sim_end) && (ctx->xfer_element_size != sizeof (char))) {
+    wbuf = _sim_disk_bounce_buf (ctx, tbc);
+    if (wbuf == NULL)
+        return SCPE_MEM;
+    sim_buf_copy_swapped (wbuf, buf, ctx->xfer_element_size, tbc/ctx->xfer_element_size);
+    }
+byteswritten = pwrite (fileno (uptr->fileref), wbuf, tbc, (off_t)da);
+if (byteswritten < 0)
+    return SCPE_IOERR;
+if (sectswritten)
+    *sectswritten = (t_seccnt)((byteswritten+ctx->sector_size-1)/ctx->sector_size);
+return SCPE_OK;
+#else
 err = sim_fseeko (uptr->fileref, da, SEEK_SET);          /* set pos */
 if (!err) {
     i = sim_fwrite (buf, ctx->xfer_element_size, tbc/ctx->xfer_element_size, uptr->fileref);
@@ -679,6 +992,7 @@ if (!err) {
         *sectswritten = (t_seccnt)((i*ctx->xfer_element_size+ctx->sector_size-1)/ctx->sector_size);
     }
 return err;
+#endif
 }
 
 t_stat sim_disk_wrsect (UNIT *uptr, t_lba lba, uint8 *buf, t_seccnt *sectswritten, t_seccnt sects)
@@ -719,6 +1033,10 @@ if (uptr->dynflags & UNIT_DISK_CHK) {
             }
         }
     }
+if ((ctx->ra_count) &&                                  /* overlaps read-ahead? */
+    (lba < ctx->ra_lba + ctx->ra_count) &&
+    (lba + sects > ctx->ra_lba))
+    ctx->ra_count = 0;                                  /* discard it */
 if (f == DKUF_F_STD)
     return _sim_disk_wrsect (uptr, lba, buf, sectswritten, sects);
 if ((0 == (ctx->sector_size & (ctx->storage_sector_size - 1))) ||   /* Sector Aligned & whole sector transfers */
@@ -735,7 +1053,7 @@ if ((0 == (ctx->sector_size & (ctx->storage_sector_size - 1))) ||   /* Sector Al
                 return SCPE_NOFNC;
             }
 
-    tbuf = (uint8*) malloc (sects * ctx->sector_size);
+    tbuf = _sim_disk_bounce_buf (ctx, sects * ctx->sector_size);
     if (NULL == tbuf)
         return SCPE_MEM;
     sim_buf_copy_swapped (tbuf, buf, ctx->xfer_element_size, (sects * ctx->sector_size) / ctx->xfer_element_size);
@@ -757,7 +1075,7 @@ else { /* Unaligned and/or partial sector transfers */
     t_lba tlba = lba & ~(sspsts - 1);
     t_seccnt tsects = sects + (lba - tlba);
 
-    tbuf = (uint8*) malloc (sects*ctx->sector_size + 2*ctx->storage_sector_size);
+    tbuf = _sim_disk_bounce_buf (ctx, sects*ctx->sector_size + 2*ctx->storage_sector_size);
     tsects = (tsects + (sspsts - 1)) & ~(sspsts - 1);
     if (sectswritten)
         *sectswritten = 0;
@@ -813,7 +1131,6 @@ else { /* Unaligned and/or partial sector transfers */
             *sectswritten = sects;
         }
     }
-free (tbuf);
 return r;
 }
 
@@ -837,6 +1154,7 @@ switch (DK_GET_FMT (uptr)) {                            /* case on format */
         return sim_disk_detach (uptr);
     case DKUF_F_RAW:                                    /* Raw Physical Disk Access */
         ctx->media_removed = 1;
+        ctx->ra_count = 0;
         return sim_os_disk_unload_raw (uptr->fileref);  /* remove/eject disk */
         break;
     default:
@@ -876,6 +1194,8 @@ static t_stat _err_return (UNIT *uptr, t_stat stat)
 {
 free (uptr->filename);
 uptr->filename = NULL;
+if (uptr->disk_ctx)
+    _sim_disk_free_bufs ((struct disk_context *)uptr->disk_ctx);
 free (uptr->disk_ctx);
 uptr->disk_ctx = NULL;
 return stat;
@@ -2574,12 +2894,16 @@ if (uptr->io_flush)
     uptr->io_flush (uptr);                              /* flush buffered data */
 
 sim_disk_clr_async (uptr);
+#if defined SIM_ASYNCH_IO
+free (ctx->io_queue);
+#endif
 
 uptr->flags &= ~(UNIT_ATT | UNIT_RO);
 uptr->dynflags &= ~(UNIT_NO_FIO | UNIT_DISK_CHK);
 free (uptr->filename);
 uptr->filename = NULL;
 uptr->fileref = NULL;
+_sim_disk_free_bufs (ctx);
 free (uptr->disk_ctx);
 uptr->disk_ctx = NULL;
 uptr->io_flush = NULL;
@@ -5210,6 +5534,28 @@ for (i=0; i<BufferSize; ++i)
 return TRUE;
 }
 
+/* Write the BAT sectors which hold entries First through Last */
+
+static t_stat
+WriteVirtualDiskBAT(VHDHANDLE hVHD,
+                    uint32 First,
+                    uint32 Last)
+{
+uint32 BATSize = 512*((sizeof(*hVHD->BAT)*NtoHl(hVHD->Dynamic.MaxTableEntries) + 511)/512);
+uint32 Start = (First*sizeof(*hVHD->BAT)) & ~511;
+uint32 End = ((Last + 1)*sizeof(*hVHD->BAT) + 511) & ~511;
+
+if (End > BATSize)
+    End = BATSize;
+if (WriteFilePosition(hVHD->File,
+                      ((uint8 *)hVHD->BAT) + Start,
+                      End - Start,
+                      NULL,
+                      NtoHll(hVHD->Dynamic.TableOffset) + Start))
+    return SCPE_IOERR;
+return SCPE_OK;
+}
+
 static t_stat
 WriteVirtualDiskSectors(VHDHANDLE hVHD,
                         uint8 *buf,
@@ -5222,6 +5568,10 @@ uint64 BlockOffset = ((uint64)lba)*SectorSize;
 uint32 BlocksWritten = 0;
 uint32 SectorsInWrite;
 size_t BytesWritten = 0;
+uint32 BATFirst = 0, BATLast = 0;
+t_bool BATDirty = FALSE;
+t_bool Fatal = FALSE;
+t_stat r = SCPE_OK;
 
 if (!hVHD || !hVHD->File) {
     errno = EBADF;
@@ -5253,29 +5603,38 @@ while (sects) {
     uint32 BitMapSectors = (BitMapBytes+SectorSize-1)/SectorSize;
 
     if (BlockNumber >= NtoHl(hVHD->Dynamic.MaxTableEntries)) {
-        if (sectswritten)
-            *sectswritten = BlocksWritten;
-        return SCPE_EOF;
+        r = SCPE_EOF;
+        break;
         }
-    SectorsInWrite = 1;
+    /* Each pass handles the whole run of sectors which falls within one block */
+    SectorsInWrite = SectorsPerBlock - lba%SectorsPerBlock;
+    if (SectorsInWrite > sects)
+        SectorsInWrite = sects;
     if (hVHD->BAT[BlockNumber] == VHD_BAT_FREE_ENTRY) {
         uint8 *BitMap = NULL;
         uint32 BitMapBufferSize = VHD_DATA_BLOCK_ALIGNMENT;
         uint8 *BitMapBuffer = NULL;
-        void *BlockData = NULL;
-        uint8 *BATUpdateBufferAddress;
-        uint32 BATUpdateBufferSize;
-        uint64 BATUpdateStorageAddress;
+        uint8 *BlockData;
+        uint8 *WriteStart;
 
-        if (!hVHD->Parent && BufferIsZeros(buf, SectorSize))
+        if (!hVHD->Parent && BufferIsZeros(buf, SectorsInWrite*SectorSize))
             goto IO_Done;
-        /* Need to allocate a new Data Block. */
+        /* Need to allocate a new Data Block.  The bitmap, the complete block
+           contents (including the data being written) and the relocated footer
+           go out in a single write.  The BAT entries for any blocks allocated
+           by this request are written once the request is done. */
         BlockOffset = sim_fsize_ex (hVHD->File);
-        if (((int64)BlockOffset) == -1)
-            return SCPE_IOERR;
+        if (((int64)BlockOffset) == -1) {
+            r = SCPE_IOERR;
+            break;
+            }
         if (BitMapSectors*SectorSize > BitMapBufferSize)
             BitMapBufferSize = BitMapSectors*SectorSize;
-        BitMapBuffer = (uint8 *)calloc(1, BitMapBufferSize + SectorSize*SectorsPerBlock);
+        BitMapBuffer = (uint8 *)calloc(1, BitMapBufferSize + SectorSize*(BitMapSectors + SectorsPerBlock) + sizeof(hVHD->Footer));
+        if (BitMapBuffer == NULL) {
+            r = SCPE_MEM;
+            break;
+            }
         if (BitMapBufferSize > BitMapSectors*SectorSize)
             BitMap = BitMapBuffer + BitMapBufferSize-BitMapBytes;
         else
@@ -5284,15 +5643,8 @@ while (sects) {
         BlockOffset -= sizeof(hVHD->Footer);
         if (0 == (BlockOffset & ~(VHD_DATA_BLOCK_ALIGNMENT-1)))
             {  // Already aligned, so use padded BitMapBuffer
-            if (WriteFilePosition(hVHD->File,
-                                  BitMapBuffer,
-                                  BitMapBufferSize + SectorSize*SectorsPerBlock,
-                                  NULL,
-                                  BlockOffset)) {
-                free (BitMapBuffer);
-                return SCPE_IOERR;
-                }
-            BlockOffset += BitMapBufferSize;
+            WriteStart = BitMapBuffer;
+            BlockData = BitMapBuffer + BitMapBufferSize;
             }
         else
             {
@@ -5303,98 +5655,59 @@ while (sects) {
             BlockOffset += VHD_DATA_BLOCK_ALIGNMENT-1;
             BlockOffset &= ~(VHD_DATA_BLOCK_ALIGNMENT-1);
             BlockOffset -= BitMapSectors*SectorSize;
-            if (WriteFilePosition(hVHD->File,
-                                  BitMap,
-                                  SectorSize * (BitMapSectors + SectorsPerBlock),
-                                  NULL,
-                                  BlockOffset)) {
-                free (BitMapBuffer);
-                return SCPE_IOERR;
-                }
-            BlockOffset += BitMapSectors*SectorSize;
-            }
-        free(BitMapBuffer);
-        BitMapBuffer = BitMap = NULL;
-        /* the BAT block address is the beginning of the block bitmap */
-        BlockOffset -= BitMapSectors*SectorSize;
-        hVHD->BAT[BlockNumber] = NtoHl((uint32)(BlockOffset/SectorSize));
-        BlockOffset += SectorSize * (SectorsPerBlock + BitMapSectors);
-        if (WriteFilePosition(hVHD->File,
-                              &hVHD->Footer,
-                              sizeof(hVHD->Footer),
-                              NULL,
-                              BlockOffset))
-            goto Fatal_IO_Error;
-        /* Since a large VHD can have a pretty large BAT, and we've only changed one longword bat entry
-           in the current BAT, we write just the aligned sector which contains the updated BAT entry */
-        BATUpdateBufferAddress = (uint8 *)hVHD->BAT - (size_t)NtoHll(hVHD->Dynamic.TableOffset) + 
-            (size_t)((((size_t)&hVHD->BAT[BlockNumber]) - (size_t)hVHD->BAT + (size_t)NtoHll(hVHD->Dynamic.TableOffset)) & ~(VHD_DATA_BLOCK_ALIGNMENT-1));
-        /* If the starting of the BAT isn't on a VHD_DATA_BLOCK_ALIGNMENT boundary and we've just updated 
-           a BAT entry early in the array, the buffer computed address might be before the start of the
-           BAT table.  If so, only write the BAT data needed */
-        if (BATUpdateBufferAddress < (uint8 *)hVHD->BAT) {
-            BATUpdateBufferAddress = (uint8 *)hVHD->BAT;
-            BATUpdateBufferSize = (uint32)((((size_t)&hVHD->BAT[BlockNumber]) - (size_t)hVHD->BAT) + 512) & ~511;
-            BATUpdateStorageAddress = NtoHll(hVHD->Dynamic.TableOffset);
+            WriteStart = BitMap;
+            BlockData = BitMap + BitMapSectors*SectorSize;
             }
-        else {
-            BATUpdateBufferSize = VHD_DATA_BLOCK_ALIGNMENT;
-            BATUpdateStorageAddress = NtoHll(hVHD->Dynamic.TableOffset) + BATUpdateBufferAddress - ((uint8 *)hVHD->BAT);
-            }
-        /* If the total BAT is smaller than one VHD_DATA_BLOCK_ALIGNMENT, then be sure to only write out the BAT data */
-        if ((size_t)(BATUpdateBufferAddress - (uint8 *)hVHD->BAT + BATUpdateBufferSize) > 512*((sizeof(*hVHD->BAT)*NtoHl(hVHD->Dynamic.MaxTableEntries) + 511)/512))
-            BATUpdateBufferSize = (uint32)(512*((sizeof(*hVHD->BAT)*NtoHl(hVHD->Dynamic.MaxTableEntries) + 511)/512) - (BATUpdateBufferAddress - ((uint8 *)hVHD->BAT)));
-        if (WriteFilePosition(hVHD->File,
-                              BATUpdateBufferAddress,
-                              BATUpdateBufferSize,
-                              NULL,
-                              BATUpdateStorageAddress))
-            goto Fatal_IO_Error;
         if (hVHD->Parent)
             { /* Need to populate data block contents from parent VHD */
             uint32 BlockSectors = SectorsPerBlock;
 
-            BlockData = malloc(SectorsPerBlock*SectorSize);
-
             if (((lba/SectorsPerBlock)*SectorsPerBlock + BlockSectors) > ((uint64)NtoHll (hVHD->Footer.CurrentSize))/SectorSize)
                 BlockSectors = (uint32)(((uint64)NtoHll (hVHD->Footer.CurrentSize))/SectorSize - (lba/SectorsPerBlock)*SectorsPerBlock);
             if (ReadVirtualDiskSectors(hVHD->Parent,
-                                       (uint8*) BlockData,
+                                       BlockData,
                                        BlockSectors,
                                        NULL,
                                        SectorSize,
-                                       (lba/SectorsPerBlock)*SectorsPerBlock))
-                goto Fatal_IO_Error;
-            if (WriteVirtualDiskSectors(hVHD,
-                                        (uint8*) BlockData,
-                                        BlockSectors,
-                                        NULL,
-                                        SectorSize,
-                                        (lba/SectorsPerBlock)*SectorsPerBlock))
-                goto Fatal_IO_Error;
-            free(BlockData);
+                                       (lba/SectorsPerBlock)*SectorsPerBlock)) {
+                free (BitMapBuffer);
+                r = SCPE_IOERR;
+                break;
+                }
             }
-        continue;
-Fatal_IO_Error:
-        free (BitMap);
-        free (BlockData);
-        fclose (hVHD->File);
-        hVHD->File = NULL;
-        return SCPE_IOERR;
+        memcpy (BlockData + SectorSize*(lba%SectorsPerBlock), buf, SectorSize*SectorsInWrite);
+        memcpy (BlockData + SectorSize*SectorsPerBlock, &hVHD->Footer, sizeof(hVHD->Footer));
+        if (WriteFilePosition(hVHD->File,
+                              WriteStart,
+                              (uint32)(BlockData - WriteStart) + SectorSize*SectorsPerBlock + sizeof(hVHD->Footer),
+                              NULL,
+                              BlockOffset)) {
+            free (BitMapBuffer);
+            Fatal = TRUE;
+            r = SCPE_IOERR;
+            break;
+            }
+        /* the BAT block address is the beginning of the block bitmap */
+        BlockOffset += (BlockData - WriteStart) - BitMapSectors*SectorSize;
+        free (BitMapBuffer);
+        hVHD->BAT[BlockNumber] = NtoHl((uint32)(BlockOffset/SectorSize));
+        if (!BATDirty)
+            BATFirst = BATLast = (uint32)BlockNumber;
+        BATDirty = TRUE;
+        if (BlockNumber < BATFirst)
+            BATFirst = (uint32)BlockNumber;
+        if (BlockNumber > BATLast)
+            BATLast = (uint32)BlockNumber;
         }
     else {
         BlockOffset = 512*((uint64)(NtoHl(hVHD->BAT[BlockNumber]) + lba%SectorsPerBlock + BitMapSectors));
-        SectorsInWrite = SectorsPerBlock - lba%SectorsPerBlock;
-        if (SectorsInWrite > sects)
-            SectorsInWrite = sects;
         if (WriteFilePosition(hVHD->File,
                               buf,
                               SectorsInWrite*SectorSize,
                               NULL,
                               BlockOffset)) {
-            if (sectswritten)
-                *sectswritten = BlocksWritten;
-            return SCPE_IOERR;
+            r = SCPE_IOERR;
+            break;
             }
         }
 IO_Done:
@@ -5403,9 +5716,18 @@ IO_Done:
     lba += SectorsInWrite;
     BlocksWritten += SectorsInWrite;
     }
+if (BATDirty &&                                         /* record new blocks */
+    (WriteVirtualDiskBAT(hVHD, BATFirst, BATLast) != SCPE_OK)) {
+    Fatal = TRUE;
+    r = SCPE_IOERR;
+    }
+if (Fatal) {
+    fclose (hVHD->File);
+    hVHD->File = NULL;
+    }
 if (sectswritten)
     *sectswritten = BlocksWritten;
-return SCPE_OK;
+return r;
 }
 
 static t_stat sim_vhd_disk_wrsect (UNIT *uptr, t_lba lba, uint8 *buf, t_seccnt *sectswritten, t_seccnt sects)
@@ -59,6 +59,7 @@ typedef uint32          t_lba;                          /* disk logical block ad
 #define DK_F_VHD        (DKUF_F_VHD << DKUF_V_FMT)
 
 #define DK_GET_FMT(u)   (((u)->flags >> DKUF_V_FMT) & DKUF_M_FMT)
+#define DK_GET_RA(u)    (((u)->dynflags & UNIT_M_DF_DISK_RA) >> UNIT_V_DF_DISK_RA) /* read-ahead sectors */
 
 /* Return status codes */
 
@@ -83,8 +84,12 @@ t_stat sim_disk_set_fmt (UNIT *uptr, int32 val, CONST char *cptr, void *desc);
 t_stat sim_disk_show_fmt (FILE *st, UNIT *uptr, int32 val, CONST void *desc);
 t_stat sim_disk_set_capac (UNIT *uptr, int32 val, CONST char *cptr, void *desc);
 t_stat sim_disk_show_capac (FILE *st, UNIT *uptr, int32 val, CONST void *desc);
-t_stat sim_disk_set_asynch (UNIT *uptr, int latency);
-t_stat sim_disk_clr_asynch (UNIT *uptr);
+t_stat sim_disk_set_readahead (UNIT *uptr, int32 val, CONST char *cptr, void *desc);
+t_stat sim_disk_show_readahead (FILE *st, UNIT *uptr, int32 val, CONST void *desc);
+t_stat sim_disk_set_async (UNIT *uptr, int latency);
+t_stat sim_disk_clr_async (UNIT *uptr);
+t_stat sim_disk_set_async_depth (UNIT *uptr, int depth);
+void sim_disk_aio_lock (t_bool lock);
 t_stat sim_disk_reset (UNIT *uptr);
 t_stat sim_disk_perror (UNIT *uptr, const char *msg);
 t_stat sim_disk_clearerr (UNIT *uptr);
@@ -951,6 +951,10 @@ t_stat eth_write (ETH_DEV* dev, ETH_PACK* packet, ETH_PCALLBACK routine)
   {return SCPE_NOFNC;}
 int eth_read (ETH_DEV* dev, ETH_PACK* packet, ETH_PCALLBACK routine)
   {return SCPE_NOFNC;}
+int eth_read_batch (ETH_DEV* dev, ETH_PACK** packets, int max)
+  {return 0;}
+void eth_read_release (ETH_DEV* dev, ETH_PACK* packet)
+  {}
 t_stat eth_filter (ETH_DEV* dev, int addr_count, ETH_MAC* const addresses,
                    ETH_BOOL all_multicast, ETH_BOOL promiscuous)
   {return SCPE_NOFNC;}
@@ -988,6 +992,9 @@ const char *eth_capabilities(void)
 #endif
 #if defined (HAVE_SLIRP_NETWORK)
      ":NAT"
+#endif
+#if defined (HAVE_PACKET_NETWORK)
+     ":PKT"
 #endif
      ":UDP";
  }
@@ -1043,6 +1050,25 @@ extern "C" {
 #include "sim_slirp.h"
 #endif /* HAVE_SLIRP_NETWORK */
 
+#ifdef HAVE_PACKET_NETWORK
+#if (defined(__linux) || defined(__linux__)) && defined (USE_READER_THREAD)
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <net/if.h>
+#include <linux/if_packet.h>
+#include <linux/filter.h>
+#if !defined (TPACKET3_HDRLEN)      /* Kernel headers predate TPACKET_V3 */
+#undef HAVE_PACKET_NETWORK
+#endif
+#ifndef ETH_P_ALL
+#define ETH_P_ALL 0x0003
+#endif
+#else /* AF_PACKET rings are Linux only and are serviced by the reader thread */
+#undef HAVE_PACKET_NETWORK
+#endif
+#endif /* HAVE_PACKET_NETWORK */
+
 /* Allows windows to look up user-defined adapter names */
 #if defined(_WIN32)
 #include <winreg.h>
@@ -1563,6 +1589,19 @@ static void eth_get_nic_hw_addr(ETH_DEV* dev, const char *devname)
 {
   memset(&dev->host_nic_phy_hw_addr, 0, sizeof(dev->host_nic_phy_hw_addr));
   dev->have_host_nic_phy_addr = 0;
+#if defined (HAVE_PACKET_NETWORK)
+  if (dev->eth_api == ETH_API_PKT) {
+    struct ifreq ifr;
+
+    memset(&ifr, 0, sizeof(ifr));
+    strlcpy(ifr.ifr_name, devname + 4, sizeof(ifr.ifr_name));
+    if (0 == ioctl(dev->fd_handle, SIOCGIFHWADDR, &ifr)) {
+      memcpy(dev->host_nic_phy_hw_addr, ifr.ifr_hwaddr.sa_data, sizeof(ETH_MAC));
+      dev->have_host_nic_phy_addr = 1;
+      }
+    return;
+    }
+#endif
   if (dev->eth_api != ETH_API_PCAP)
     return;
 #if defined(_WIN32) || defined(__CYGWIN__)
@@ -1702,6 +1741,8 @@ _eth_write(ETH_DEV* dev, ETH_PACK* packet, ETH_PCALLBACK routine);
 static void
 _eth_error(ETH_DEV* dev, const char* where);
 
+static t_stat _eth_close_port(int eth_api, pcap_t *pcap, SOCKET pcap_fd);
+
 #if defined(HAVE_SLIRP_NETWORK)
 static void _slirp_callback (void *opaque, const unsigned char *buf, int len)
 {
@@ -1713,7 +1754,424 @@ _eth_callback((u_char *)opaque, &header, buf);
 }
 #endif
 
+#if defined (HAVE_PACKET_NETWORK)
+/* Linux AF_PACKET transport
+
+   pkt:ifname attaches directly to a host interface through a packet socket
+   with memory mapped TPACKET_V3 rings, without libpcap and without a system
+   call or copy per frame.  The kernel fills whole blocks of received frames
+   which the reader thread walks in place.  A block is handed over when it
+   fills or ETH_PKT_BLOCK_TOV msec after its first frame arrived.  Frames to
+   send are placed in transmit ring slots and the kernel is kicked once per
+   burst of queued writes.  Reception is narrowed in the kernel by a classic
+   BPF program built from the device's filter state, and frames which pass
+   it are then filtered exactly as the tap and udp transports do.
+*/
+
+#define ETH_PKT_BLOCK_SIZE  (1 << 16)                   /* ring block size */
+#define ETH_PKT_RX_BLOCKS   64                          /* receive ring blocks (4MB) */
+#define ETH_PKT_TX_BLOCKS   8                           /* transmit ring blocks (512KB) */
+#define ETH_PKT_FRAME_SIZE  2048                        /* ring frame size */
+#define ETH_PKT_BLOCK_TOV   2                           /* msec to wait on a partly filled block */
+#define ETH_PKT_SNAPLEN     ETH_MAX_JUMBO_FRAME         /* bytes of a frame accepted by the filter */
+
+struct eth_pkt {
+  int               fd;                                 /* AF_PACKET socket */
+  uint8             *map;                               /* receive ring followed by transmit ring */
+  size_t            map_size;
+  uint8             *rx_ring;
+  uint32            rx_block;                           /* next receive block to examine */
+  uint8             *tx_ring;                           /* NULL when transmitting with send() */
+  uint32            tx_frames;
+  uint32            tx_frame;                           /* next transmit frame */
+  pthread_mutex_t   tx_lock;
+  };
+
+static void _eth_pkt_close (struct eth_pkt *pkt)
+{
+if (pkt->map)
+  munmap (pkt->map, pkt->map_size);
+if (pkt->fd >= 0)
+  close (pkt->fd);
+pthread_mutex_destroy (&pkt->tx_lock);
+free (pkt);
+}
+
+static t_stat _eth_pkt_open (const char *ifname, void **handle, SOCKET *fd_handle, char errbuf[PCAP_ERRBUF_SIZE])
+{
+struct eth_pkt *pkt;
+struct tpacket_req3 req;
+struct sockaddr_ll sll;
+struct packet_mreq mr;
+struct ifreq ifr;
+int version = TPACKET_V3;
+int on = 1;
+size_t rx_size = ETH_PKT_BLOCK_SIZE * ETH_PKT_RX_BLOCKS;
+size_t tx_size = 0;
+int ifindex = (int)if_nametoindex (ifname);
+
+if (ifindex == 0) {
+  snprintf (errbuf, PCAP_ERRBUF_SIZE, "%s: %s", ifname, strerror (errno));
+  return SCPE_OPENERR;
+  }
+pkt = (struct eth_pkt *)calloc (1, sizeof (*pkt));
+pkt->fd = -1;
+pthread_mutex_init (&pkt->tx_lock, NULL);
+/* No protocol until bound, so nothing is captured before the rings exist */
+if (((pkt->fd = socket (AF_PACKET, SOCK_RAW, 0)) < 0) ||
+    (setsockopt (pkt->fd, SOL_PACKET, PACKET_VERSION, &version, sizeof (version))))
+  goto Error;
+memset (&req, 0, sizeof (req));
+req.tp_block_size = ETH_PKT_BLOCK_SIZE;
+req.tp_block_nr = ETH_PKT_RX_BLOCKS;
+req.tp_frame_size = ETH_PKT_FRAME_SIZE;
+req.tp_frame_nr = (ETH_PKT_BLOCK_SIZE / ETH_PKT_FRAME_SIZE) * ETH_PKT_RX_BLOCKS;
+req.tp_retire_blk_tov = ETH_PKT_BLOCK_TOV;
+if (setsockopt (pkt->fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof (req)))
+  goto Error;
+/* A TPACKET_V3 transmit ring needs Linux 4.11, otherwise fall back to send() */
+memset (&req, 0, sizeof (req));
+req.tp_block_size = ETH_PKT_BLOCK_SIZE;
+req.tp_block_nr = ETH_PKT_TX_BLOCKS;
+req.tp_frame_size = ETH_PKT_FRAME_SIZE;
+req.tp_frame_nr = (ETH_PKT_BLOCK_SIZE / ETH_PKT_FRAME_SIZE) * ETH_PKT_TX_BLOCKS;
+(void)setsockopt (pkt->fd, SOL_PACKET, PACKET_LOSS, &on, sizeof (on));
+if (0 == setsockopt (pkt->fd, SOL_PACKET, PACKET_TX_RING, &req, sizeof (req))) {
+  tx_size = ETH_PKT_BLOCK_SIZE * ETH_PKT_TX_BLOCKS;
+  pkt->tx_frames = req.tp_frame_nr;
+  }
+pkt->map_size = rx_size + tx_size;
+pkt->map = (uint8 *)mmap (NULL, pkt->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, pkt->fd, 0);
+if (pkt->map == (uint8 *)MAP_FAILED) {
+  pkt->map = NULL;
+  goto Error;
+  }
+pkt->rx_ring = pkt->map;
+if (tx_size)
+  pkt->tx_ring = pkt->map + rx_size;
+memset (&sll, 0, sizeof (sll));
+sll.sll_family = AF_PACKET;
+sll.sll_protocol = htons (ETH_P_ALL);
+sll.sll_ifindex = ifindex;
+if (bind (pkt->fd, (struct sockaddr *)&sll, sizeof (sll)))
+  goto Error;
+memset (&mr, 0, sizeof (mr));
+mr.mr_ifindex = ifindex;
+mr.mr_type = PACKET_MR_PROMISC;
+if (setsockopt (pkt->fd, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &mr, sizeof (mr)))
+  goto Error;
+/* try to force an otherwise unused interface to be turned on */
+memset (&ifr, 0, sizeof (ifr));
+strlcpy (ifr.ifr_name, ifname, sizeof (ifr.ifr_name));
+if ((0 == ioctl (pkt->fd, SIOCGIFFLAGS, &ifr)) && (!(ifr.ifr_flags & IFF_UP))) {
+  ifr.ifr_flags |= IFF_UP;
+  (void)ioctl (pkt->fd, SIOCSIFFLAGS, &ifr);
+  }
+*handle = (void *)pkt;
+*fd_handle = (SOCKET)pkt->fd;
+return SCPE_OK;
+
+Error:
+snprintf (errbuf, PCAP_ERRBUF_SIZE, "%s: %s", ifname, strerror (errno));
+_eth_pkt_close (pkt);
+return SCPE_OPENERR;
+}
+
+/* Walk the receive blocks the kernel has handed over */
+
+static int _eth_pkt_dispatch (ETH_DEV *dev)
+{
+struct eth_pkt *pkt = (struct eth_pkt *)dev->handle;
+int count = 0;
+
+while (1) {
+  struct tpacket_block_desc *bd = (struct tpacket_block_desc *)(pkt->rx_ring + pkt->rx_block * ETH_PKT_BLOCK_SIZE);
+  struct tpacket3_hdr *ppd;
+  uint32 i;
+
+  if (!(bd->hdr.bh1.block_status & TP_STATUS_USER))
+    break;
+  __sync_synchronize ();
+  ppd = (struct tpacket3_hdr *)((uint8 *)bd + bd->hdr.bh1.offset_to_first_pkt);
+  for (i = 0; i < bd->hdr.bh1.num_pkts; i++) {
+    struct pcap_pkthdr header;
+    uint8 *data = (uint8 *)ppd + ppd->tp_mac;
+
+    memset(&header, 0, sizeof(header));
+    header.caplen = ppd->tp_snaplen;
+    header.len = ppd->tp_len;
+    if ((ppd->tp_status & TP_STATUS_VLAN_VALID) &&
+        (ppd->tp_snaplen >= 12) && (ppd->tp_snaplen + 4 <= ETH_MAX_JUMBO_FRAME)) {
+      /* Put back the 802.1Q tag the kernel moved out of the frame */
+      u_char buf[ETH_MAX_JUMBO_FRAME];
+      uint16 tpid = 0x8100;
+
+#if defined (TP_STATUS_VLAN_TPID_VALID)
+      if (ppd->tp_status & TP_STATUS_VLAN_TPID_VALID)
+        tpid = ppd->hv1.tp_vlan_tpid;
+#endif
+      memcpy (buf, data, 12);
+      buf[12] = tpid >> 8;
+      buf[13] = tpid & 0xFF;
+      buf[14] = ppd->hv1.tp_vlan_tci >> 8;
+      buf[15] = ppd->hv1.tp_vlan_tci & 0xFF;
+      memcpy (buf + 16, data + 12, ppd->tp_snaplen - 12);
+      header.caplen += 4;
+      header.len += 4;
+      _eth_callback((u_char *)dev, &header, buf);
+      }
+    else
+      _eth_callback((u_char *)dev, &header, data);
+    ppd = (struct tpacket3_hdr *)((uint8 *)ppd + ppd->tp_next_offset);
+    ++count;
+    }
+  __sync_synchronize ();
+  bd->hdr.bh1.block_status = TP_STATUS_KERNEL;
+  if (++pkt->rx_block == ETH_PKT_RX_BLOCKS)
+    pkt->rx_block = 0;
+  }
+return count;
+}
+
+/* Queue a frame for transmission, kicking the kernel when flush is set
+   or the transmit ring is full */
+
+static int _eth_pkt_send (ETH_DEV *dev, const uint8 *msg, size_t len, int flush)
+{
+struct eth_pkt *pkt = (struct eth_pkt *)dev->handle;
+struct tpacket3_hdr *hdr;
+int status = 0;
+
+if (!pkt->tx_ring)
+  return (((ssize_t)len == send (pkt->fd, msg, len, 0)) ? 0 : -1);
+pthread_mutex_lock (&pkt->tx_lock);
+hdr = (struct tpacket3_hdr *)(pkt->tx_ring + pkt->tx_frame * ETH_PKT_FRAME_SIZE);
+if (hdr->tp_status != TP_STATUS_AVAILABLE) {        /* ring full? */
+  (void)send (pkt->fd, NULL, 0, 0);                 /* wait for it to drain */
+  if (hdr->tp_status != TP_STATUS_AVAILABLE)
+    status = -1;
+  }
+if (status == 0) {
+  memcpy ((uint8 *)hdr + TPACKET3_HDRLEN - sizeof (struct sockaddr_ll), msg, len);
+  hdr->tp_len = hdr->tp_snaplen = (uint32)len;
+  hdr->tp_next_offset = 0;
+  __sync_synchronize ();
+  hdr->tp_status = TP_STATUS_SEND_REQUEST;
+  if (++pkt->tx_frame == pkt->tx_frames)
+    pkt->tx_frame = 0;
+  if ((flush) &&
+      (send (pkt->fd, NULL, 0, MSG_DONTWAIT) < 0) &&
+      (errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != ENOBUFS))
+    status = -1;
+  }
+pthread_mutex_unlock (&pkt->tx_lock);
+return status;
+}
+
+/* Attach a kernel filter accepting a superset of what _eth_callback will
+   keep:  frames addressed to a filter address, the host NIC, or the
+   loopback reflection address, plus multicast frames when all multicast
+   or hash filtering is active.  Promiscuous mode accepts everything. */
+
+static t_stat _eth_pkt_filter (ETH_DEV *dev, struct eth_pkt *pkt)
+{
+static ETH_MAC reflection = {0xfe,0xff,0xff,0xff,0xff,0xfe};
+ETH_MAC dest[ETH_FILTER_MAX + 2];
+struct sock_filter code[4 * (ETH_FILTER_MAX + 2) + 4];
+struct sock_fprog prog;
+int i, count = 0, n = 0, accept;
+int multicast = (dev->all_multicast || dev->hash_filter);
+
+if (!dev->promiscuous) {
+  for (i = 0; i < dev->addr_count; i++)
+    memcpy (dest[count++], dev->filter_address[i], sizeof(ETH_MAC));
+  if (dev->have_host_nic_phy_addr)
+    memcpy (dest[count++], dev->host_nic_phy_hw_addr, sizeof(ETH_MAC));
+  memcpy (dest[count++], reflection, sizeof(ETH_MAC));
+  accept = 4 * count + (multicast ? 2 : 0) + 1;     /* index of accept return */
+  for (i = 0; i < count; i++) {
+    uint32 hi = ((uint32)dest[i][0] << 24) | ((uint32)dest[i][1] << 16) | ((uint32)dest[i][2] << 8) | dest[i][3];
+    uint32 lo = ((uint32)dest[i][4] << 8) | dest[i][5];
+
+    code[n] = (struct sock_filter)BPF_STMT (BPF_LD | BPF_W | BPF_ABS, 0);
+    ++n;
+    code[n] = (struct sock_filter)BPF_JUMP (BPF_JMP | BPF_JEQ | BPF_K, hi, 0, 2);
+    ++n;
+    code[n] = (struct sock_filter)BPF_STMT (BPF_LD | BPF_H | BPF_ABS, 4);
+    ++n;
+    code[n] = (struct sock_filter)BPF_JUMP (BPF_JMP | BPF_JEQ | BPF_K, lo, accept - (n + 1), 0);
+    ++n;
+    }
+  if (multicast) {
+    code[n] = (struct sock_filter)BPF_STMT (BPF_LD | BPF_B | BPF_ABS, 0);
+    ++n;
+    code[n] = (struct sock_filter)BPF_JUMP (BPF_JMP | BPF_JSET | BPF_K, 1, 1, 0);
+    ++n;
+    }
+  code[n] = (struct sock_filter)BPF_STMT (BPF_RET | BPF_K, 0);
+  ++n;
+  }
+code[n] = (struct sock_filter)BPF_STMT (BPF_RET | BPF_K, ETH_PKT_SNAPLEN);
+++n;
+prog.len = (unsigned short)n;
+prog.filter = code;
+if (setsockopt (pkt->fd, SOL_SOCKET, SO_ATTACH_FILTER, &prog, sizeof (prog))) {
+  sim_printf ("Eth: SO_ATTACH_FILTER error: %s\n", strerror (errno));
+  return SCPE_IOERR;
+  }
+return SCPE_OK;
+}
+#endif /* HAVE_PACKET_NETWORK */
+
 #if defined (USE_READER_THREAD)
+/* Receive ring
+
+   Received packets pass from the reader thread to the simulator thread
+   without a lock and without an intermediate copy.  A fixed pool of packet
+   buffers circulates through two single producer/single consumer rings of
+   buffer pointers.  The reader thread takes an empty buffer from the avail
+   ring, fills it and publishes it on the rcvd ring.  The simulator takes it
+   from the rcvd ring, hands the buffer itself to the device, and puts it
+   back on the avail ring when the device is done with it.  A NULL slot is
+   empty, each side only moves its own indices, and slot pointers are
+   exchanged with a full barrier so the packet contents are visible before
+   the pointer is.  When every buffer is queued or held by the device the
+   arriving packet is dropped and counted as lost.
+
+   Without interlocked intrinsics the slot exchanges are done under the
+   device lock instead.
+*/
+
+#if defined (USE_AIO_INTRINSICS)
+#define ETH_RING_LOCK(dev)
+#define ETH_RING_UNLOCK(dev)
+#define ETH_RING_SLOT(slot)       (ETH_ITEM *)InterlockedCompareExchangePointer ((void * volatile *)&(slot), (void *)(slot), NULL)
+#define ETH_RING_PUT(slot, item)  (void)InterlockedCompareExchangePointer ((void * volatile *)&(slot), (void *)(item), NULL)
+#define ETH_RING_TAKE(slot, item) (void)InterlockedCompareExchangePointer ((void * volatile *)&(slot), NULL, (void *)(item))
+#else
+#define ETH_RING_LOCK(dev)        pthread_mutex_lock (&(dev)->lock)
+#define ETH_RING_UNLOCK(dev)      pthread_mutex_unlock (&(dev)->lock)
+#define ETH_RING_SLOT(slot)       (slot)
+#define ETH_RING_PUT(slot, item)  (slot) = (item)
+#define ETH_RING_TAKE(slot, item) (slot) = NULL
+#endif
+
+static void _eth_ring_destroy (ETH_RING *ring)
+{
+int i;
+
+if (ring->pool)
+  for (i = 0; i < ring->max; i++)
+    free (ring->pool[i].packet.oversize);
+free (ring->pool);
+free ((void *)ring->rcvd);
+free ((void *)ring->avail);
+memset (ring, 0, sizeof (*ring));
+}
+
+static t_stat _eth_ring_init (ETH_RING *ring, int max)
+{
+int i;
+
+memset (ring, 0, sizeof (*ring));
+ring->pool = (ETH_ITEM *)calloc (max, sizeof (*ring->pool));
+ring->rcvd = (ETH_ITEM * volatile *)calloc (max, sizeof (*ring->rcvd));
+ring->avail = (ETH_ITEM * volatile *)calloc (max, sizeof (*ring->avail));
+if ((!ring->pool) || (!ring->rcvd) || (!ring->avail)) {
+  _eth_ring_destroy (ring);
+  sim_printf ("Eth: failed to allocate receive ring[%d]\n", max);
+  return SCPE_MEM;
+  }
+ring->max = max;
+for (i = 0; i < max; i++)
+  ring->avail[i] = &ring->pool[i];
+return SCPE_OK;
+}
+
+/* Reader thread: queue a received packet */
+
+static void _eth_ring_insert (ETH_DEV *dev, const uint8 *data, uint32 len, uint32 crc_len, const uint8 *crc_data)
+{
+ETH_RING *ring = &dev->read_ring;
+ETH_ITEM *item;
+uint32 size = MAX (len, crc_len);
+uint8 *msg;
+
+ETH_RING_LOCK (dev);
+item = ETH_RING_SLOT (ring->avail[ring->avail_get]);
+if (item == NULL)                           /* no free buffer? */
+  ++ring->loss;                             /* drop the packet */
+else {
+  ETH_RING_TAKE (ring->avail[ring->avail_get], item);
+  if (++ring->avail_get == ring->max)
+    ring->avail_get = 0;
+  item->type = ETH_ITM_NORMAL;
+  item->packet.len = len;
+  item->packet.used = 0;
+  item->packet.crc_len = crc_len;
+  item->packet.status = 0;
+  if (size <= sizeof (item->packet.msg)) {
+    if (item->packet.oversize) {
+      free (item->packet.oversize);
+      item->packet.oversize = NULL;
+      }
+    msg = item->packet.msg;
+    }
+  else
+    msg = item->packet.oversize = (uint8 *)realloc (item->packet.oversize, size);
+  memcpy (msg, data, size);
+  if (crc_data && (crc_len > len))
+    memcpy (&msg[len], crc_data, ETH_CRC_SIZE);
+  item->time = sim_os_msec ();
+  if (++ring->in - ring->out > ring->high)
+    ring->high = ring->in - ring->out;
+  ETH_RING_PUT (ring->rcvd[ring->rcvd_put], item);
+  if (++ring->rcvd_put == ring->max)
+    ring->rcvd_put = 0;
+  }
+++dev->packets_received;
+ETH_RING_UNLOCK (dev);
+}
+
+/* Simulator thread: take the oldest received packet */
+
+static ETH_ITEM *_eth_ring_remove (ETH_DEV *dev)
+{
+ETH_RING *ring = &dev->read_ring;
+ETH_ITEM *item = NULL;
+uint32 latency;
+
+if (ring->max == 0)
+  return NULL;
+ETH_RING_LOCK (dev);
+item = ETH_RING_SLOT (ring->rcvd[ring->rcvd_get]);
+if (item != NULL) {
+  ETH_RING_TAKE (ring->rcvd[ring->rcvd_get], item);
+  if (++ring->rcvd_get == ring->max)
+    ring->rcvd_get = 0;
+  ++ring->out;
+  latency = sim_os_msec () - item->time;
+  ring->latency_total += latency;
+  if (latency > ring->latency_max)
+    ring->latency_max = latency;
+  }
+ETH_RING_UNLOCK (dev);
+return item;
+}
+
+/* Simulator thread: give a packet buffer back to the reader thread */
+
+static void _eth_ring_release (ETH_DEV *dev, ETH_ITEM *item)
+{
+ETH_RING *ring = &dev->read_ring;
+
+ETH_RING_LOCK (dev);
+ETH_RING_PUT (ring->avail[ring->avail_put], item);
+if (++ring->avail_put == ring->max)
+  ring->avail_put = 0;
+ETH_RING_UNLOCK (dev);
+}
+
 static void *
 _eth_reader(void *arg)
 {
@@ -1739,6 +2197,7 @@ switch (dev->eth_api) {
   case ETH_API_VDE:
   case ETH_API_UDP:
   case ETH_API_NAT:
+  case ETH_API_PKT:
     do_select = 1;
     select_fd = dev->fd_handle;
     break;
@@ -1845,6 +2304,11 @@ while (dev->handle) {
         status = 1;
         break;
 #endif /* HAVE_SLIRP_NETWORK */
+#ifdef HAVE_PACKET_NETWORK
+      case ETH_API_PKT:
+        status = _eth_pkt_dispatch (dev);
+        break;
+#endif /* HAVE_PACKET_NETWORK */
       case ETH_API_UDP:
         if (1) {
           struct pcap_pkthdr header;
@@ -1868,12 +2332,7 @@ while (dev->handle) {
         break;
       }
     if ((status > 0) && (dev->asynch_io)) {
-      int wakeup_needed;
-
-      pthread_mutex_lock (&dev->lock);
-      wakeup_needed = (dev->read_queue.count != 0);
-      pthread_mutex_unlock (&dev->lock);
-      if (wakeup_needed) {
+      if (dev->read_ring.in != dev->read_ring.out) {
         sim_debug(dev->dbit, dev->dptr, "Queueing automatic poll\n");
         sim_activate_abs (dev->dptr->units, dev->asynch_io_latency);
         }
@@ -1962,14 +2421,9 @@ t_stat eth_set_async (ETH_DEV *dev, int latency)
 char *msg = "Eth: can't operate asynchronously, must poll\n";
 return sim_messagef (SCPE_NOFNC, "%s", msg);
 #else
-int wakeup_needed;
-
 dev->asynch_io = 1;
 dev->asynch_io_latency = latency;
-pthread_mutex_lock (&dev->lock);
-wakeup_needed = (dev->read_queue.count != 0);
-pthread_mutex_unlock (&dev->lock);
-if (wakeup_needed) {
+if (dev->read_ring.in != dev->read_ring.out) {
   sim_debug(dev->dbit, dev->dptr, "Queueing automatic poll\n");
   sim_activate_abs (dev->dptr->units, dev->asynch_io_latency);
   }
@@ -2162,7 +2616,22 @@ else { /* !tap: */
 #endif /* defined(HAVE_SLIRP_NETWORK) */
       }
     else { /* not nat: */
-      if (0 == strncmp("udp:", savname, 4)) {
+      if (0 == strncmp("pkt:", savname, 4)) {
+#if defined(HAVE_PACKET_NETWORK)
+        const char *devname = savname + 4;
+
+        while (isspace(*devname))
+          ++devname;
+        if (SCPE_OK == _eth_pkt_open (devname, handle, fd_handle, errbuf)) {
+          *eth_api = ETH_API_PKT;
+          if (bpf_filter)     /* ReOpen?  Restore the kernel filter */
+            _eth_pkt_filter ((ETH_DEV *)opaque, (struct eth_pkt *)*handle);
+          }
+#else
+        strlcpy(errbuf, "No support for pkt: network devices", PCAP_ERRBUF_SIZE);
+#endif /* defined(HAVE_PACKET_NETWORK) */
+        }
+      else if (0 == strncmp("udp:", savname, 4)) {
         char localport[CBUFSIZE], host[CBUFSIZE], port[CBUFSIZE];
         char hostport[2*CBUFSIZE];
         const char *devname = savname + 4;
@@ -2362,7 +2831,12 @@ dev->dbit = dbit;
 if (1) {
   pthread_attr_t attr;
 
-  ethq_init (&dev->read_queue, 200);         /* initialize FIFO queue */
+  if (SCPE_OK != _eth_ring_init (&dev->read_ring, 200)) {
+    _eth_close_port (dev->eth_api, (pcap_t *)dev->handle, dev->fd_handle);
+    free (dev->name);
+    eth_zero (dev);
+    return SCPE_MEM;
+    }
   pthread_mutex_init (&dev->lock, NULL);
   pthread_mutex_init (&dev->writer_lock, NULL);
   pthread_mutex_init (&dev->self_lock, NULL);
@@ -2415,6 +2889,11 @@ switch (eth_api) {
   case ETH_API_NAT:
     sim_slirp_close((SLIRP*)pcap);
     break;
+#endif
+#ifdef HAVE_PACKET_NETWORK
+  case ETH_API_PKT:
+    _eth_pkt_close((struct eth_pkt *)pcap);
+    break;
 #endif
   case ETH_API_UDP:
     sim_close_sock(pcap_fd);
@@ -2457,7 +2936,7 @@ if (1) {
     free(buffer);
     }
   }
-ethq_destroy (&dev->read_queue);         /* release FIFO queue */
+_eth_ring_destroy (&dev->read_ring);     /* release receive ring */
 #endif
 
 _eth_close_port (dev->eth_api, pcap, pcap_fd);
@@ -2505,6 +2984,9 @@ fprintf (st, "    eth2   vde:device{:switch-port-number}      (Integrated VDE su
 fprintf (st, "    eth3   nat:{optional-nat-parameters}        (Integrated NAT (SLiRP) support)\n");
 #endif
 fprintf (st, "    eth4   udp:sourceport:remotehost:remoteport (Integrated UDP bridge support)\n");
+#if defined(HAVE_PACKET_NETWORK)
+fprintf (st, "    eth5   pkt:ifname                           (Integrated AF_PACKET support)\n");
+#endif
 fprintf (st, "   sim> ATTACH %s eth0\n\n", dptr->name);
 fprintf (st, "or equivalently:\n\n");
 fprintf (st, "   sim> ATTACH %s en0\n\n", dptr->name);
@@ -2722,6 +3204,9 @@ switch (dev->eth_api) {
   case ETH_API_NAT:
       netname = "nat";
       break;
+  case ETH_API_PKT:
+      netname = "pkt";
+      break;
   }
 sprintf(msg, "%s(%s): ", where, netname);
 switch (dev->eth_api) {
@@ -2850,6 +3335,13 @@ if ((packet->len >= ETH_MIN_PACKET) && (packet->len <= ETH_MAX_PACKET)) {
       else
         status = 1;
       break;
+#endif
+#ifdef HAVE_PACKET_NETWORK
+    case ETH_API_PKT:
+      /* The writer thread only kicks the kernel once its queue is empty */
+      status = _eth_pkt_send (dev, packet->msg, packet->len, 
+                              (!pthread_equal (pthread_self (), dev->writer_thread)) || (dev->write_requests == NULL));
+      break;
 #endif
     case ETH_API_UDP:
       status = (((int32)packet->len == sim_write_sock (dev->fd_handle, (char *)packet->msg, (int32)packet->len)) ? 0 : -1);
@@ -3471,6 +3963,7 @@ switch (dev->eth_api) {
   case ETH_API_VDE:
   case ETH_API_UDP:
   case ETH_API_NAT:
+  case ETH_API_PKT:
     bpf_used = 0;
     to_me = 0;
     eth_packet_trace (dev, data, header->len, "received");
@@ -3556,10 +4049,7 @@ if (bpf_used ? to_me : (to_me && !from_me)) {
 
     eth_packet_trace (dev, data, len, "rcvqd");
 
-    pthread_mutex_lock (&dev->lock);
-    ethq_insert_data(&dev->read_queue, ETH_ITM_NORMAL, data, 0, len, crc_len, crc_data, 0);
-    ++dev->packets_received;
-    pthread_mutex_unlock (&dev->lock);
+    _eth_ring_insert (dev, data, len, crc_len, crc_data);
     free(moved_data);
     }
 #else /* !USE_READER_THREAD */
@@ -3697,17 +4187,16 @@ if (status < 0) {
 
 #else /* USE_READER_THREAD */
 
+  ETH_ITEM* item = _eth_ring_remove (dev);
+
   status = 0;
-  pthread_mutex_lock (&dev->lock);
-  if (dev->read_queue.count > 0) {
-    ETH_ITEM* item = &dev->read_queue.item[dev->read_queue.head];
+  if (item) {
     packet->len = item->packet.len;
     packet->crc_len = item->packet.crc_len;
     memcpy(packet->msg, item->packet.msg, ((packet->len > packet->crc_len) ? packet->len : packet->crc_len));
     status = 1;
-    ethq_remove(&dev->read_queue);
+    _eth_ring_release (dev, item);
   }
-  pthread_mutex_unlock (&dev->lock);  
   if ((status) && (routine))
     routine(0);
 #endif
@@ -3715,6 +4204,38 @@ if (status < 0) {
 return status;
 }
 
+/* Take up to max received packets without copying them.  The packets
+   belong to the caller until each is handed back with eth_read_release. */
+
+int eth_read_batch (ETH_DEV* dev, ETH_PACK** packets, int max)
+{
+int count = 0;
+
+if ((!dev) || (dev->eth_api == ETH_API_NONE) || (!packets)) return 0;
+
+#if defined (USE_READER_THREAD)
+while (count < max) {
+  ETH_ITEM* item = _eth_ring_remove (dev);
+
+  if (!item)
+    break;
+  packets[count++] = &item->packet;
+  }
+#else
+if ((max > 0) && (eth_read (dev, &dev->poll_packet, NULL) > 0))
+  packets[count++] = &dev->poll_packet;
+#endif
+return count;
+}
+
+void eth_read_release (ETH_DEV* dev, ETH_PACK* packet)
+{
+#if defined (USE_READER_THREAD)
+if ((dev) && (packet) && (dev->read_ring.max))
+  _eth_ring_release (dev, (ETH_ITEM *)((char *)packet - offsetof (ETH_ITEM, packet)));
+#endif
+}
+
 t_stat eth_bpf_filter (ETH_DEV* dev, int addr_count, ETH_MAC* const filter_address,
                        ETH_BOOL all_multicast, ETH_BOOL promiscuous, 
                        int reflections,
@@ -3896,6 +4417,22 @@ eth_bpf_filter (dev, dev->addr_count, dev->filter_address,
                 dev->have_host_nic_phy_addr ? &dev->host_nic_phy_hw_addr: NULL,
                 (dev->hash_filter ? &dev->hash : NULL), buf);
 
+#if defined (HAVE_PACKET_NETWORK)
+if (dev->eth_api == ETH_API_PKT) {
+  if (SCPE_OK == _eth_pkt_filter (dev, (struct eth_pkt *)dev->handle)) {
+    /* Save BPF filter string (equivalent to the kernel filter) */
+    dev->bpf_filter = (char *)realloc(dev->bpf_filter, 1 + strlen(buf));
+    strcpy (dev->bpf_filter, buf);
+    }
+  if (1) {                         /* Empty receive ring when filter list changes */
+    ETH_ITEM* item;
+
+    while (NULL != (item = _eth_ring_remove (dev)))
+      _eth_ring_release (dev, item);
+    }
+  }
+#endif
+
 /* get netmask, which is a required argument for compiling.  The value, 
    in our case isn't actually interesting since the filters we generate 
    aren't referencing IP fields, networks or values */
@@ -3953,9 +4490,12 @@ if (dev->eth_api == ETH_API_PCAP) {
     pcap_freecode(&bpf);
     }
 #ifdef USE_READER_THREAD
-  pthread_mutex_lock (&dev->lock);
-  ethq_clear (&dev->read_queue); /* Empty FIFO Queue when filter list changes */
-  pthread_mutex_unlock (&dev->lock);
+  if (1) {                         /* Empty receive ring when filter list changes */
+    ETH_ITEM* item;
+
+    while (NULL != (item = _eth_ring_remove (dev)))
+      _eth_ring_release (dev, item);
+    }
 #endif
   }
 #endif /* USE_BPF */
@@ -4075,6 +4615,15 @@ if (used < max) {
   }
 #endif
 
+#ifdef HAVE_PACKET_NETWORK
+if (used < max) {
+  sprintf(list[used].name, "%s", "pkt:ifname");
+  sprintf(list[used].desc, "%s", "Integrated AF_PACKET support");
+  list[used].eth_api = ETH_API_PKT;
+  ++used;
+  }
+#endif
+
 if (used < max) {
   sprintf(list[used].name, "%s", "udp:sourceport:remotehost:remoteport");
   sprintf(list[used].desc, "%s", "Integrated UDP bridge support");
@@ -4169,9 +4718,12 @@ if (dev->asynch_io)
   fprintf(st, "  Interrupt Latency:       %d uSec\n", dev->asynch_io_latency);
 if (dev->throttle_count)
   fprintf(st, "  Throttle Delays:         %d\n", dev->throttle_count);
-fprintf(st, "  Read Queue: Count:       %d\n", dev->read_queue.count);
-fprintf(st, "  Read Queue: High:        %d\n", dev->read_queue.high);
-fprintf(st, "  Read Queue: Loss:        %d\n", dev->read_queue.loss);
+fprintf(st, "  Read Queue: Count:       %d\n", (int)(dev->read_ring.in - dev->read_ring.out));
+fprintf(st, "  Read Queue: High:        %d\n", dev->read_ring.high);
+fprintf(st, "  Read Queue: Loss:        %d\n", dev->read_ring.loss);
+if (dev->read_ring.out)
+  fprintf(st, "  Read Queue: Latency:     %d mSec average, %d mSec max\n", 
+                                          (int)(dev->read_ring.latency_total / dev->read_ring.out), dev->read_ring.latency_max);
 fprintf(st, "  Peak Write Queue Size:   %d\n", dev->write_queue_peak);
 #endif
 if (dev->bpf_filter)
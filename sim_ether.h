@@ -220,6 +220,7 @@ struct eth_item {
 #define ETH_ITM_LOOPBACK 1
 #define ETH_ITM_NORMAL   2
   struct eth_packet   packet;
+  uint32              time;                             /* msec time queued (receive ring) */
 };
 
 struct eth_queue {
@@ -232,6 +233,23 @@ struct eth_queue {
   struct eth_item*    item;
 };
 
+struct eth_ring {                                       /* single producer/single consumer receive ring */
+  int                 max;                              /* number of packet buffers */
+  struct eth_item*    pool;                             /* packet buffers */
+  struct eth_item* volatile* rcvd;                      /* received packets (reader -> simulator) */
+  struct eth_item* volatile* avail;                     /* empty buffers (simulator -> reader) */
+  int                 rcvd_put;                         /* reader thread: next rcvd slot */
+  int                 avail_get;                        /* reader thread: next avail slot */
+  int                 rcvd_get;                         /* simulator: next rcvd slot */
+  int                 avail_put;                        /* simulator: next avail slot */
+  volatile uint32     in;                               /* packets queued */
+  volatile uint32     out;                              /* packets dequeued */
+  uint32              high;                             /* highest queue depth */
+  uint32              loss;                             /* packets dropped with no free buffer */
+  t_uint64            latency_total;                    /* msec packets spent queued */
+  uint32              latency_max;                      /* longest msec a packet spent queued */
+};
+
 struct eth_list {
   char    name[ETH_DEV_NAME_MAX];
   char    desc[ETH_DEV_DESC_MAX];
@@ -246,6 +264,7 @@ typedef void (*ETH_PCALLBACK)(int status);
 typedef struct eth_list ETH_LIST;
 typedef struct eth_queue ETH_QUE;
 typedef struct eth_item ETH_ITEM;
+typedef struct eth_ring ETH_RING;
 struct eth_write_request {
   struct eth_write_request *next;
   ETH_PACK packet;
@@ -264,6 +283,7 @@ struct eth_device {
 #define ETH_API_VDE  3                                  /* VDE API in use */
 #define ETH_API_UDP  4                                  /* UDP API in use */
 #define ETH_API_NAT  5                                  /* NAT (SLiRP) API in use */
+#define ETH_API_PKT  6                                  /* Linux AF_PACKET API in use */
   ETH_PCALLBACK read_callback;                          /* read callback function */
   ETH_PCALLBACK write_callback;                         /* write callback function */
   ETH_PACK*     read_packet;                            /* read packet */
@@ -312,7 +332,7 @@ struct eth_device {
 #if defined (USE_READER_THREAD)
   int           asynch_io;                              /* Asynchronous Interrupt scheduling enabled */
   int           asynch_io_latency;                      /* instructions to delay pending interrupt */
-  ETH_QUE       read_queue;
+  ETH_RING      read_ring;                              /* received packets */
   pthread_mutex_t     lock;
   pthread_t     reader_thread;                          /* Reader Thread Id */
   pthread_t     writer_thread;                          /* Writer Thread Id */
@@ -323,6 +343,8 @@ struct eth_device {
   int write_queue_peak;
   ETH_WRITE_REQUEST *write_buffers;
   t_stat write_status;
+#else
+  ETH_PACK      poll_packet;                            /* eth_read_batch packet when polling */
 #endif
 };
 
@@ -338,6 +360,9 @@ t_stat eth_write  (ETH_DEV* dev, ETH_PACK* packet,      /* write sychronous pack
                    ETH_PCALLBACK routine);              /*  callback when done */
 int eth_read      (ETH_DEV* dev, ETH_PACK* packet,      /* read single packet; */
                    ETH_PCALLBACK routine);              /*  callback when done*/
+int eth_read_batch (ETH_DEV* dev, ETH_PACK** packets,   /* take up to max received packets */
+                    int max);                           /*  without copying them */
+void eth_read_release (ETH_DEV* dev, ETH_PACK* packet); /* return a packet from eth_read_batch */
 t_stat eth_filter (ETH_DEV* dev, int addr_count,        /* set filter on incoming packets */
                    ETH_MAC* const addresses,
                    ETH_BOOL all_multicast,
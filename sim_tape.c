@@ -137,11 +137,45 @@ static t_addr sim_tape_tpc_fnd (UNIT *uptr, t_addr *map);
 static void sim_tape_data_trace (UNIT *uptr, const uint8 *data, size_t len, const char* txt, int detail, uint32 reason);
 static t_stat tape_erase_fwd (UNIT *uptr, t_mtrlnt gap_size);
 static t_stat tape_erase_rev (UNIT *uptr, t_mtrlnt gap_size);
+struct tape_context;
+static void sim_tape_index_free (struct tape_context *ctx);
+static void sim_tape_index_add (struct tape_context *ctx, t_addr pos, t_mtrlnt bc, t_addr end);
+static t_bool sim_tape_index_find (UNIT *uptr, uint32 *obj);
+static uint32 sim_tape_index_tmk (struct tape_context *ctx, uint32 obj);
+static void sim_tape_index_trunc (UNIT *uptr, t_addr pos);
+static int sim_tape_wrseek (UNIT *uptr, t_addr pos);
+
+/* Record index for SIMH and E11 format tapes.
+
+   The attach time validation pass reads every object on the tape, so it
+   records the file position and leading marker of each record and tape mark
+   as it goes.  Spacing records or files and reading backwards can then move
+   directly to the target object instead of reading each marker in turn.  The
+   index only describes the gap-free prefix of the tape; it is truncated at
+   the write position whenever the tape is written or erased and extended
+   when records or tape marks are appended at its end.  Positions outside the
+   indexed region use the normal marker-by-marker code.
+*/
+
+typedef struct {
+    t_addr              pos;                /* file position of the leading marker */
+    t_mtrlnt            bc;                 /* leading marker (record length or MTR_TMK) */
+    } TAPE_INDEX;
 
 struct tape_context {
     DEVICE              *dptr;              /* Device for unit (access to debug flags) */
     uint32              dbit;               /* debugging bit for trace */
     uint32              auto_format;        /* Format determined dynamically */
+    TAPE_INDEX          *idx;               /* Record index objects */
+    uint32              idx_count;          /* Objects in the record index */
+    uint32              idx_size;           /* Allocated record index objects */
+    uint32              *idx_tmk;           /* Object numbers of indexed tape marks */
+    uint32              idx_tmks;           /* Tape marks in the record index */
+    uint32              idx_tmksize;        /* Allocated tape mark object numbers */
+    t_addr              idx_end;            /* File position after the last indexed object */
+    t_bool              idx_ready;          /* Record index may be used */
+    uint8               *stream_buf;        /* stdio buffer for the tape image */
+    t_bool              stream_wr;          /* stream last positioned for writing */
 #if defined SIM_ASYNCH_IO
     int                 asynch_io;          /* Asynchronous Interrupt scheduling enabled */
     int                 asynch_io_latency;  /* instructions to delay pending interrupt */
@@ -166,6 +200,15 @@ struct tape_context {
     };
 #define tape_ctx up8                        /* Field in Unit structure which points to the tape_context */
 
+/* File based tape images are given a large stdio buffer so that streaming
+   reads and writes move whole buffers to and from the host file.  Seeks to
+   the position the stream is already at are skipped, which keeps the
+   buffer (and any write-behind data) intact while a tape is read or
+   written sequentially.  Write-behind data is flushed when a tape mark is
+   written, when the tape is rewound and when the unit is detached. */
+
+#define TAPE_STREAM_BUFSIZE (256 * 1024)    /* stdio buffer size for tape images */
+
 #if defined SIM_ASYNCH_IO
 #define AIO_CALLSETUP                                                   \
 struct tape_context *ctx = (struct tape_context *)uptr->tape_ctx;       \
@@ -846,6 +889,11 @@ uptr->tape_ctx = ctx = (struct tape_context *)calloc(1, sizeof(struct tape_conte
 ctx->dptr = dptr;                                       /* save DEVICE pointer */
 ctx->dbit = dbit;                                       /* save debug bit */
 ctx->auto_format = auto_format;                         /* save that we auto selected format */
+if (MT_GET_FMT (uptr) < MTUF_F_ANSI) {                  /* file based image? */
+    ctx->stream_buf = (uint8 *)malloc (TAPE_STREAM_BUFSIZE);
+    if (ctx->stream_buf != NULL)                        /* stream through a large buffer */
+        setvbuf (uptr->fileref, (char *)ctx->stream_buf, _IOFBF, TAPE_STREAM_BUFSIZE);
+    }
 
 switch (MT_GET_FMT (uptr)) {                            /* case on format */
 
@@ -945,6 +993,10 @@ uptr->tape_eom = 0;
 uptr->pos = 0;
 MT_CLR_PNU (uptr);
 MT_CLR_INMRK (uptr);                                    /* Not within a TAR tapemark */
+if (uptr->tape_ctx) {
+    sim_tape_index_free ((struct tape_context *)uptr->tape_ctx);
+    free (((struct tape_context *)uptr->tape_ctx)->stream_buf);/* file is closed now */
+    }
 free (uptr->tape_ctx);
 uptr->tape_ctx = NULL;
 uptr->io_flush = NULL;
@@ -1019,11 +1071,48 @@ if (sim_deb && ((uptr->dctrl | ctx->dptr->dctrl) & reason))
     sim_data_trace(ctx->dptr, uptr, (detail ? data : NULL), "", len, txt, reason);
 }
 
+/* Position the tape image for reading.
+
+   The seek is skipped if the stream is already at the requested position
+   and was last used for reading, so sequential reads are satisfied from the
+   stream buffer.  A real seek is still done after a write (as stdio requires
+   between writing and reading) and after end-of-file, which the seek
+   clears.
+*/
+
 static int sim_tape_seek (UNIT *uptr, t_addr pos)
 {
-if (MT_GET_FMT (uptr) < MTUF_F_ANSI)
-    return sim_fseek (uptr->fileref, pos, SEEK_SET);
-return 0;
+struct tape_context *ctx = (struct tape_context *)uptr->tape_ctx;
+
+if (MT_GET_FMT (uptr) >= MTUF_F_ANSI)
+    return 0;
+if (ctx != NULL) {
+    if ((!ctx->stream_wr) && (!feof (uptr->fileref)) &&
+        (sim_ftell (uptr->fileref) == (t_offset)pos))
+        return 0;                                       /* already there */
+    ctx->stream_wr = FALSE;
+    }
+return sim_fseek (uptr->fileref, pos, SEEK_SET);
+}
+
+/* Position the tape image for writing.
+
+   As above, but consecutive writes at the stream position are left to
+   accumulate in the stream buffer.
+*/
+
+static int sim_tape_wrseek (UNIT *uptr, t_addr pos)
+{
+struct tape_context *ctx = (struct tape_context *)uptr->tape_ctx;
+
+if (MT_GET_FMT (uptr) >= MTUF_F_ANSI)
+    return 0;
+if (ctx != NULL) {
+    if (ctx->stream_wr && (sim_ftell (uptr->fileref) == (t_offset)pos))
+        return 0;                                       /* already there */
+    ctx->stream_wr = TRUE;
+    }
+return sim_fseek (uptr->fileref, pos, SEEK_SET);
 }
 
 static t_offset sim_tape_size (UNIT *uptr)
@@ -1509,6 +1598,7 @@ t_awshdr awshdr;
 size_t   rdcnt;
 t_mtrlnt buffer [256];                                  /* local tape buffer */
 uint32   bufcntr, bufcap;                               /* buffer counter and capacity */
+uint32   obj;                                           /* record index object number */
 int32    runaway_counter, sizeof_gap;                   /* bytes remaining before runaway and bytes per gap */
 t_stat   status = MTSE_OK;
 
@@ -1525,6 +1615,19 @@ switch (f) {                                            /* otherwise the read me
 
     case MTUF_F_STD:
     case MTUF_F_E11:
+        if (sim_tape_index_find (uptr, &obj) && (obj > 0)) {/* if the preceding object is indexed */
+            TAPE_INDEX *ip = &((struct tape_context *)uptr->tape_ctx)->idx[obj - 1];
+
+            *bc = ip->bc;                               /* then return its marker */
+            uptr->pos = ip->pos;                        /*   and backspace over it */
+            if (*bc == MTR_TMK)                         /* if the marker is a tape mark */
+                status = MTSE_TMK;                      /*   then return tape mark status */
+            else if (sim_tape_seek (uptr,               /* otherwise seek to the start of the data area */
+                                    uptr->pos + sizeof (t_mtrlnt)))
+                status = sim_tape_ioerr (uptr);         /*   and report an I/O error if it fails */
+            break;
+            }
+
         runaway_counter = 25 * 12 * bpi [MT_DENS (uptr->dynflags)]; /* set the largest legal gap size in bytes */
 
         if (runaway_counter == 0) {                     /* if tape density has not been not set */
@@ -1973,7 +2076,7 @@ if (sim_tape_wrp (uptr))                                /* write prot? */
     return MTSE_WRP;
 if (sbc == 0)                                           /* nothing to do? */
     return MTSE_OK;
-if (sim_tape_seek (uptr, uptr->pos))                    /* set pos */
+if (sim_tape_wrseek (uptr, uptr->pos))                  /* set pos */
     return MTSE_IOERR;
 switch (f) {                                            /* case on format */
 
@@ -1981,6 +2084,7 @@ switch (f) {                                            /* case on format */
         sbc = MTR_L ((bc + 1) & ~1);                    /* pad odd length */
         /* fall through into the E11 handler */
     case MTUF_F_E11:                                    /* E11 */
+        sim_tape_index_trunc (uptr, uptr->pos);         /* index is stale from here on */
         (void)sim_fwrite (&bc, sizeof (t_mtrlnt), 1, uptr->fileref);
         (void)sim_fwrite (buf, sizeof (uint8), sbc, uptr->fileref);
         (void)sim_fwrite (&bc, sizeof (t_mtrlnt), 1, uptr->fileref);
@@ -1988,6 +2092,8 @@ switch (f) {                                            /* case on format */
             MT_SET_PNU (uptr);
             return sim_tape_ioerr (uptr);
             }
+        sim_tape_index_add (ctx, uptr->pos, bc,         /* extend index if appending */
+                            uptr->pos + sbc + (2 * sizeof (t_mtrlnt)));
         uptr->pos = uptr->pos + sbc + (2 * sizeof (t_mtrlnt));  /* move tape */
         break;
 
@@ -2044,7 +2150,7 @@ if ((!sim_tape_bot (uptr)) &&
     MT_SET_PNU (uptr);                      /* pos not upd */
     return MTSE_INVRL;
     }
-if (sim_tape_seek (uptr, uptr->pos))        /* set pos */
+if (sim_tape_wrseek (uptr, uptr->pos))      /* set pos */
     return MTSE_IOERR;
 replacing_record = (awshdr.nxtlen == (t_awslnt)bc) && (awshdr.rectyp == (bc ? AWS_REC : AWS_TMK));
 awshdr.nxtlen = (t_awslnt)bc;
@@ -2079,7 +2185,7 @@ if (ctx == NULL)                                        /* if not properly attac
     return sim_messagef (SCPE_IERR, "Bad Attach\n");    /*   that's a problem */
 if (sim_tape_wrp (uptr))                                /* write prot? */
     return MTSE_WRP;
-(void)sim_tape_seek (uptr, uptr->pos);                  /* set pos */
+(void)sim_tape_wrseek (uptr, uptr->pos);                /* set pos */
 (void)sim_fwrite (&dat, sizeof (t_mtrlnt), 1, uptr->fileref);
 if (ferror (uptr->fileref)) {                           /* error? */
     MT_SET_PNU (uptr);
@@ -2097,17 +2203,25 @@ return MTSE_OK;
 t_stat sim_tape_wrtmk (UNIT *uptr)
 {
 struct tape_context *ctx = (struct tape_context *)uptr->tape_ctx;
+t_stat r;
 
 if (ctx == NULL)                                        /* if not properly attached? */
     return sim_messagef (SCPE_IERR, "Bad Attach\n");    /*   that's a problem */
 sim_debug_unit (ctx->dbit, uptr, "sim_tape_wrtmk(unit=%d)\n", (int)(uptr-ctx->dptr->units));
 if (MT_GET_FMT (uptr) == MTUF_F_P7B) {                  /* P7B? */
     uint8 buf = P7B_EOF;                                /* eof mark */
-    return sim_tape_wrrecf (uptr, &buf, 1);             /* write char */
+    r = sim_tape_wrrecf (uptr, &buf, 1);                /* write char */
+    fflush (uptr->fileref);                             /* write out buffered data */
+    return r;
     }
 if (MT_GET_FMT (uptr) == MTUF_F_AWS)                    /* AWS? */
-    return sim_tape_aws_wrdata (uptr, NULL, 0);
-return sim_tape_wrdata (uptr, MTR_TMK);
+    return sim_tape_aws_wrdata (uptr, NULL, 0);         /* (trailer stays buffered for a following EOM) */
+sim_tape_index_trunc (uptr, uptr->pos);                 /* index is stale from here on */
+r = sim_tape_wrdata (uptr, MTR_TMK);
+if (r == MTSE_OK)                                       /* extend index if appending */
+    sim_tape_index_add (ctx, uptr->pos - sizeof (t_mtrlnt), MTR_TMK, uptr->pos);
+fflush (uptr->fileref);                                 /* write out buffered data */
+return r;
 }
 
 t_stat sim_tape_wrtmk_a (UNIT *uptr, TAPE_PCALLBACK callback)
@@ -2138,6 +2252,7 @@ if (MT_GET_FMT (uptr) == MTUF_F_AWS) {
     result = MTSE_OK;
     }
 else {
+    sim_tape_index_trunc (uptr, uptr->pos);             /* index ends here */
     result = sim_tape_wrdata (uptr, MTR_EOM);           /* write the EOM marker */
     uptr->pos = uptr->pos - sizeof (t_mtrlnt);              /* restore original tape position */
     }
@@ -2301,6 +2416,8 @@ else if (gap_size == 0 || format != MTUF_F_STD)         /* otherwise if zero len
 
 file_size = sim_fsize (uptr->fileref);                  /* get the file size */
 
+sim_tape_index_trunc (uptr, gap_pos);                   /* index is stale from the gap on */
+
 if (sim_tape_seek (uptr, uptr->pos)) {                  /* position the tape; if it fails */
     MT_SET_PNU (uptr);                                  /*   then set position not updated */
     return sim_tape_ioerr (uptr);                       /*     and quit with I/O error status */
@@ -2501,6 +2618,9 @@ else if ((gap_size == 0) || (format != MTUF_F_STD))     /* otherwise if the gap
 
 gap_pos = uptr->pos;                                    /* save the starting position */
 
+sim_tape_index_trunc (uptr, (gap_pos > gap_size) ?      /* index is stale from the */
+                              gap_pos - gap_size : 0);  /*   earliest erased position on */
+
 if (gap_size == meta_size) {                            /* if the request is for a single metadatum */
     if (sim_tape_bot (uptr))                            /*   then if the unit is positioned at the BOT */
         return MTSE_BOT;                                /*     then erasing backward is not possible */
@@ -2516,7 +2636,7 @@ if (gap_size == meta_size) {                            /* if the request is for
         return sim_tape_ioerr (uptr);                       /*   then report the error and quit */
 
     else if (metadatum == MTR_TMK)                          /* otherwise if a tape mark is present */
-        if (sim_tape_seek (uptr, uptr->pos))                /*   then reposition the tape; if it fails */
+        if (sim_tape_wrseek (uptr, uptr->pos))              /*   then reposition the tape; if it fails */
             return sim_tape_ioerr (uptr);                   /*     then quit with I/O error status */
 
         else {                                              /*   otherwise */
@@ -2733,12 +2853,24 @@ t_stat sim_tape_sprecsf (UNIT *uptr, uint32 count, uint32 *skipped)
 struct tape_context *ctx = (struct tape_context *)uptr->tape_ctx;
 t_stat st;
 t_mtrlnt tbc;
+uint32 obj, tmk, k;
 
 if (ctx == NULL)                                        /* if not properly attached? */
     return sim_messagef (SCPE_IERR, "Bad Attach\n");    /*   that's a problem */
 sim_debug_unit (ctx->dbit, uptr, "sim_tape_sprecsf(unit=%d, count=%d)\n", (int)(uptr-ctx->dptr->units), count);
 
 *skipped = 0;
+if (sim_tape_index_find (uptr, &obj)) {                 /* position indexed? */
+    tmk = sim_tape_index_tmk (ctx, obj);                /* find next tape mark */
+    k = ((tmk < ctx->idx_tmks) ? ctx->idx_tmk[tmk] : ctx->idx_count) - obj;/* records before it */
+    if (k > count)
+        k = count;
+    if (k > 0) {                                        /* skip them directly */
+        MT_CLR_PNU (uptr);
+        uptr->pos = (obj + k < ctx->idx_count) ? ctx->idx[obj + k].pos : ctx->idx_end;
+        *skipped = k;
+        }
+    }
 while (*skipped < count) {                              /* loopo */
     st = sim_tape_sprecf (uptr, &tbc);                  /* spc rec */
     if (st != MTSE_OK)
@@ -2829,12 +2961,25 @@ t_stat sim_tape_sprecsr (UNIT *uptr, uint32 count, uint32 *skipped)
 struct tape_context *ctx = (struct tape_context *)uptr->tape_ctx;
 t_stat st;
 t_mtrlnt tbc;
+uint32 obj, tmk, k;
 
 if (ctx == NULL)                                        /* if not properly attached? */
     return sim_messagef (SCPE_IERR, "Bad Attach\n");    /*   that's a problem */
 sim_debug_unit (ctx->dbit, uptr, "sim_tape_sprecsr(unit=%d, count=%d)\n", (int)(uptr-ctx->dptr->units), count);
 
 *skipped = 0;
+if (!MT_TST_PNU (uptr) &&                               /* position updated */
+    sim_tape_index_find (uptr, &obj)) {                 /*   and indexed? */
+    tmk = sim_tape_index_tmk (ctx, obj);                /* find preceding tape mark */
+    tmk = (tmk > 0) ? ctx->idx_tmk[tmk - 1] + 1 : 0;    /* first record after it */
+    k = obj - tmk;                                      /* records back to it */
+    if (k > count)
+        k = count;
+    if (k > 0) {                                        /* skip them directly */
+        uptr->pos = ctx->idx[obj - k].pos;
+        *skipped = k;
+        }
+    }
 while (*skipped < count) {                              /* loopo */
     st = sim_tape_sprecr (uptr, &tbc);                  /* spc rec rev */
     if (st != MTSE_OK)
@@ -3078,6 +3223,8 @@ if (uptr->flags & UNIT_ATT) {
     }
 uptr->pos = 0;
 if (uptr->flags & UNIT_ATT) {
+    if (MT_GET_FMT (uptr) < MTUF_F_ANSI)
+        fflush (uptr->fileref);                         /* write out buffered data */
     (void)sim_tape_seek (uptr, uptr->pos);
     }
 MT_CLR_PNU (uptr);
@@ -3396,9 +3543,16 @@ t_addr pos_r;
 t_addr pos_fa;
 t_addr pos_sa;
 t_mtrlnt max = MTR_MAXLEN;
+struct tape_context *ctx = (struct tape_context *)uptr->tape_ctx;
+t_bool indexing = FALSE;
 
 if (!(uptr->flags & UNIT_ATT))
     return SCPE_UNATT;
+if ((ctx != NULL) &&                                    /* build record index while scanning */
+    ((MT_GET_FMT (uptr) == MTUF_F_STD) || (MT_GET_FMT (uptr) == MTUF_F_E11))) {
+    sim_tape_index_free (ctx);
+    ctx->idx_ready = indexing = TRUE;
+    }
 buf_f = (uint8 *)calloc (1, max);
 if (buf_f == NULL)
     return SCPE_MEM;
@@ -3482,6 +3636,11 @@ while (r == SCPE_OK) {
             sim_printf ("Unexpected tape file position after forward and skip record: (%" T_ADDR_FMT "u, %" T_ADDR_FMT "u)\n", pos_fa, pos_sa);
             break;
             }
+        if (indexing) {
+            indexing = (pos_f == pos_r);                /* index stops at the first gap */
+            if (indexing)
+                sim_tape_index_add (ctx, pos_f, (r_f == MTSE_TMK) ? MTR_TMK : bc_f, pos_fa);
+            }
         r = SCPE_OK;
         break;
     case MTSE_INVRL:                                /* invalid rec lnt */
@@ -3536,6 +3695,131 @@ uptr->pos = saved_pos;
 return SCPE_OK;
 }
 
+/* Release the record index */
+
+static void sim_tape_index_free (struct tape_context *ctx)
+{
+free (ctx->idx);
+free (ctx->idx_tmk);
+ctx->idx = NULL;
+ctx->idx_tmk = NULL;
+ctx->idx_count = ctx->idx_size = 0;
+ctx->idx_tmks = ctx->idx_tmksize = 0;
+ctx->idx_end = 0;
+ctx->idx_ready = FALSE;
+}
+
+/* Append an object to the record index
+
+   The object is only recorded if it immediately follows the last indexed
+   object, so writes beyond the indexed region leave the index unchanged.
+*/
+
+static void sim_tape_index_add (struct tape_context *ctx, t_addr pos, t_mtrlnt bc, t_addr end)
+{
+if ((!ctx->idx_ready) || (pos != ctx->idx_end))
+    return;
+if (ctx->idx_count == ctx->idx_size) {                  /* grow object table */
+    uint32 size = (ctx->idx_size) ? 2 * ctx->idx_size : 1024;
+    TAPE_INDEX *idx = (TAPE_INDEX *)realloc (ctx->idx, size * sizeof (*idx));
+
+    if (idx == NULL) {                                  /* no memory? */
+        sim_tape_index_free (ctx);                      /* do without the index */
+        return;
+        }
+    ctx->idx = idx;
+    ctx->idx_size = size;
+    }
+if ((bc == MTR_TMK) && (ctx->idx_tmks == ctx->idx_tmksize)) {/* grow tape mark table */
+    uint32 size = (ctx->idx_tmksize) ? 2 * ctx->idx_tmksize : 64;
+    uint32 *tmk = (uint32 *)realloc (ctx->idx_tmk, size * sizeof (*tmk));
+
+    if (tmk == NULL) {
+        sim_tape_index_free (ctx);
+        return;
+        }
+    ctx->idx_tmk = tmk;
+    ctx->idx_tmksize = size;
+    }
+if (bc == MTR_TMK)
+    ctx->idx_tmk[ctx->idx_tmks++] = ctx->idx_count;
+ctx->idx[ctx->idx_count].pos = pos;
+ctx->idx[ctx->idx_count].bc = bc;
+ctx->idx_count++;
+ctx->idx_end = end;
+}
+
+/* Look up the current tape position in the record index
+
+   Returns TRUE with the number of the object starting at the current position
+   (or the object count if positioned at the end of the indexed region).
+*/
+
+static t_bool sim_tape_index_find (UNIT *uptr, uint32 *obj)
+{
+struct tape_context *ctx = (struct tape_context *)uptr->tape_ctx;
+uint32 lo, hi, p;
+
+if ((ctx == NULL) || (!ctx->idx_ready))
+    return FALSE;
+if (uptr->pos == ctx->idx_end) {
+    *obj = ctx->idx_count;
+    return TRUE;
+    }
+lo = 0;
+hi = ctx->idx_count;
+while (lo < hi) {                                       /* binary search */
+    p = (lo + hi) >> 1;
+    if (ctx->idx[p].pos < uptr->pos)
+        lo = p + 1;
+    else
+        hi = p;
+    }
+if ((lo == ctx->idx_count) || (ctx->idx[lo].pos != uptr->pos))
+    return FALSE;
+*obj = lo;
+return TRUE;
+}
+
+/* Return the number of indexed tape marks preceding an object */
+
+static uint32 sim_tape_index_tmk (struct tape_context *ctx, uint32 obj)
+{
+uint32 lo = 0, hi = ctx->idx_tmks, p;
+
+while (lo < hi) {                                       /* binary search */
+    p = (lo + hi) >> 1;
+    if (ctx->idx_tmk[p] < obj)
+        lo = p + 1;
+    else
+        hi = p;
+    }
+return lo;
+}
+
+/* Discard index entries for objects at or beyond a file position */
+
+static void sim_tape_index_trunc (UNIT *uptr, t_addr pos)
+{
+struct tape_context *ctx = (struct tape_context *)uptr->tape_ctx;
+uint32 lo, hi, p;
+
+if ((ctx == NULL) || (!ctx->idx_ready) || (pos >= ctx->idx_end))
+    return;
+lo = 0;
+hi = ctx->idx_count;
+while (lo < hi) {                                       /* find first object */
+    p = (lo + hi) >> 1;                                 /*   ending after pos */
+    if (((p + 1 < ctx->idx_count) ? ctx->idx[p + 1].pos : ctx->idx_end) <= pos)
+        lo = p + 1;
+    else
+        hi = p;
+    }
+ctx->idx_count = lo;
+ctx->idx_end = ctx->idx[lo].pos;
+ctx->idx_tmks = sim_tape_index_tmk (ctx, lo);
+}
+
 /* Find the preceding record in a TPC file */
 
 static t_addr sim_tape_tpc_fnd (UNIT *uptr, t_addr *map)
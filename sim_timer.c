@@ -1130,6 +1130,16 @@ for (tmr=0; tmr<=SIM_NTIMERS; tmr++) {
     rtc->timer_unit = &sim_timer_units[tmr];
     rtc->timer_unit->action = &sim_timer_tick_svc;
     rtc->timer_unit->flags = UNIT_DIS | UNIT_IDLE;
+    /* Units coscheduled by a reset before a re-initialization are */
+    /* dropped, so that they aren't left looking active forever */
+    while ((rtc->clock_cosched_queue != NULL) &&
+           (rtc->clock_cosched_queue != QUEUE_LIST_END)) {
+        UNIT *uptr = rtc->clock_cosched_queue;
+
+        rtc->clock_cosched_queue = uptr->next;
+        uptr->next = NULL;
+        uptr->cancel = NULL;
+        }
     rtc->clock_cosched_queue = QUEUE_LIST_END;
     }
 sim_stop_unit.action = &sim_timer_stop_svc;
@@ -448,6 +448,356 @@ static u_char mantra[] = {                  /* Telnet Option Negotiation Mantra
 
 static void tmxr_add_to_open_list (TMXR* mux);
 
+/* Line readiness tracking
+
+   A multiplexer with hundreds of lines would otherwise issue a read on
+   every connected socket each time tmxr_poll_rx runs, and visit every
+   line each time tmxr_poll_tx runs, even though only a handful of lines
+   are active at any moment.  Each mux instead keeps its line sockets
+   registered in an epoll set (Linux) or a poll() descriptor list, so
+   that one system call reports which lines have input and only those
+   lines are read.  Serial and loopback lines are read on every poll, as
+   are all lines on hosts without poll().  Lines which have output
+   buffered or transmit disabled are kept on a transmit list which
+   tmxr_poll_tx walks instead of the whole line array.
+
+   A socket is removed from the set before tmxr_reset_ln_ex closes it,
+   and anything which changes a line's connection marks the tracking
+   state stale so that the next poll rescans all the lines once.  The
+   lines holding unread input after tmxr_poll_rx are available to the
+   device from tmxr_rx_ready_lines.
+*/
+
+#if !defined(_WIN32) && !defined(VMS)
+#define TMXR_READY_SOCKETS
+#include <poll.h>
+#if defined(__linux__)
+#define TMXR_READY_EPOLL
+#include <sys/epoll.h>
+#endif
+#endif
+
+#define TMXR_RDY_VISIT  0x01                            /* line on this poll's read list */
+#define TMXR_RDY_RX     0x02                            /* line on the pending input list */
+#define TMXR_RDY_TX     0x04                            /* line on the transmit list */
+
+#define TMXR_RDY_SOCK(lp) (((lp)->serport || (lp)->loopback) ? 0 : (lp)->sock)
+
+struct tmxr_ready {
+    int32               lines;                          /* line count when allocated */
+    t_bool              stale;                          /* rescan lines before next poll */
+    uint8               *flags;                         /* per line TMXR_RDY_xxx flags */
+    int32               *visit;                         /* lines to read this poll */
+    int32               nvisit;
+    int32               *rx;                            /* lines with unread input */
+    int32               nrx;
+    int32               *tx;                            /* lines with output activity */
+    int32               ntx;
+    int32               *always;                        /* lines read on every poll */
+    int32               nalways;
+#if defined(TMXR_READY_SOCKETS)
+    SOCKET              *sock;                          /* socket registered for each line */
+    struct pollfd       *pfd;                           /* poll() descriptor list */
+    int32               *pfdln;                         /* line owning each pfd entry */
+    int32               npfd;
+#if defined(TMXR_READY_EPOLL)
+    int                 epfd;                           /* epoll descriptor (-1 if unavailable) */
+    struct epoll_event  *events;                        /* epoll_wait results */
+#endif
+#endif
+    };
+
+static void tmxr_ready_free (TMXR *mp)
+{
+struct tmxr_ready *rd = mp->ready;
+
+if (rd == NULL)
+    return;
+mp->ready = NULL;
+#if defined(TMXR_READY_SOCKETS)
+#if defined(TMXR_READY_EPOLL)
+if (rd->epfd >= 0)
+    close (rd->epfd);
+free (rd->events);
+#endif
+free (rd->sock);
+free (rd->pfd);
+free (rd->pfdln);
+#endif
+free (rd->flags);
+free (rd->visit);
+free (rd->rx);
+free (rd->tx);
+free (rd->always);
+free (rd);
+}
+
+/* Return the mux's tracking state, allocating it on first use.  NULL
+   means the caller should fall back to visiting every line. */
+
+static struct tmxr_ready *tmxr_ready_get (TMXR *mp)
+{
+struct tmxr_ready *rd = mp->ready;
+
+if (rd && (rd->lines == mp->lines))
+    return rd;
+tmxr_ready_free (mp);                                   /* line count changed */
+if (mp->lines <= 0)
+    return NULL;
+rd = (struct tmxr_ready *)calloc (1, sizeof (*rd));
+if (rd == NULL)
+    return NULL;
+mp->ready = rd;
+rd->lines = mp->lines;
+rd->stale = TRUE;
+rd->flags = (uint8 *)calloc (mp->lines, sizeof (*rd->flags));
+rd->visit = (int32 *)calloc (mp->lines, sizeof (*rd->visit));
+rd->rx = (int32 *)calloc (mp->lines, sizeof (*rd->rx));
+rd->tx = (int32 *)calloc (mp->lines, sizeof (*rd->tx));
+rd->always = (int32 *)calloc (mp->lines, sizeof (*rd->always));
+#if defined(TMXR_READY_SOCKETS)
+rd->sock = (SOCKET *)calloc (mp->lines, sizeof (*rd->sock));
+rd->pfd = (struct pollfd *)calloc (mp->lines, sizeof (*rd->pfd));
+rd->pfdln = (int32 *)calloc (mp->lines, sizeof (*rd->pfdln));
+#if defined(TMXR_READY_EPOLL)
+rd->epfd = epoll_create (mp->lines);                    /* fall back to poll() on failure */
+rd->events = (struct epoll_event *)calloc (mp->lines, sizeof (*rd->events));
+if (rd->events == NULL) {
+    tmxr_ready_free (mp);
+    return NULL;
+    }
+#endif
+if ((rd->sock == NULL) || (rd->pfd == NULL) || (rd->pfdln == NULL)) {
+    tmxr_ready_free (mp);
+    return NULL;
+    }
+#endif
+if ((rd->flags == NULL) || (rd->visit == NULL) || (rd->rx == NULL) ||
+    (rd->tx == NULL) || (rd->always == NULL)) {
+    tmxr_ready_free (mp);
+    return NULL;
+    }
+return rd;
+}
+
+/* Note a change to a line's connection */
+
+static void tmxr_ready_stale (TMLN *lp)
+{
+if (lp->mp && lp->mp->ready)
+    lp->mp->ready->stale = TRUE;
+}
+
+/* Remove a line's socket from the readiness set before it is closed, so
+   that a socket which reuses the descriptor can't inherit its registration */
+
+static void tmxr_ready_release (TMLN *lp)
+{
+#if defined(TMXR_READY_SOCKETS)
+struct tmxr_ready *rd = lp->mp ? lp->mp->ready : NULL;
+int32 ln;
+
+if (rd == NULL)
+    return;
+rd->stale = TRUE;
+ln = (int32)(lp - lp->mp->ldsc);
+if ((ln < 0) || (ln >= rd->lines) || (rd->sock[ln] == 0))
+    return;
+#if defined(TMXR_READY_EPOLL)
+if (rd->epfd >= 0) {
+    struct epoll_event ev;                              /* pre 2.6.9 kernels require an event */
+
+    memset (&ev, 0, sizeof (ev));
+    epoll_ctl (rd->epfd, EPOLL_CTL_DEL, rd->sock[ln], &ev);
+    }
+#endif
+rd->sock[ln] = 0;
+#else
+tmxr_ready_stale (lp);
+#endif
+}
+
+static void tmxr_ready_list (struct tmxr_ready *rd, int32 ln, uint8 flag)
+{
+if (rd->flags[ln] & flag)                               /* already listed? */
+    return;
+rd->flags[ln] |= flag;
+switch (flag) {
+    case TMXR_RDY_VISIT:
+        rd->visit[rd->nvisit++] = ln;
+        break;
+    case TMXR_RDY_RX:
+        rd->rx[rd->nrx++] = ln;
+        break;
+    case TMXR_RDY_TX:
+        rd->tx[rd->ntx++] = ln;
+        break;
+    }
+}
+
+/* Note output activity on a line so that tmxr_poll_tx will visit it */
+
+static void tmxr_ready_tx (TMLN *lp)
+{
+struct tmxr_ready *rd = lp->mp ? lp->mp->ready : NULL;
+int32 ln;
+
+if (rd == NULL)
+    return;
+ln = (int32)(lp - lp->mp->ldsc);
+if ((ln >= 0) && (ln < rd->lines))
+    tmxr_ready_list (rd, ln, TMXR_RDY_TX);
+}
+
+#if defined(TMXR_READY_SOCKETS)
+/* Register a line's socket, returning FALSE if it can't be watched */
+
+static t_bool tmxr_ready_watch (struct tmxr_ready *rd, int32 ln, SOCKET sock)
+{
+#if defined(TMXR_READY_EPOLL)
+if ((rd->epfd >= 0) && (rd->sock[ln] != sock)) {
+    struct epoll_event ev;
+
+    memset (&ev, 0, sizeof (ev));
+    ev.events = EPOLLIN;                                /* level triggered */
+    ev.data.u32 = (uint32)ln;
+    if ((epoll_ctl (rd->epfd, EPOLL_CTL_ADD, sock, &ev)) &&
+        ((errno != EEXIST) ||
+         (epoll_ctl (rd->epfd, EPOLL_CTL_MOD, sock, &ev))))
+        return FALSE;
+    }
+#endif
+rd->sock[ln] = sock;
+return TRUE;
+}
+#endif
+
+/* Rebuild the registrations and lists from the current line state */
+
+static void tmxr_ready_rescan (TMXR *mp, struct tmxr_ready *rd)
+{
+int32 i;
+TMLN *lp;
+
+rd->nalways = 0;
+#if defined(TMXR_READY_SOCKETS)
+rd->npfd = 0;
+for (i = 0; i < mp->lines; i++) {                       /* drop outdated registrations first */
+    lp = mp->ldsc + i;
+    if (rd->sock[i] && (rd->sock[i] != TMXR_RDY_SOCK (lp))) {
+#if defined(TMXR_READY_EPOLL)
+        if (rd->epfd >= 0) {
+            struct epoll_event ev;
+
+            memset (&ev, 0, sizeof (ev));
+            epoll_ctl (rd->epfd, EPOLL_CTL_DEL, rd->sock[i], &ev);
+            }
+#endif
+        rd->sock[i] = 0;
+        }
+    }
+#endif
+for (i = 0; i < mp->lines; i++) {
+    lp = mp->ldsc + i;
+#if defined(TMXR_READY_SOCKETS)
+    if (TMXR_RDY_SOCK (lp) && tmxr_ready_watch (rd, i, lp->sock)) {
+        rd->pfd[rd->npfd].fd = lp->sock;
+        rd->pfd[rd->npfd].events = POLLIN;
+        rd->pfdln[rd->npfd++] = i;
+        }
+    else
+        if (lp->sock || lp->serport || lp->loopback)
+            rd->always[rd->nalways++] = i;              /* can't watch it, so always read it */
+#else
+    rd->always[rd->nalways++] = i;
+#endif
+    if ((lp->rxbpi != lp->rxbpr) ||                     /* unread input? */
+        (lp->send.extoff < lp->send.insoff))
+        tmxr_ready_list (rd, i, TMXR_RDY_RX);
+    if ((lp->conn || lp->txbfd) &&                      /* output pending or transmit disabled? */
+        (tmxr_tqln (lp) || tmxr_tpqln (lp) || !lp->xmte))
+        tmxr_ready_list (rd, i, TMXR_RDY_TX);
+    }
+rd->stale = FALSE;
+}
+
+/* Build the list of lines which tmxr_poll_rx should read */
+
+static void tmxr_ready_wait (TMXR *mp, struct tmxr_ready *rd)
+{
+int32 i;
+
+if (rd->stale)
+    tmxr_ready_rescan (mp, rd);
+rd->nvisit = 0;
+#if defined(TMXR_READY_SOCKETS)
+#if defined(TMXR_READY_EPOLL)
+if (rd->epfd >= 0) {
+    int n = epoll_wait (rd->epfd, rd->events, rd->lines, 0);
+
+    for (i = 0; i < n; i++)
+        tmxr_ready_list (rd, (int32)rd->events[i].data.u32, TMXR_RDY_VISIT);
+    }
+else
+#endif
+if (rd->npfd > 0) {
+    int n = poll (rd->pfd, (nfds_t)rd->npfd, 0);
+
+    for (i = 0; (n > 0) && (i < rd->npfd); i++)
+        if (rd->pfd[i].revents) {
+            tmxr_ready_list (rd, rd->pfdln[i], TMXR_RDY_VISIT);
+            --n;
+            }
+    }
+#endif
+for (i = 0; i < rd->nalways; i++)
+    tmxr_ready_list (rd, rd->always[i], TMXR_RDY_VISIT);
+}
+
+/* Fold the lines just read into the pending input list */
+
+static void tmxr_ready_rx_update (TMXR *mp, struct tmxr_ready *rd)
+{
+int32 i, j, ln;
+TMLN *lp;
+
+for (i = j = 0; i < rd->nrx; i++) {                     /* drop drained lines */
+    ln = rd->rx[i];
+    lp = mp->ldsc + ln;
+    if ((lp->rxbpi != lp->rxbpr) || (lp->send.extoff < lp->send.insoff))
+        rd->rx[j++] = ln;
+    else
+        rd->flags[ln] &= ~TMXR_RDY_RX;
+    }
+rd->nrx = j;
+for (i = 0; i < rd->nvisit; i++) {                      /* add lines which received input */
+    ln = rd->visit[i];
+    rd->flags[ln] &= ~TMXR_RDY_VISIT;
+    if (mp->ldsc[ln].rxbpi != mp->ldsc[ln].rxbpr)
+        tmxr_ready_list (rd, ln, TMXR_RDY_RX);
+    }
+rd->nvisit = 0;
+}
+
+/* Drop lines with nothing left to send from the transmit list */
+
+static void tmxr_ready_tx_update (TMXR *mp, struct tmxr_ready *rd)
+{
+int32 i, j, ln;
+TMLN *lp;
+
+for (i = j = 0; i < rd->ntx; i++) {
+    ln = rd->tx[i];
+    lp = mp->ldsc + ln;
+    if ((lp->conn || lp->txbfd) &&
+        (tmxr_tqln (lp) || tmxr_tpqln (lp) || !lp->xmte))
+        rd->tx[j++] = ln;
+    else
+        rd->flags[ln] &= ~TMXR_RDY_TX;
+    }
+rd->ntx = j;
+}
+
 /* Initialize the line state.
 
    Reset the line state to represent an idle line.  Note that we do not clear
@@ -461,6 +811,7 @@ static void tmxr_add_to_open_list (TMXR* mux);
 
 static void tmxr_init_line (TMLN *lp)
 {
+tmxr_ready_stale (lp);                                  /* line connection changing */
 lp->tsta = 0;                                           /* init telnet state */
 lp->xmte = 1;                                           /* enable transmit */
 lp->dstb = 0;                                           /* default bin mode */
@@ -741,22 +1092,26 @@ return written;
 }
 
 
-/* Remove a character from the read buffer.
+/* Find the run of received data which needs no Telnet processing.
 
-   The character at position "p" in the read buffer associated with line "lp" is
-   removed by moving all of the following received characters down one position.
-   The receive break status array is adjusted accordingly.
+   Returns the number of characters starting at position "p" in the read
+   buffer associated with line "lp", and ending before "end", which precede
+   the next IAC (or CR when not in binary mode).  These characters are kept
+   as they are, so they may be moved as a block.
 */
 
-static void tmxr_rmvrc (TMLN *lp, int32 p)
+static int32 tmxr_tn_span (const TMLN *lp, int32 p, int32 end)
 {
-for ( ; p < lp->rxbpi; p++) {                           /* work from "p" through end of buffer */
-    lp->rxb[p] = lp->rxb[p + 1];                        /* slide following character down */
-    lp->rbr[p] = lp->rbr[p + 1];                        /* adjust break status too */
+const char *start = &lp->rxb[p];
+const char *stop = (const char *)memchr (start, TN_IAC, end - p);
+int32 span = stop ? (int32)(stop - start) : end - p;
+
+if (lp->dstb && span) {                                 /* CR padding to check? */
+    stop = (const char *)memchr (start, TN_CR, span);
+    if (stop)
+        span = (int32)(stop - start);
     }
-
-lp->rbr[p] = 0;                                         /* clear potential break from vacated slot */
-lp->rxbpi = lp->rxbpi - 1;                              /* drop buffer insert index */
+return span;
 }
 
 
@@ -1191,6 +1546,7 @@ for (i = 0; i < mp->lines; i++) {                       /* check each line in se
                             lp->conn = TRUE;                    /* record connection */
                             lp->sock = lp->connecting;          /* it now looks normal */
                             lp->connecting = 0;
+                            tmxr_ready_stale (lp);              /* watch the new socket */
                             lp->ipad = (char *)realloc (lp->ipad, 1+strlen (lp->destination));
                             strcpy (lp->ipad, lp->destination);
                             lp->cnms = sim_os_msec ();
@@ -1315,6 +1671,8 @@ tmxr_send_buffered_data (lp);                           /* send any buffered dat
 sprintf (msg, "tmxr_reset_ln_ex(%s)", closeserial ? "TRUE" : "FALSE");
 tmxr_debug_connect_line (lp, msg);
 
+tmxr_ready_release (lp);                                /* stop watching the socket */
+
 if (lp->serport) {
     if (closeserial) {
         sim_close_serial (lp->serport);
@@ -1684,6 +2042,7 @@ t_stat tmxr_set_line_loopback (TMLN *lp, t_bool enable_loopback)
 if (lp->loopback == (enable_loopback != FALSE))
     return SCPE_OK;                 /* Nothing to do */
 lp->loopback = (enable_loopback != FALSE);
+tmxr_ready_stale (lp);
 if (lp->loopback) {
     lp->lpbsz = lp->rxbsz;
     lp->lpb = (char *)realloc(lp->lpb, lp->lpbsz);
@@ -1883,11 +2242,19 @@ return SCPE_LOST;
 
 void tmxr_poll_rx (TMXR *mp)
 {
-int32 i, nbytes, j;
+int32 i, k, nvisit, nbytes, j;
 TMLN *lp;
+struct tmxr_ready *rd = tmxr_ready_get (mp);
 
 tmxr_debug_trace (mp, "tmxr_poll_rx()");
-for (i = 0; i < mp->lines; i++) {                       /* loop thru lines */
+if (rd) {
+    tmxr_ready_wait (mp, rd);                           /* find lines with input */
+    nvisit = rd->nvisit;
+    }
+else
+    nvisit = mp->lines;
+for (k = 0; k < nvisit; k++) {                          /* loop thru lines */
+    i = rd ? rd->visit[k] : k;
     lp = mp->ldsc + i;                                  /* get line desc */
     if (!(lp->sock || lp->serport || lp->loopback) || 
         !(lp->rcve))                                    /* skip if not connected */
@@ -1917,35 +2284,59 @@ for (i = 0; i < mp->lines; i++) {                       /* loop thru lines */
         lp->rxbpi = lp->rxbpi + nbytes;                 /* adv pointers */
         lp->rxcnt = lp->rxcnt + nbytes;
 
-/* Examine new data, remove TELNET cruft before making input available */
+/* Examine new data, remove TELNET cruft before making input available.
+
+   The data is compacted in place in a single pass: "j" indexes the next
+   received character and "keep" the slot for the next character retained, so
+   removing negotiation bytes costs nothing beyond the scan itself.
+*/
 
         if (!lp->notelnet) {                            /* Are we looking for telnet interpretation? */
-            for (; j < lp->rxbpi; ) {                   /* loop thru char */
+            int32 keep = j;                             /* keep position */
+            int32 end = lp->rxbpi;                      /* end of new data */
+            int32 span;
+
+#define TN_KEEP(n) {                                    /* keep n chars from j */   \
+            if (keep != j) {                            /* anything removed yet? */ \
+                memmove (&lp->rxb[keep], &lp->rxb[j], n);                           \
+                memmove (&lp->rbr[keep], &lp->rbr[j], n);                           \
+                }                                                                   \
+            j = j + (n);                                                            \
+            keep = keep + (n);                                                      \
+            }
+
+            while ((j < end) &&                         /* loop thru char */
+                   (lp->rxbpi == end)) {                /* unless line was reset */
                 u_char tmp = (u_char)lp->rxb[j];        /* get char */
                 switch (lp->tsta) {                     /* case tlnt state */
 
                 case TNS_NORM:                          /* normal */
                     if (tmp == TN_IAC) {                /* IAC? */
                         lp->tsta = TNS_IAC;             /* change state */
-                        tmxr_rmvrc (lp, j);             /* remove char */
+                        j = j + 1;                      /* remove char */
                         break;
                         }
-                    if ((tmp == TN_CR) && lp->dstb)     /* CR, no bin */
+                    if ((tmp == TN_CR) && lp->dstb) {   /* CR, no bin */
                         lp->tsta = TNS_CRPAD;           /* skip pad char */
-                    j = j + 1;                          /* advance j */
+                        TN_KEEP (1);
+                        break;
+                        }
+                    span = 1 + tmxr_tn_span (lp, j + 1, end);/* char and plain data after it */
+                    TN_KEEP (span);
                     break;
 
                 case TNS_IAC:                           /* IAC prev */
                     if (tmp == TN_IAC) {                /* IAC + IAC */
                         lp->tsta = TNS_NORM;            /* treat as normal */
-                        j = j + 1;                      /* advance j */
-                        break;                          /* keep IAC */
+                        TN_KEEP (1);                    /* keep IAC */
+                        break;
                         }
                     if (tmp == TN_BRK) {                /* IAC + BRK? */
                         lp->tsta = TNS_NORM;            /* treat as normal */
-                        lp->rxb[j] = 0;                 /* char is null */
-                        lp->rbr[j] = 1;                 /* flag break */
+                        lp->rxb[keep] = 0;              /* char is null */
+                        lp->rbr[keep] = 1;              /* flag break */
                         j = j + 1;                      /* advance j */
+                        keep = keep + 1;
                         break;
                         }
                     switch (tmp) {
@@ -1973,7 +2364,7 @@ for (i = 0; i < mp->lines; i++) {                       /* loop thru lines */
                         lp->tsta = TNS_NORM;            /* ignore */
                         break;
                         }
-                    tmxr_rmvrc (lp, j);                 /* remove char */
+                    j = j + 1;                          /* remove char */
                     break;
 
                 case TNS_WILL:                          /* IAC+WILL prev */
@@ -2030,7 +2421,7 @@ for (i = 0; i < mp->lines; i++) {                       /* loop thru lines */
                             lp->dstb = 1;
                             }
                         }
-                    tmxr_rmvrc (lp, j);                 /* remove it */
+                    j = j + 1;                          /* remove it */
                     lp->tsta = TNS_NORM;                /* next normal */
                     break;
 
@@ -2052,7 +2443,7 @@ for (i = 0; i < mp->lines; i++) {                       /* loop thru lines */
                     lp->tsta = TNS_NORM;                /* next normal */
                     if ((tmp == TN_LF) ||               /* CR + LF ? */
                         (tmp == TN_NUL))                /* CR + NUL? */
-                        tmxr_rmvrc (lp, j);             /* remove it */
+                        j = j + 1;                      /* remove it */
                     break;
 
                 case TNS_DO:                            /* pending DO request */
@@ -2102,22 +2493,54 @@ for (i = 0; i < mp->lines; i++) {                       /* loop thru lines */
                         }
                     /* fall through */
                 case TNS_SKIP: default:                 /* skip char */
-                    tmxr_rmvrc (lp, j);                 /* remove char */
+                    j = j + 1;                          /* remove char */
                     lp->tsta = TNS_NORM;                /* next normal */
                     break;
                     }                                   /* end case state */
                 }                                       /* end for char */
+#undef TN_KEEP
+            if (lp->rxbpi == end) {                     /* line still intact? */
+                memset (&lp->rbr[keep], 0, end - keep); /* clear breaks from vacated slots */
+                lp->rxbpi = keep;                       /* drop buffer insert index */
+                }
             if (nbytes != (lp->rxbpi-lp->rxbpr)) {
                 tmxr_debug (TMXR_DBG_RCV, lp, "Remaining", &(lp->rxb[lp->rxbpr]), lp->rxbpi-lp->rxbpr);
                 }
             }
         }                                               /* end else nbytes */
     }                                                   /* end for lines */
-for (i = 0; i < mp->lines; i++) {                       /* loop thru lines */
-    lp = mp->ldsc + i;                                  /* get line desc */
+for (k = 0; k < nvisit; k++) {                          /* loop thru lines */
+    lp = mp->ldsc + (rd ? rd->visit[k] : k);            /* get line desc */
     if (lp->rxbpi == lp->rxbpr)                         /* if buf empty, */
         lp->rxbpi = lp->rxbpr = 0;                      /* reset pointers */
     }                                                   /* end for */
+if (rd)
+    tmxr_ready_rx_update (mp, rd);                      /* record lines with input */
+}
+
+/* Return the lines with input awaiting the device
+
+   Inputs:
+        *mp     =       pointer to terminal multiplexer descriptor
+        **lines =       pointer to receive the line number list
+   Outputs:
+        count of lines in the list, or -1 if the caller must check every line
+
+   The list is rebuilt by each tmxr_poll_rx and holds, in order of arrival,
+   each line whose receive buffer or SEND input is not empty.  A line whose
+   receive speed limit is delaying the next character remains listed even
+   though tmxr_rqln reports nothing available yet.
+*/
+
+int32 tmxr_rx_ready_lines (TMXR *mp, const int32 **lines)
+{
+struct tmxr_ready *rd = tmxr_ready_get (mp);
+
+*lines = NULL;
+if ((rd == NULL) || rd->stale)
+    return -1;
+*lines = rd->rx;
+return rd->nrx;
 }
 
 
@@ -2174,6 +2597,7 @@ if ((lp->conn == FALSE) &&                              /* no conn & not buffere
     return SCPE_LOST;
     }
 tmxr_debug_trace_line (lp, "tmxr_putc_ln()");
+tmxr_ready_tx (lp);                                     /* poll_tx must visit line */
 #define TXBUF_AVAIL(lp) ((lp->serport ? 2: lp->txbsz) - tmxr_tqln (lp))
 #define TXBUF_CHAR(lp, c) {                               \
     lp->txb[lp->txbpi++] = (char)(c);                     \
@@ -2278,13 +2702,21 @@ return (lp->conn || lp->loopback) ? SCPE_OK : SCPE_LOST;
 
 void tmxr_poll_tx (TMXR *mp)
 {
-int32 i, nbytes;
+int32 k, ntx, nbytes;
 TMLN *lp;
 double sim_gtime_now = sim_gtime ();
+struct tmxr_ready *rd = tmxr_ready_get (mp);
 
 tmxr_debug_trace (mp, "tmxr_poll_tx()");
-for (i = 0; i < mp->lines; i++) {                       /* loop thru lines */
-    lp = mp->ldsc + i;                                  /* get line desc */
+if (rd) {
+    if (rd->stale)
+        tmxr_ready_rescan (mp, rd);
+    ntx = rd->ntx;                                      /* only lines with output activity */
+    }
+else
+    ntx = mp->lines;
+for (k = 0; k < ntx; k++) {                             /* loop thru lines */
+    lp = mp->ldsc + (rd ? rd->tx[k] : k);               /* get line desc */
     if ((!lp->conn) && (!lp->txbfd))                    /* skip if !conn and !buffered */
         continue;
     nbytes = tmxr_send_buffered_data (lp);              /* buffered bytes */
@@ -2302,6 +2734,8 @@ for (i = 0; i < mp->lines; i++) {                       /* loop thru lines */
             lp->xmte = 1;                               /* enable line transmit */
         }
     }                                                   /* end for */
+if (rd)
+    tmxr_ready_tx_update (mp, rd);
 }
 
 
@@ -3824,8 +4258,10 @@ for (i=0; i<tmxr_open_device_count; ++i)
             return r;
         if (lp)
             *lp = &tmxr_open_devices[i]->ldsc[line];
-        if (snd)
+        if (snd) {
             *snd = &tmxr_open_devices[i]->ldsc[line].send;
+            tmxr_ready_stale (&tmxr_open_devices[i]->ldsc[line]);/* SEND input may arrive */
+            }
         if (exp)
             *exp = &tmxr_open_devices[i]->ldsc[line].expect;
         return SCPE_OK;
@@ -4167,6 +4603,7 @@ if (mp->master)
 mp->master = 0;
 free (mp->port);
 mp->port = NULL;
+tmxr_ready_free (mp);
 if (mp->ring_sock != INVALID_SOCKET) {
     sim_close_sock (mp->ring_sock);
     mp->ring_sock = INVALID_SOCKET;
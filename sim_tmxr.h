@@ -229,6 +229,7 @@ struct tmxr {
     t_bool              port_speed_control;             /* multiplexer programmatically sets port speed */
     t_bool              packet;                         /* Lines are packet oriented */
     t_bool              datagram;                       /* Lines use datagram packet transport */
+    struct tmxr_ready   *ready;                         /* line readiness tracking - private */
     };
 
 int32 tmxr_poll_conn (TMXR *mp);
@@ -239,6 +240,7 @@ int32 tmxr_getc_ln (TMLN *lp);
 t_stat tmxr_get_packet_ln (TMLN *lp, const uint8 **pbuf, size_t *psize);
 t_stat tmxr_get_packet_ln_ex (TMLN *lp, const uint8 **pbuf, size_t *psize, uint8 frame_byte);
 void tmxr_poll_rx (TMXR *mp);
+int32 tmxr_rx_ready_lines (TMXR *mp, const int32 **lines);
 t_stat tmxr_putc_ln (TMLN *lp, int32 chr);
 t_stat tmxr_put_packet_ln (TMLN *lp, const uint8 *buf, size_t size);
 t_stat tmxr_put_packet_ln_ex (TMLN *lp, const uint8 *buf, size_t size, uint8 frame_byte);